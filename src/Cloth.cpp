@@ -4,15 +4,29 @@
 
 #include "Cloth.h"
 
+#include "IO/Checkpoint.h"
+#include "IO/MeshLoader.h"
+#include "Integrators/DormandPrinceIntegrator.h"
 #include "Integrators/ExplicitEulerIntegrator.h"
+#include "Integrators/ImplicitEulerIntegrator.h"
+#include "Integrators/ProjectiveDynamicsIntegrator.h"
 #include "Integrators/RK4Integrator.h"
 #include "Integrators/VerletIntegrator.h"
+#include "Integrators/XPBDIntegrator.h"
+#include "Tasks/TaskScheduler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstring>
+#include <limits>
+#include <numeric>
 
 Cloth::Cloth()
     : numX(0), numY(0), totalPoints(0), spacing(0.2f), mass(1.0f), gravity(0.f, -0.00981f, 0.f),
       maxSpeed(20.0f), structureSpringConstant(75.0f), structureDamperConstant(0.5f),
       shearSpringConstant(50.0f), shearDamperConstant(0.3f), bendingSpringConstant(10.0f),
-      bendingDamperConstant(0.1f) {}
+      bendingDamperConstant(0.1f), forceKernel(getSpringForceKernel()) {}
 
 Cloth::Cloth(uint32_t numX, uint32_t numY, float spacing) : Cloth() { init(numX, numY, spacing); }
 
@@ -20,29 +34,20 @@ void Cloth::init(uint32_t numX, uint32_t numY, float spacing) {
 	this->numX = numX;
 	this->numY = numY;
 	this->spacing = spacing;
-	totalPoints = (numX + 1) * (numY + 1);
-
-	// Clear any existing data
-	particles.clear();
-	springs.clear();
-	X.clear();
-	V.clear();
+	fromMesh = false;
+	resetTopology((numX + 1) * (numY + 1));
 
 	// 1) Create grid of Particles
-	particles.resize(totalPoints);
-	X.resize(totalPoints);
-	V.resize(totalPoints);
 	for (uint32_t y = 0; y <= numY; y++) {
 		for (uint32_t x = 0; x <= numX; x++) {
 			// index in 1D array
 			int idx = y * (numX + 1) + x;
 
-			Particle &p = particles[idx];
 			// place cloth in the XZ plane, at Y=0
-			p.pos = glm::vec3(x * spacing, 0.0f, -static_cast<float>(y) * spacing);
-			p.velocity = glm::vec3(0.0f);
-			p.forceAccumulator = glm::vec3(0.0f);
-			p.mass = mass; // use the cloth's mass field
+			particles.positions.set(
+			    idx, glm::vec3(x * spacing, 0.0f, -static_cast<float>(y) * spacing));
+			particles.velocities.set(idx, glm::vec3(0.0f));
+			particles.inverseMass[idx] = inverseMassOf(idx); // use the cloth's mass field
 		}
 	}
 
@@ -99,6 +104,153 @@ void Cloth::init(uint32_t numX, uint32_t numY, float spacing) {
 			addSpring(i1, i2, Spring::SpringType::BEND);
 		}
 	}
+
+	// 5) Two triangles per grid cell, split along the p00-p11 diagonal as rendered
+	triangles.reserve(size_t(numX) * numY * 6);
+	for (uint32_t row = 0; row < numY; row++) {
+		for (uint32_t col = 0; col < numX; col++) {
+			uint32_t p00 = row * (numX + 1) + col;
+			uint32_t p10 = p00 + 1;
+			uint32_t p01 = p00 + (numX + 1);
+			uint32_t p11 = p01 + 1;
+			triangles.insert(triangles.end(), {p00, p10, p11, p00, p11, p01});
+		}
+	}
+
+	// 6) The corners, as laid out above: top-left, top-right, bottom-left, bottom-right
+	uint32_t bottomLeft = numY * (numX + 1);
+	cornerParticles[0] = 0;
+	cornerParticles[1] = numX;
+	cornerParticles[2] = bottomLeft;
+	cornerParticles[3] = bottomLeft + numX;
+
+	finishTopology();
+}
+
+void Cloth::init(const TriangleMesh &mesh) {
+	numX = numY = 0;
+	fromMesh = true;
+	resetTopology(uint32_t(mesh.positions.size()));
+
+	// 1) Particles at the mesh vertices
+	for (uint32_t i = 0; i < totalPoints; i++) {
+		particles.positions.set(i, mesh.positions[i]);
+		particles.velocities.set(i, glm::vec3(0.0f));
+		particles.inverseMass[i] = inverseMassOf(i);
+	}
+	triangles = mesh.triangles;
+
+	// 2) Every triangle edge, keyed by its particles (lower index first), with the corner across
+	// the triangle from it. Sorting brings the triangles sharing an edge together.
+	struct HalfEdge {
+		uint64_t key;
+		uint32_t opposite;
+	};
+	auto edgeKey = [](uint32_t a, uint32_t b) {
+		return a < b ? uint64_t(a) << 32 | b : uint64_t(b) << 32 | a;
+	};
+	std::vector<HalfEdge> halfEdges;
+	halfEdges.reserve(triangles.size());
+	for (size_t t = 0; t + 2 < triangles.size(); t += 3) {
+		uint32_t a = triangles[t], b = triangles[t + 1], c = triangles[t + 2];
+		halfEdges.push_back({edgeKey(a, b), c});
+		halfEdges.push_back({edgeKey(b, c), a});
+		halfEdges.push_back({edgeKey(c, a), b});
+	}
+	std::sort(halfEdges.begin(), halfEdges.end(), [](const HalfEdge &x, const HalfEdge &y) {
+		return x.key < y.key || (x.key == y.key && x.opposite < y.opposite);
+	});
+	auto isEdge = [&](uint64_t key) {
+		auto it = std::lower_bound(halfEdges.begin(), halfEdges.end(), key,
+		                           [](const HalfEdge &e, uint64_t k) { return e.key < k; });
+		return it != halfEdges.end() && it->key == key;
+	};
+
+	// 3) A structure spring along each edge, and a bend spring across each edge shared by exactly
+	// two triangles, between their opposite corners. Edges shared by more triangles (non-manifold)
+	// get no bend spring, since it is unclear which pairs of faces should resist folding.
+	std::vector<uint64_t> bends;
+	for (size_t e = 0; e < halfEdges.size();) {
+		size_t run = e + 1;
+		while (run < halfEdges.size() && halfEdges[run].key == halfEdges[e].key)
+			run++;
+		uint64_t key = halfEdges[e].key;
+		addSpring(int(key >> 32), int(uint32_t(key)), Spring::SpringType::STRUCTURE);
+		if (run - e == 2) {
+			uint32_t a = halfEdges[e].opposite, b = halfEdges[e + 1].opposite;
+			if (a != b && !isEdge(edgeKey(a, b)))
+				bends.push_back(edgeKey(a, b));
+		}
+		e = run;
+	}
+	std::sort(bends.begin(), bends.end());
+	bends.erase(std::unique(bends.begin(), bends.end()), bends.end());
+	for (uint64_t key : bends) {
+		addSpring(int(key >> 32), int(uint32_t(key)), Spring::SpringType::BEND);
+	}
+
+	// 4) The corners of the mesh's bounding box, seen the way the grid is laid out: up is y
+	// unless the mesh is flat in y (a sheet lying down), in which case it is z, and across is
+	// whichever other axis the mesh spans more of
+	glm::vec3 lower(std::numeric_limits<float>::max()), upper(-std::numeric_limits<float>::max());
+	for (const glm::vec3 &p : mesh.positions) {
+		lower = glm::min(lower, p);
+		upper = glm::max(upper, p);
+	}
+	glm::vec3 extent = upper - lower;
+	int up = extent.y >= std::min(extent.x, extent.z) ? 1 : 2;
+	int across = up == 1 ? (extent.x >= extent.z ? 0 : 2) : 0;
+	float scores[4] = {-std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(),
+	                   -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max()};
+	std::fill(std::begin(cornerParticles), std::end(cornerParticles), 0u);
+	for (uint32_t i = 0; i < totalPoints; i++) {
+		const glm::vec3 &p = mesh.positions[i];
+		float u = extent[across] > 0.0f ? (p[across] - lower[across]) / extent[across] : 0.0f;
+		float v = extent[up] > 0.0f ? (p[up] - lower[up]) / extent[up] : 0.0f;
+		const float corner[4] = {v - u, v + u, -v - u, u - v};
+		for (int c = 0; c < 4; c++) {
+			if (corner[c] > scores[c]) {
+				scores[c] = corner[c];
+				cornerParticles[c] = i;
+			}
+		}
+	}
+
+	finishTopology();
+}
+
+void Cloth::resetTopology(uint32_t particleCount) {
+	totalPoints = particleCount;
+
+	// Clear any existing data
+	particles.clear();
+	springs.clear();
+	triangles.clear();
+	previousSpeeds.clear();
+	stability = StabilityReport{};
+	trianglePatches.clear();
+	particleSprings.clear();
+	particleTriangles.clear();
+	incidenceBuilt = false;
+	tornSpringCount = splitParticleCount = 0;
+
+	particles.resize(totalPoints);
+	pinned.assign(totalPoints, false);
+}
+
+void Cloth::finishTopology() {
+	// Partition springs into conflict-free batches for the parallel force pass
+	buildSpringColors();
+
+	// Block sparsity of the implicit system matrices, refilled in place every step
+	springPattern.build(particles.size(), springData.p1.data(), springData.p2.data(),
+	                    springData.size());
+	springPatternStale = false;
+
+	particleSources.resize(totalPoints);
+	std::iota(particleSources.begin(), particleSources.end(), 0u);
+	topologyVersion++;
+	meshVersion++;
 }
 
 //------------------------------------
@@ -115,28 +267,47 @@ void Cloth::pinCorners(PinMode mode) {
 
 	switch (mode) {
 	case PinMode::NONE:
-		return;
+		break;
 	case PinMode::FOUR_CORNERS:
-		if (numX > 0 && numY > 0) {
-			// top-left => index 0
-			pinned[0] = true;
-			// top-right => numX
-			pinned[numX] = true;
-			// bottom-left => row = numY => idx= numY*(numX+1)
-			int bl = numY * (numX + 1);
-			pinned[bl] = true;
-			// bottom-right => bl + numX
-			pinned[bl + numX] = true;
+		if (totalPoints > 0) {
+			for (uint32_t corner : cornerParticles) {
+				pinned[corner] = true;
+			}
 		}
 		break;
 	case PinMode::TOP_CORNERS:
-		pinned[0] = true;
-		pinned[numX] = true;
+		if (totalPoints > 0) {
+			pinned[cornerParticles[0]] = true;
+			pinned[cornerParticles[1]] = true;
+		}
 		break;
 	}
+
+	// Pinned particles are held in place: no motion and no response to forces
+	for (size_t i = 0; i < particles.size(); i++) {
+		if (pinned[i])
+			particles.velocities.set(i, glm::vec3(0.0f));
+		particles.inverseMass[i] = inverseMassOf(i);
+	}
+	topologyVersion++;
+}
+
+void Cloth::setMass(float m) {
+	mass = m;
+	for (size_t i = 0; i < particles.size(); i++) {
+		particles.inverseMass[i] = inverseMassOf(i);
+	}
+	parameterVersion++;
+}
+
+float Cloth::inverseMassOf(size_t i) const {
+	if ((i < pinned.size() && pinned[i]) || mass <= 0.0f)
+		return 0.0f;
+	return 1.0f / mass;
 }
 
 void Cloth::setIntegrator(IntegrationMethod method){
+	integrationMethod = method;
 	switch (method) {
 	case IntegrationMethod::EXPLICIT_EULER:
 		integrator = std::move(std::make_unique<ExplicitEulerIntegrator>());
@@ -147,6 +318,18 @@ void Cloth::setIntegrator(IntegrationMethod method){
 	case IntegrationMethod::VERLET:
 		integrator = std::move(std::make_unique<VerletIntegrator>());
 		break;
+	case IntegrationMethod::IMPLICIT_EULER:
+		integrator = std::move(std::make_unique<ImplicitEulerIntegrator>(*this));
+		break;
+	case IntegrationMethod::XPBD:
+		integrator = std::move(std::make_unique<XPBDIntegrator>(*this));
+		break;
+	case IntegrationMethod::PROJECTIVE_DYNAMICS:
+		integrator = std::move(std::make_unique<ProjectiveDynamicsIntegrator>(*this));
+		break;
+	case IntegrationMethod::DORMAND_PRINCE:
+		integrator = std::move(std::make_unique<DormandPrinceIntegrator>(*this));
+		break;
 	}
 }
 
@@ -173,7 +356,7 @@ void Cloth::addSpring(int p1Index, int p2Index, Spring::SpringType type) {
 	s.p2 = p2Index;
 
 	// Compute rest length from the difference of the two Particles' positions
-	glm::vec3 dp = particles[p1Index].pos - particles[p2Index].pos;
+	glm::vec3 dp = particles.positions.get(p1Index) - particles.positions.get(p2Index);
 	s.restLength = glm::length(dp);
 	s.currentLength = s.restLength;
 
@@ -181,6 +364,308 @@ void Cloth::addSpring(int p1Index, int p2Index, Spring::SpringType type) {
 	springs.push_back(s);
 }
 
+void Cloth::buildSpringColors() {
+	const uint32_t noColor = UINT32_MAX;
+	size_t numParticles = particles.size();
+
+	// Springs incident to each particle (CSR)
+	std::vector<uint32_t> incidentOffsets(numParticles + 1, 0);
+	for (const auto &s : springs) {
+		incidentOffsets[s.p1 + 1]++;
+		incidentOffsets[s.p2 + 1]++;
+	}
+	for (size_t i = 0; i < numParticles; i++) {
+		incidentOffsets[i + 1] += incidentOffsets[i];
+	}
+	std::vector<uint32_t> incident(incidentOffsets.back());
+	std::vector<uint32_t> cursor(incidentOffsets.begin(), incidentOffsets.end() - 1);
+	for (uint32_t s = 0; s < springs.size(); s++) {
+		incident[cursor[springs[s].p1]++] = s;
+		incident[cursor[springs[s].p2]++] = s;
+	}
+
+	// Greedy coloring: each spring takes the lowest color not used by a spring sharing an endpoint.
+	// colorStamp[c] == s marks color c as taken for spring s.
+	std::vector<uint32_t> colors(springs.size(), noColor);
+	std::vector<uint32_t> colorStamp;
+	uint32_t colorCount = 0;
+	for (uint32_t s = 0; s < springs.size(); s++) {
+		for (int p : {springs[s].p1, springs[s].p2}) {
+			for (uint32_t k = incidentOffsets[p]; k < incidentOffsets[p + 1]; k++) {
+				uint32_t c = colors[incident[k]];
+				if (c != noColor)
+					colorStamp[c] = s;
+			}
+		}
+
+		uint32_t c = 0;
+		while (c < colorCount && colorStamp[c] == s)
+			c++;
+		if (c == colorCount) {
+			colorCount++;
+			colorStamp.push_back(noColor);
+		}
+		colors[s] = c;
+	}
+
+	// Counting sort of springs by color, keeping the build order within a color
+	springColorOffsets.assign(colorCount + 1, 0);
+	for (uint32_t c : colors) {
+		springColorOffsets[c + 1]++;
+	}
+	for (uint32_t c = 0; c < colorCount; c++) {
+		springColorOffsets[c + 1] += springColorOffsets[c];
+	}
+	std::vector<Spring> sorted(springs.size());
+	std::vector<uint32_t> slot(springColorOffsets.begin(), springColorOffsets.end() - 1);
+	for (uint32_t s = 0; s < springs.size(); s++) {
+		sorted[slot[colors[s]]++] = springs[s];
+	}
+	springs.swap(sorted);
+
+	syncSpringArrays();
+}
+
+void Cloth::syncSpringArrays() {
+	springData.resize(springs.size());
+	tearLengths.resize(springs.size());
+	for (size_t k = 0; k < springs.size(); k++) {
+		const Spring &s = springs[k];
+		springData.p1[k] = s.p1;
+		springData.p2[k] = s.p2;
+		springData.restLength[k] = s.restLength;
+		springData.springConstant[k] = s.springConstant;
+		springData.damperConstant[k] = s.damperConstant;
+		tearLengths[k] = s.restLength * tearRatios[int(s.type)];
+	}
+}
+
+const BlockSparsePattern &Cloth::getSpringPattern() const {
+	if (springPatternStale) {
+		springPattern.build(particles.size(), springData.p1.data(), springData.p2.data(),
+		                    springData.size());
+		springPatternStale = false;
+	}
+	return springPattern;
+}
+
+namespace {
+
+// Everything in a checkpoint that is not an array. Changing it needs a new
+// CheckpointFormat::version.
+struct CheckpointParameters {
+	uint32_t numX, numY, totalPoints, particleCount;
+	uint32_t cornerParticles[4];
+	uint32_t fromMesh;
+	int32_t integrationMethod; // -1 without an integrator
+	int32_t solverIterations;
+	float errorTolerance;
+	float spacing, mass, maxSpeed;
+	float gravity[3];
+	float springConstants[3], damperConstants[3], tearRatios[3]; // structure, shear, bend
+	float collisionThickness;
+	uint8_t selfCollision, continuousCollision, tearing, vectorizedForces;
+	uint8_t deterministic, assembledSystemProduct;
+	uint8_t reserved[2]; // keeps stepCount aligned without padding, so files are reproducible
+	uint64_t stepCount;
+};
+
+} // namespace
+
+bool Cloth::saveCheckpoint(const std::string &path) const {
+	CheckpointParameters parameters{};
+	parameters.numX = numX;
+	parameters.numY = numY;
+	parameters.totalPoints = totalPoints;
+	parameters.particleCount = uint32_t(particles.size());
+	std::copy(std::begin(cornerParticles), std::end(cornerParticles), parameters.cornerParticles);
+	parameters.fromMesh = fromMesh;
+	parameters.integrationMethod = integrator ? int32_t(integrationMethod) : -1;
+	parameters.solverIterations = solverIterations;
+	parameters.errorTolerance = errorTolerance;
+	parameters.spacing = spacing;
+	parameters.mass = mass;
+	parameters.maxSpeed = maxSpeed;
+	std::memcpy(parameters.gravity, &gravity[0], sizeof(parameters.gravity));
+	const float springConstants[3] = {structureSpringConstant, shearSpringConstant,
+	                                  bendingSpringConstant};
+	const float damperConstants[3] = {structureDamperConstant, shearDamperConstant,
+	                                  bendingDamperConstant};
+	std::copy(springConstants, springConstants + 3, parameters.springConstants);
+	std::copy(damperConstants, damperConstants + 3, parameters.damperConstants);
+	std::copy(tearRatios, tearRatios + 3, parameters.tearRatios);
+	parameters.collisionThickness = collisionThickness;
+	parameters.selfCollision = selfCollisionEnabled;
+	parameters.continuousCollision = continuousCollisionEnabled;
+	parameters.tearing = tearingEnabled;
+	parameters.vectorizedForces = vectorizedForces;
+	parameters.deterministic = deterministic;
+	parameters.assembledSystemProduct = assembledSystemProduct;
+	parameters.stepCount = stepCount;
+
+	std::vector<uint8_t> pinnedFlags(pinned.begin(), pinned.end());
+
+	CheckpointWriter writer;
+	writer.addValue(CheckpointSection::PARAMETERS, parameters);
+	writer.add(CheckpointSection::POSITIONS, particles.positions);
+	writer.add(CheckpointSection::VELOCITIES, particles.velocities);
+	writer.add(CheckpointSection::INVERSE_MASS, particles.inverseMass);
+	writer.add(CheckpointSection::PINNED, pinnedFlags);
+	writer.add(CheckpointSection::SPRINGS, springs);
+	writer.add(CheckpointSection::SPRING_COLOR_OFFSETS, springColorOffsets);
+	writer.add(CheckpointSection::TRIANGLES, triangles);
+	writer.add(CheckpointSection::PARTICLE_SOURCES, particleSources);
+	if (integrator)
+		integrator->saveState(writer);
+
+	if (!writer.write(path)) {
+		std::cerr << "Cannot save checkpoint: " << writer.getError() << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool Cloth::loadCheckpoint(const std::string &path) {
+	CheckpointReader reader;
+	if (!reader.open(path)) {
+		std::cerr << "Cannot load checkpoint: " << reader.getError() << std::endl;
+		return false;
+	}
+	auto fail = [&](const char *reason) {
+		std::cerr << "Cannot load checkpoint " << path << ": " << reason << std::endl;
+		return false;
+	};
+
+	// 1) Check everything before touching the cloth
+	const CheckpointParameters *parameters =
+	    reader.getValue<CheckpointParameters>(CheckpointSection::PARAMETERS);
+	if (!parameters)
+		return fail("no parameters");
+	const size_t N = parameters->particleCount;
+	if (parameters->integrationMethod > int32_t(IntegrationMethod::DORMAND_PRINCE))
+		return fail("unknown integrator");
+	for (uint32_t corner : parameters->cornerParticles) {
+		if (N > 0 && corner >= N)
+			return fail("corner out of range");
+	}
+
+	size_t inverseMassCount = 0, pinnedCount = 0, springCount = 0, offsetCount = 0,
+	       triangleCount = 0, sourceCount = 0, axisCount = 0;
+	const float *inverseMass = reader.get<float>(CheckpointSection::INVERSE_MASS, inverseMassCount);
+	const uint8_t *pinnedFlags = reader.get<uint8_t>(CheckpointSection::PINNED, pinnedCount);
+	const Spring *savedSprings = reader.get<Spring>(CheckpointSection::SPRINGS, springCount);
+	const uint32_t *colorOffsets =
+	    reader.get<uint32_t>(CheckpointSection::SPRING_COLOR_OFFSETS, offsetCount);
+	const uint32_t *savedTriangles =
+	    reader.get<uint32_t>(CheckpointSection::TRIANGLES, triangleCount);
+	const uint32_t *sources =
+	    reader.get<uint32_t>(CheckpointSection::PARTICLE_SOURCES, sourceCount);
+	if (!inverseMass || inverseMassCount != N || !pinnedFlags || pinnedCount != N || !sources ||
+	    sourceCount != N)
+		return fail("particle arrays missing or of the wrong size");
+	for (CheckpointSection id : {CheckpointSection::POSITIONS, CheckpointSection::VELOCITIES}) {
+		for (uint32_t axis = 0; axis < 3; axis++) {
+			if (!reader.get<float>(CheckpointSection(uint32_t(id) + axis), axisCount) ||
+			    axisCount != N)
+				return fail("particle arrays missing or of the wrong size");
+		}
+	}
+	if (!savedSprings || !colorOffsets || offsetCount == 0 || colorOffsets[0] != 0 ||
+	    colorOffsets[offsetCount - 1] != springCount ||
+	    !std::is_sorted(colorOffsets, colorOffsets + offsetCount))
+		return fail("springs missing or not grouped by color");
+	for (size_t k = 0; k < springCount; k++) {
+		const Spring &spring = savedSprings[k];
+		if (spring.p1 < 0 || size_t(spring.p1) >= N || spring.p2 < 0 || size_t(spring.p2) >= N ||
+		    int(spring.type) < 0 || int(spring.type) > int(Spring::SpringType::BEND))
+			return fail("spring out of range");
+	}
+	if (!savedTriangles || triangleCount % 3 != 0 ||
+	    std::any_of(savedTriangles, savedTriangles + triangleCount,
+	                [&](uint32_t p) { return p >= N; }) ||
+	    std::any_of(sources, sources + N, [&](uint32_t p) { return p >= N; }))
+		return fail("triangles missing or out of range");
+
+	// 2) Parameters
+	numX = parameters->numX;
+	numY = parameters->numY;
+	totalPoints = parameters->totalPoints;
+	std::copy(std::begin(parameters->cornerParticles), std::end(parameters->cornerParticles),
+	          cornerParticles);
+	fromMesh = parameters->fromMesh != 0;
+	solverIterations = parameters->solverIterations;
+	errorTolerance = parameters->errorTolerance;
+	spacing = parameters->spacing;
+	mass = parameters->mass;
+	maxSpeed = parameters->maxSpeed;
+	gravity = glm::vec3(parameters->gravity[0], parameters->gravity[1], parameters->gravity[2]);
+	structureSpringConstant = parameters->springConstants[0];
+	shearSpringConstant = parameters->springConstants[1];
+	bendingSpringConstant = parameters->springConstants[2];
+	structureDamperConstant = parameters->damperConstants[0];
+	shearDamperConstant = parameters->damperConstants[1];
+	bendingDamperConstant = parameters->damperConstants[2];
+	std::copy(parameters->tearRatios, parameters->tearRatios + 3, tearRatios);
+	collisionThickness = parameters->collisionThickness;
+	selfCollisionEnabled = parameters->selfCollision != 0;
+	continuousCollisionEnabled = parameters->continuousCollision != 0;
+	tearingEnabled = parameters->tearing != 0;
+	setVectorizedForces(parameters->vectorizedForces != 0);
+	setDeterministic(parameters->deterministic != 0);
+	assembledSystemProduct = parameters->assembledSystemProduct != 0;
+	stepCount = parameters->stepCount;
+
+	// 3) Arrays, copied straight out of the mapping. The springs keep their saved order, so the
+	// colors do not have to be computed again and the force sums add up in the same order.
+	particles.resize(N);
+	reader.copy(CheckpointSection::POSITIONS, N, particles.positions);
+	reader.copy(CheckpointSection::VELOCITIES, N, particles.velocities);
+	std::copy(inverseMass, inverseMass + N, particles.inverseMass.begin());
+	pinned.assign(pinnedFlags, pinnedFlags + N);
+	springs.assign(savedSprings, savedSprings + springCount);
+	springColorOffsets.assign(colorOffsets, colorOffsets + offsetCount);
+	syncSpringArrays();
+	springPattern.build(particles.size(), springData.p1.data(), springData.p2.data(),
+	                    springData.size());
+	springPatternStale = false;
+	triangles.assign(savedTriangles, savedTriangles + triangleCount);
+	particleSources.assign(sources, sources + N);
+
+	// 4) What is derived from the state, or only describes the steps since the last init()
+	previousSpeeds.clear();
+	stability = StabilityReport{};
+	trianglePatches.clear();
+	particleSprings.clear();
+	particleTriangles.clear();
+	incidenceBuilt = false;
+	tornSpringCount = splitParticleCount = 0;
+	stepStart.clear();
+	topologyVersion++;
+	parameterVersion++;
+	meshVersion++;
+
+	if (parameters->integrationMethod < 0) {
+		integrator.reset();
+	} else {
+		setIntegrator(IntegrationMethod(parameters->integrationMethod));
+		if (!integrator->restoreState(reader, N))
+			std::cerr << "Checkpoint " << path << ": integrator state ignored, it does not fit "
+			          << "the cloth" << std::endl;
+	}
+	return true;
+}
+
+void Cloth::setVectorizedForces(bool enabled) {
+	vectorizedForces = enabled;
+	forceKernel = vectorizedForces && !deterministic ? getSpringForceKernel()
+	                                                 : accumulateSpringForcesScalar;
+}
+
+void Cloth::setDeterministic(bool enabled) {
+	deterministic = enabled;
+	setVectorizedForces(vectorizedForces);
+}
+
 //------------------------------------
 // Update cloth by dt
 //------------------------------------
@@ -188,32 +673,360 @@ void Cloth::update(float dt) {
 	if (!integrator)
 		return; // if no integrator set, skip
 
-	// 1) build local arrays X, V
-	std::vector<glm::vec3> X(particles.size()), V(particles.size());
-	for (size_t i = 0; i < particles.size(); i++) {
-		X[i] = particles[i].pos;
-		V[i] = particles[i].velocity;
+	// 1) define a lambda for computeForces
+	auto forceFunc = [this](const Vec3Array &Xarr, const Vec3Array &Varr, Vec3Array &Farr) {
+		this->computeForces(Xarr, Varr, Farr);
+	};
+
+	// 2) call integrator->integrate, which advances the particle state in place
+	strainMax.reset();
+	speedRatioMax.reset();
+	measureStrain = true;
+	if (continuousCollisionEnabled)
+		stepStart = particles.positions;
+	integrator->integrate(particles, dt, pinned, forceFunc);
+	measureStrain = false;
+
+	// 3) Tearing, before the collision passes so that they see the split cloth
+	if (tearingEnabled)
+		tear();
+
+	// 4) Self-collision, colliders, continuous collision and velocity clamp. The colliders come
+	// after self-collision, so it cannot push particles into them. The continuous check comes
+	// last and sees the final motion of the step.
+	if (selfCollisionEnabled)
+		selfCollision.resolve(*this, particles);
+	colliders.resolve(particles, collisionThickness);
+	if (continuousCollisionEnabled)
+		continuousCollision.resolve(*this, stepStart, particles, dt);
+	velocityClamp(particles.velocities);
+
+	// 5) Stability report of this step
+	SpringStrain strain = integrator->getSpringStrain();
+	strainMax.update(strain.maxRatio, strain.spring);
+	stability.maxStrain = strainMax.value();
+	stability.worstSpring = strainMax.index();
+	stability.maxSpeedRatio = speedRatioMax.value();
+	stability.worstParticle = speedRatioMax.index();
+	stepCount++;
+}
+
+const TriangleBVH &Cloth::getTriangleBVH() {
+	// Tearing renumbers triangle corners but keeps the triangles, so a refit covers it
+	if (!bvhBuilt || bvhMeshVersion != meshVersion) {
+		triangleBVH.build(triangles, particles.positions);
+		bvhBuilt = true;
+		bvhMeshVersion = meshVersion;
+		bvhStep = stepCount;
+	} else if (bvhStep != stepCount) {
+		triangleBVH.update();
+		bvhStep = stepCount;
+	}
+	return triangleBVH;
+}
+
+// Springs per task of the tear check
+static constexpr size_t tearChunkSize = 8192;
+
+void Cloth::setTearRatio(Spring::SpringType type, float ratio) {
+	tearRatios[int(type)] = ratio;
+	syncSpringArrays();
+}
+
+void Cloth::tear() {
+	tornSpringCount = splitParticleCount = 0;
+	const size_t S = springs.size();
+	if (S == 0)
+		return;
+
+	// 1) Find the broken springs; every chunk lists its own in order
+	chunkTears.resize(TaskScheduler::chunkCount(0, S, tearChunkSize));
+	TaskScheduler::get().parallelForChunks(0, S, tearChunkSize, [&](size_t chunk, size_t begin,
+	                                                                size_t end) {
+		std::vector<uint32_t> &broken = chunkTears[chunk];
+		broken.clear();
+		const Vec3Array &X = particles.positions;
+		for (size_t k = begin; k < end; k++) {
+			glm::vec3 d = X.get(springData.p1[k]) - X.get(springData.p2[k]);
+			if (glm::dot(d, d) > tearLengths[k] * tearLengths[k])
+				broken.push_back(uint32_t(k));
+		}
+	});
+	tornSprings.clear();
+	for (const std::vector<uint32_t> &broken : chunkTears) {
+		tornSprings.insert(tornSprings.end(), broken.begin(), broken.end());
+	}
+	if (tornSprings.empty())
+		return;
+
+	if (!incidenceBuilt)
+		buildIncidence();
+
+	// 2) Remove them, last first: removing a spring only moves springs that come after it
+	splitCandidates.clear();
+	for (size_t t = tornSprings.size(); t-- > 0;) {
+		const Spring &s = springs[tornSprings[t]];
+		splitCandidates.push_back(uint32_t(s.p1));
+		splitCandidates.push_back(uint32_t(s.p2));
+		removeSpring(tornSprings[t]);
+	}
+	tornSpringCount = tornSprings.size();
+
+	// 3) Split the particles that lost a spring, in index order
+	std::sort(splitCandidates.begin(), splitCandidates.end());
+	splitCandidates.erase(std::unique(splitCandidates.begin(), splitCandidates.end()),
+	                      splitCandidates.end());
+	appendedSources.clear();
+	for (uint32_t p : splitCandidates) {
+		splitParticle(p);
+	}
+	if (!appendedSources.empty())
+		integrator->appendParticles(appendedSources);
+
+	// Colors left empty are dropped. Removing springs or moving them to new particles never
+	// puts two springs of one color on the same particle, so no spring needs a new color.
+	springColorOffsets.erase(std::unique(springColorOffsets.begin(), springColorOffsets.end()),
+	                         springColorOffsets.end());
+
+	springPatternStale = true;
+	topologyVersion++;
+}
+
+void Cloth::buildIncidence() {
+	std::vector<uint32_t> rows, items;
+	rows.reserve(std::max(2 * springs.size(), triangles.size()));
+	items.reserve(rows.capacity());
+	for (uint32_t k = 0; k < springs.size(); k++) {
+		rows.insert(rows.end(), {uint32_t(springs[k].p1), uint32_t(springs[k].p2)});
+		items.insert(items.end(), {k, k});
+	}
+	particleSprings.build(particles.size(), rows.data(), items.data(), rows.size());
+
+	rows.clear();
+	items.clear();
+	for (uint32_t corner = 0; corner < triangles.size(); corner++) {
+		rows.push_back(triangles[corner]);
+		items.push_back(corner / 3);
 	}
+	particleTriangles.build(particles.size(), rows.data(), items.data(), rows.size());
+	incidenceBuilt = true;
+}
+
+void Cloth::removeSpring(uint32_t k) {
+	particleSprings.remove(uint32_t(springs[k].p1), k);
+	particleSprings.remove(uint32_t(springs[k].p2), k);
+
+	uint32_t hole = k;
+	size_t color = std::upper_bound(springColorOffsets.begin(), springColorOffsets.end(), k) -
+	               springColorOffsets.begin() - 1;
+	for (; color + 1 < springColorOffsets.size(); color++) {
+		uint32_t last = springColorOffsets[color + 1] - 1;
+		if (last != hole)
+			moveSpring(last, hole);
+		hole = last;
+		springColorOffsets[color + 1]--;
+	}
+
+	springs.pop_back();
+	springData.resize(springs.size());
+	tearLengths.pop_back();
+}
+
+void Cloth::moveSpring(uint32_t from, uint32_t to) {
+	springs[to] = springs[from];
+	springData.p1[to] = springData.p1[from];
+	springData.p2[to] = springData.p2[from];
+	springData.restLength[to] = springData.restLength[from];
+	springData.springConstant[to] = springData.springConstant[from];
+	springData.damperConstant[to] = springData.damperConstant[from];
+	tearLengths[to] = tearLengths[from];
+	particleSprings.replace(uint32_t(springs[to].p1), from, to);
+	particleSprings.replace(uint32_t(springs[to].p2), from, to);
+}
+
+bool Cloth::hasSpring(uint32_t p, uint32_t q) const {
+	for (const uint32_t *k = particleSprings.begin(p); k != particleSprings.end(p); k++) {
+		if (uint32_t(springs[*k].p1) == q || uint32_t(springs[*k].p2) == q)
+			return true;
+	}
+	return false;
+}
+
+void Cloth::splitParticle(uint32_t p) {
+	const uint32_t fanSize = particleTriangles.size(p);
+	if (fanSize == 0)
+		return;
+	fan.assign(particleTriangles.begin(p), particleTriangles.end(p));
 
-	// 2) define a lambda for computeForces
-	auto forceFunc = [this](const std::vector<glm::vec3> &Xarr,
-	                        const std::vector<glm::vec3> &Varr) -> std::vector<glm::vec3> {
-		return this->computeForces(Xarr, Varr);
+	// 1) Group the triangles around p: two of them stay together while a spring runs along
+	// their common edge p-q. fanGroups holds a union-find forest rooted at the smallest index.
+	fanGroups.resize(fanSize);
+	std::iota(fanGroups.begin(), fanGroups.end(), 0u);
+	auto findGroup = [&](uint32_t i) {
+		while (fanGroups[i] != i)
+			i = fanGroups[i] = fanGroups[fanGroups[i]];
+		return i;
 	};
+	for (uint32_t i = 0; i < fanSize; i++) {
+		const uint32_t *a = &triangles[3 * fan[i]];
+		for (uint32_t j = i + 1; j < fanSize; j++) {
+			const uint32_t *b = &triangles[3 * fan[j]];
+			for (int corner = 0; corner < 3; corner++) {
+				uint32_t q = a[corner];
+				if (q == p || (q != b[0] && q != b[1] && q != b[2]) || !hasSpring(p, q))
+					continue;
+				uint32_t rootA = findGroup(i), rootB = findGroup(j);
+				fanGroups[std::max(rootA, rootB)] = std::min(rootA, rootB);
+			}
+		}
+	}
 
-	// 3) call integrator->integrate
-	auto [Xout, Vout] = integrator->integrate(X, V, dt, mass, pinned, forceFunc);
+	// Number the groups in order of their first triangle
+	uint32_t groupCount = 0;
+	for (uint32_t i = 0; i < fanSize; i++) {
+		uint32_t root = findGroup(i);
+		fanGroups[i] = root == i ? groupCount++ : fanGroups[root];
+	}
 
-	// 4) velocity clamp
-	velocityClamp(Vout);
+	// Lowest group with a triangle touching particle q
+	auto groupTouching = [&](uint32_t q) {
+		uint32_t group = UINT32_MAX;
+		for (uint32_t i = 0; i < fanSize; i++) {
+			const uint32_t *v = &triangles[3 * fan[i]];
+			if (v[0] == q || v[1] == q || v[2] == q)
+				group = std::min(group, fanGroups[i]);
+		}
+		return group;
+	};
 
-	// 5) store them back
-	for (size_t i = 0; i < particles.size(); i++) {
-		if (!pinned[i]) {
-			particles[i].pos = Xout[i];
-			particles[i].velocity = Vout[i];
+	// 2) Every spring follows the group its other end q belongs to. Springs to particles outside
+	// the triangles around p (bend springs, and shear springs across a cell) follow the group
+	// holding a particle that shares a triangle with q. A spring with no group to follow spans
+	// the tear and breaks.
+	springMoves.clear();
+	springDrops.clear();
+	groupParticles.assign(groupCount, 0);
+	for (const uint32_t *k = particleSprings.begin(p); k != particleSprings.end(p); k++) {
+		const Spring &s = springs[*k];
+		uint32_t q = uint32_t(s.p1) == p ? uint32_t(s.p2) : uint32_t(s.p1);
+		uint32_t group = groupTouching(q);
+		if (group != UINT32_MAX)
+			groupParticles[group]++; // edge count until the particles are assigned below
+		else {
+			for (const uint32_t *t = particleTriangles.begin(q); t != particleTriangles.end(q);
+			     t++) {
+				for (int corner = 0; corner < 3; corner++) {
+					uint32_t m = triangles[3 * *t + corner];
+					if (m != q)
+						group = std::min(group, groupTouching(m));
+				}
+			}
 		}
+		if (group == UINT32_MAX)
+			springDrops.push_back(*k);
+		else
+			springMoves.insert(springMoves.end(), {*k, group});
 	}
+
+	// 3) The first group holding a spring along one of its edges keeps p, and every other one gets
+	// a new particle that takes over its triangles and springs. A group without such a spring
+	// would hang from a particle that only bend springs hold, if any, so its triangles are
+	// collapsed onto p instead, which hides them (these are the triangles the tear runs through),
+	// and its springs break.
+	bool keeperFound = false;
+	for (uint32_t group = 0; group < groupCount; group++) {
+		uint32_t edgeCount = groupParticles[group];
+		if (edgeCount == 0) {
+			groupParticles[group] = UINT32_MAX;
+		} else if (!keeperFound) {
+			groupParticles[group] = p;
+			keeperFound = true;
+		} else {
+			uint32_t triangleCount = 0, springCount = 0;
+			for (uint32_t i = 0; i < fanSize; i++) {
+				triangleCount += fanGroups[i] == group;
+			}
+			for (size_t m = 0; m < springMoves.size(); m += 2) {
+				springCount += springMoves[m + 1] == group;
+			}
+			groupParticles[group] = appendParticle(p, springCount, triangleCount);
+		}
+	}
+
+	for (uint32_t i = 0; i < fanSize; i++) {
+		uint32_t target = groupParticles[fanGroups[i]];
+		if (target == p)
+			continue;
+		const uint32_t first = 3 * fan[i];
+		if (target == UINT32_MAX) {
+			for (uint32_t corner = first; corner < first + 3; corner++) {
+				particleTriangles.remove(triangles[corner], fan[i]);
+				if (triangles[corner] != p) {
+					triangles[corner] = p;
+					trianglePatches.push_back({corner, p});
+				}
+			}
+			continue;
+		}
+		for (uint32_t corner = first; corner < first + 3; corner++) {
+			if (triangles[corner] == p) {
+				triangles[corner] = target;
+				trianglePatches.push_back({corner, target});
+			}
+		}
+		particleTriangles.remove(p, fan[i]);
+		particleTriangles.add(target, fan[i]);
+	}
+
+	for (size_t m = 0; m < springMoves.size(); m += 2) {
+		uint32_t k = springMoves[m], target = groupParticles[springMoves[m + 1]];
+		if (target == p)
+			continue;
+		if (target == UINT32_MAX) {
+			springDrops.push_back(k);
+			continue;
+		}
+		Spring &s = springs[k];
+		if (uint32_t(s.p1) == p)
+			s.p1 = springData.p1[k] = int32_t(target);
+		else
+			s.p2 = springData.p2[k] = int32_t(target);
+		particleSprings.remove(p, k);
+		particleSprings.add(target, k);
+	}
+
+	// Last first, as in tear()
+	std::sort(springDrops.begin(), springDrops.end());
+	for (size_t d = springDrops.size(); d-- > 0;) {
+		removeSpring(springDrops[d]);
+	}
+	tornSpringCount += springDrops.size();
+}
+
+uint32_t Cloth::appendParticle(uint32_t source,
+                               uint32_t springCapacity,
+                               uint32_t triangleCapacity) {
+	const uint32_t i = uint32_t(particles.size());
+	particles.resize(i + 1);
+	particles.positions.set(i, particles.positions.get(source));
+	particles.velocities.set(i, particles.velocities.get(source));
+	particles.inverseMass[i] = particles.inverseMass[source];
+	pinned.push_back(bool(pinned[source]));
+	particleSources.push_back(particleSources[source]);
+
+	// Per-particle state the rest of the step reads
+	if (previousSpeeds.size() == i)
+		previousSpeeds.push_back(previousSpeeds[source]);
+	if (continuousCollisionEnabled && stepStart.size() == i) {
+		stepStart.resize(i + 1);
+		stepStart.set(i, stepStart.get(source));
+	}
+
+	particleSprings.appendRow(springCapacity);
+	particleTriangles.appendRow(triangleCapacity);
+	appendedSources.push_back(source);
+	splitParticleCount++;
+	return i;
 }
 
 void Cloth::setStructureSpringConstant(float ks) {
@@ -224,6 +1037,8 @@ void Cloth::setStructureSpringConstant(float ks) {
 			s.springConstant = ks;
 		}
 	}
+	syncSpringArrays();
+	parameterVersion++;
 }
 
 void Cloth::setShearSpringConstant(float ks) {
@@ -234,6 +1049,8 @@ void Cloth::setShearSpringConstant(float ks) {
 			s.springConstant = ks;
 		}
 	}
+	syncSpringArrays();
+	parameterVersion++;
 }
 
 void Cloth::setBendingSpringConstant(float ks) {
@@ -244,6 +1061,8 @@ void Cloth::setBendingSpringConstant(float ks) {
 			s.springConstant = ks;
 		}
 	}
+	syncSpringArrays();
+	parameterVersion++;
 }
 
 void Cloth::setStructureDamperConstant(float kd) {
@@ -254,6 +1073,7 @@ void Cloth::setStructureDamperConstant(float kd) {
 			s.damperConstant = kd;
 		}
 	}
+	syncSpringArrays();
 }
 
 void Cloth::setShearDamperConstant(float kd) {
@@ -264,6 +1084,7 @@ void Cloth::setShearDamperConstant(float kd) {
 			s.damperConstant = kd;
 		}
 	}
+	syncSpringArrays();
 }
 
 void Cloth::setBendingDamperConstant(float kd) {
@@ -274,147 +1095,145 @@ void Cloth::setBendingDamperConstant(float kd) {
 			s.damperConstant = kd;
 		}
 	}
+	syncSpringArrays();
 }
 
 //------------------------------------
 // Compute forces: gravity + damping + spring
 //------------------------------------
-std::vector<glm::vec3> Cloth::computeForces(const std::vector<glm::vec3> &positions,
-                                            const std::vector<glm::vec3> &velocities) {
-	std::vector<glm::vec3> forceAccumulators(particles.size(), glm::vec3(0.0f));
+void Cloth::computeForces(const Vec3Array &positions,
+                          const Vec3Array &velocities,
+                          Vec3Array &forceAccumulators) {
+	TaskScheduler &scheduler = TaskScheduler::get();
+	const size_t particleGrain = 4096;
+	const size_t springChunkSize = 2048;
 
-	// 1) Zero out all force accumulators
-	for (size_t i = 0; i < forceAccumulators.size(); i++) {
-		forceAccumulators[i] = glm::vec3(0.0f);
-	}
-
-	// 2) Apply gravity
-	for (size_t i = 0; i < positions.size(); i++) {
-		if (pinned[i]) {
-			// If pinned, skip forces
-			continue;
+	// 1) Zero out all force accumulators and 2) apply gravity
+	const glm::vec3 weight = mass * gravity;
+	scheduler.parallelFor(0, positions.size(), particleGrain, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			// If pinned, skip forces; otherwise add m*g
+			forceAccumulators.set(i, pinned[i] ? glm::vec3(0.0f) : weight);
 		}
-		// add m*g
-		forceAccumulators[i] += mass * gravity;
-	}
+	});
 
 	// 3) Spring forces (STRUCTURE, SHEAR, BEND all stored in springs)
 	//    Each spring has its own damperConstant (s.damperConstant)
 
-	// "biphasic" check for super-elastic
-	const float biphasicFactor = 1.1f; // threshold
-	const float superScale = 2.0f;     // how much stiffer it becomes
-
-	for (auto &s : springs) {
-		int iA = s.p1;
-		int iB = s.p2;
-
-		// If both endpoints pinned, skip
-		if (pinned[iA] && pinned[iB]) {
-			continue;
-		}
-
-		// Current positions & velocities
-		glm::vec3 deltaP = positions[iA] - positions[iB];
-		float dist = glm::length(deltaP);
-		if (dist < 1e-7f)
-			continue;                  // avoid division by zero
-		glm::vec3 dir = deltaP / dist; // unit direction
-
-		// Hooke’s law: F_spring = -k * (dist - restLen)
-		float stretch = dist - s.restLength;
-
-		// BIPHASIC LOGIC:
-		// if dist > biphasicFactor * restLength => scale up springConstant
-		float currKs = s.springConstant;
-		// if (dist > s.restLength * biphasicFactor) {
-		// 	currKs *= superScale;
-		// }
-
-		float springForceMag = -currKs * stretch;
-
-		// Per-spring damping force along the line
-		// F_damp = c * (relative velocity dot dir)
-		glm::vec3 relVel = velocities[iA] - velocities[iB];
-		float dampingMag = s.damperConstant * glm::dot(relVel, dir);
-
-		// Net spring force
-		glm::vec3 force = (springForceMag + dampingMag) * dir;
-
-		// Accumulate force on each particle (skip if pinned)
-		if (!pinned[iA])
-			forceAccumulators[iA] += force;
-		if (!pinned[iB])
-			forceAccumulators[iB] -= force;
+	// Springs of one color never share a particle, so each color is scattered in parallel
+	// without atomics; the colors themselves run one after another, so every particle adds up
+	// its forces in the same order. The per-spring math is done by the fastest kernel the CPU
+	// supports (see Kernels/SpringForceKernel.h). The chunks are fixed and a multiple of every
+	// SIMD width, so the same springs fall into the kernels' scalar remainders whatever the
+	// thread count.
+	for (uint32_t c = 0; c < getSpringColorCount(); c++) {
+		scheduler.parallelForChunks(springColorOffsets[c], springColorOffsets[c + 1],
+		                            springChunkSize, [&](size_t, size_t begin, size_t end) {
+			SpringStrain strain;
+			forceKernel(springData, begin, end, positions, velocities,
+			            particles.inverseMass.data(), forceAccumulators, strain);
+			if (measureStrain)
+				strainMax.update(strain.maxRatio, strain.spring);
+		});
 	}
-
-	return forceAccumulators;
+	measureStrain = false;
 }
 
-bool Cloth::isSpringLengthUnstable() {
-	const float MAX_EXTENSION_RATIO = 3.0f; // Springs stretched to 3x their rest length
+// Springs stretched to 3x their rest length
+static constexpr float maxExtensionRatio = 3.0f;
 
-	for (auto &spring : springs) {
-		glm::vec3 deltaP = particles[spring.p1].pos - particles[spring.p2].pos;
-		spring.currentLength = glm::length(deltaP);
+// Speed growing 5x from one step to the next, for particles moving faster than minTrackedSpeed
+static constexpr float maxVelocityChangeRatio = 5.0f;
+static constexpr float minTrackedSpeed = 0.01f;
 
-		if (spring.currentLength > spring.restLength * MAX_EXTENSION_RATIO) {
-			return true;
-		}
-	}
-	return false;
-}
-
-bool Cloth::isVelocityUnstable() {
-	// For comparing with previous frame
-	static std::vector<glm::vec3> previousVelocities;
-	static bool firstFrame = true;
-	const float MAX_VELOCITY_CHANGE_RATIO = 5.0f;
+bool Cloth::isSpringLengthUnstable() const { return stability.maxStrain > maxExtensionRatio; }
 
-	// Initialize previous velocities if needed
-	if (firstFrame || previousVelocities.size() != particles.size()) {
-		previousVelocities.resize(particles.size());
-		for (size_t i = 0; i < particles.size(); i++) {
-			previousVelocities[i] = particles[i].velocity;
-		}
-		firstFrame = false;
-		return false;
-	}
+bool Cloth::isVelocityUnstable() const {
+	return stability.maxSpeedRatio > maxVelocityChangeRatio;
+}
 
-	// Check for instability
-	for (size_t i = 0; i < particles.size(); i++) {
-		// Skip pinned particles
-		if (pinned.size() > i && pinned[i])
-			continue;
+bool Cloth::isUnstable() const { return isSpringLengthUnstable() && isVelocityUnstable(); }
 
-		const glm::vec3 &v = particles[i].velocity;
-		float speed = glm::length(v);
+void Cloth::velocityClamp(Vec3Array &velocities) {
+	// The speed ratio against the previous step is tracked in the same pass
+	bool tracked = previousSpeeds.size() == velocities.size();
+	previousSpeeds.resize(velocities.size());
 
-		// Relative change check
-		glm::vec3 prevV = previousVelocities[i];
-		float prevSpeed = glm::length(prevV);
+	// Fixed chunks, so ties in the speed ratio go to the same particle whatever the thread count
+	TaskScheduler::get().parallelForChunks(0, velocities.size(), 4096, [&](size_t,
+	                                                                       size_t begin,
+	                                                                       size_t end) {
+		float maxRatio = 0.0f;
+		int32_t worst = -1;
+		for (size_t i = begin; i < end; i++) {
+			glm::vec3 v = velocities.get(i);
+			float speed = glm::length(v);
+			if (speed > maxSpeed) {
+				velocities.set(i, v * (maxSpeed / speed));
+				speed = maxSpeed;
+			}
 
-		if (prevSpeed > 0.01f) { // Only if previous velocity was significant
-			float changeRatio = speed / prevSpeed;
-			if (changeRatio > MAX_VELOCITY_CHANGE_RATIO) {
-				return true;
+			if (tracked && !pinned[i] && previousSpeeds[i] > minTrackedSpeed) {
+				float ratio = speed / previousSpeeds[i];
+				if (!(ratio <= maxRatio)) {
+					maxRatio = std::isnan(ratio) ? INFINITY : ratio;
+					worst = int32_t(i);
+				}
 			}
+			previousSpeeds[i] = speed;
 		}
-	}
+		speedRatioMax.update(maxRatio, worst);
+	});
+}
 
-	// Update previous velocities for next frame
-	for (size_t i = 0; i < particles.size(); i++) {
-		previousVelocities[i] = particles[i].velocity;
+static constexpr size_t stateHashChunkSize = 16384;
+
+// 64-bit FNV-1a over 32-bit words rather than bytes
+template <typename T> static uint64_t hashWords(uint64_t hash, const T *values, size_t count) {
+	static_assert(sizeof(T) == sizeof(uint32_t));
+	for (size_t i = 0; i < count; i++) {
+		hash = (hash ^ std::bit_cast<uint32_t>(values[i])) * 0x100000001B3ull;
 	}
+	return hash;
+}
 
-	return false;
+// Final mix of splitmix64, so every input bit reaches every output bit
+static uint64_t mixHash(uint64_t hash) {
+	hash = (hash ^ (hash >> 30)) * 0xBF58476D1CE4E5B9ull;
+	hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EBull;
+	return hash ^ (hash >> 31);
 }
 
-void Cloth::velocityClamp(std::vector<glm::vec3> &velocities) {
-	for (size_t i = 0; i < V.size(); i++) {
-		float speed = glm::length(velocities[i]);
-		if (speed > maxSpeed) {
-			velocities[i] *= (maxSpeed / speed);
+uint64_t Cloth::computeStateHash() const {
+	// Each fixed chunk is hashed on its own and the chunk hashes are chained in order, so the
+	// hash is the same whatever the thread count
+	TaskScheduler &scheduler = TaskScheduler::get();
+	const size_t N = particles.size(), S = springData.size();
+	std::vector<uint64_t> particleHashes(TaskScheduler::chunkCount(0, N, stateHashChunkSize));
+	std::vector<uint64_t> springHashes(TaskScheduler::chunkCount(0, S, stateHashChunkSize));
+	scheduler.parallelForChunks(0, N, stateHashChunkSize, [&](size_t chunk,
+	                                                          size_t begin,
+	                                                          size_t end) {
+		uint64_t hash = 0xCBF29CE484222325ull;
+		for (int axis = 0; axis < 3; axis++) {
+			hash = hashWords(hash, particles.positions.component(axis) + begin, end - begin);
+			hash = hashWords(hash, particles.velocities.component(axis) + begin, end - begin);
 		}
+		particleHashes[chunk] = hashWords(hash, particles.inverseMass.data() + begin, end - begin);
+	});
+	scheduler.parallelForChunks(0, S, stateHashChunkSize, [&](size_t chunk,
+	                                                          size_t begin,
+	                                                          size_t end) {
+		uint64_t hash = hashWords(0xCBF29CE484222325ull, springData.p1.data() + begin, end - begin);
+		springHashes[chunk] = hashWords(hash, springData.p2.data() + begin, end - begin);
+	});
+
+	uint64_t hash = mixHash(N) ^ mixHash(S + 1);
+	for (uint64_t chunkHash : particleHashes) {
+		hash = mixHash(hash ^ chunkHash);
+	}
+	for (uint64_t chunkHash : springHashes) {
+		hash = mixHash(hash ^ chunkHash);
 	}
+	return hash;
 }
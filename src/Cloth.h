@@ -5,18 +5,24 @@
 #ifndef CLOTH_H
 #define CLOTH_H
 
+#include "Collision/ColliderSet.h"
+#include "Collision/ContinuousCollision.h"
+#include "Collision/SelfCollision.h"
+#include "Collision/TriangleBVH.h"
 #include "Integrators/Integrator.h"
+#include "Kernels/SpringForceKernel.h"
+#include "Math/BlockSparseMatrix.h"
+#include "ParticleState.h"
+#include "Utilities/IncidenceLists.h"
+#include "Utilities/IndexedMax.h"
 
 #include <glm/glm.hpp>
 #include <iostream>
+#include <memory>
+#include <string>
 #include <vector>
 
-struct Particle {
-	glm::vec3 pos;
-	glm::vec3 velocity;
-	glm::vec3 forceAccumulator;
-	float mass;
-};
+struct TriangleMesh;
 
 struct Spring {
 	// The indices of particles
@@ -42,7 +48,13 @@ class Cloth {
 
 	void init(uint32_t numX, uint32_t numY, float spacing);
 
-	const std::vector<Particle> &getParticles() const { return particles; };
+	// Builds the cloth from an arbitrary triangle mesh: a particle per vertex, a structure spring
+	// along each edge, and a bend spring across each edge shared by two triangles, joining the
+	// corners opposite it. The mesh should already be welded (see weldVertices()).
+	void init(const TriangleMesh &mesh);
+
+	// Read-only view of the particle state (positions, velocities, inverse masses)
+	const ParticleState &getParticles() const { return particles; };
 
 	// Step the cloth simulation by dt
 	void update(float dt);
@@ -59,7 +71,9 @@ class Cloth {
 	void setMaxSpeed(float mv) { maxSpeed = mv; };
 
 	void setGravity(const glm::vec3 &g) { gravity = g; }
-	void setMass(float m) { mass = m; }
+	const glm::vec3 &getGravity() const { return gravity; }
+	void setMass(float m);
+	float getMass() const { return mass; }
 
 	enum class PinMode {
 		NONE,
@@ -67,42 +81,257 @@ class Cloth {
 		TOP_CORNERS,
 	};
 
+	// A mesh's corners are the vertices furthest out towards the corners of its bounding box
 	void pinCorners(PinMode mode);
 
-	uint32_t getClothWidth() const { return numX + 1; }
-	uint32_t getClothHeight() const { return numY + 1; }
+	// Whether the cloth is a grid; the grid size in particles is 0 x 0 for a mesh
+	bool isGrid() const { return !fromMesh; }
+	uint32_t getClothWidth() const { return fromMesh ? 0 : numX + 1; }
+	uint32_t getClothHeight() const { return fromMesh ? 0 : numY + 1; }
 
 	enum class IntegrationMethod {
 		EXPLICIT_EULER = 0,
 		RUNGE_KUTTA = 1,
-		VERLET = 2
+		VERLET = 2,
+		IMPLICIT_EULER = 3,
+		XPBD = 4,
+		PROJECTIVE_DYNAMICS = 5,
+		DORMAND_PRINCE = 6
 	};
 
 	void setIntegrator(IntegrationMethod method);
+	IntegrationMethod getIntegrationMethod() const { return integrationMethod; }
+
+	// Constraint projection sweeps (XPBD) or local/global iterations (projective dynamics) per step
+	void setSolverIterations(int iterations) { solverIterations = iterations; }
+	int getSolverIterations() const { return solverIterations; }
+
+	// Local error tolerance of the adaptive integrator, relative to 1 + |position| and
+	// 1 + |velocity| per component
+	void setErrorTolerance(float tolerance) { errorTolerance = tolerance; }
+	float getErrorTolerance() const { return errorTolerance; }
+
+	// Implicit Euler: multiply with the assembled block sparse system matrix in the conjugate
+	// gradient solve, instead of spring by spring (the default, which streams less memory)
+	void setAssembledSystemProduct(bool assembled) { assembledSystemProduct = assembled; }
+	bool usesAssembledSystemProduct() const { return assembledSystemProduct; }
+
+	// The active integrator, for solver statistics
+	const Integrator *getIntegrator() const { return integrator.get(); }
+
+	// Stability measurements of the last update(). They are reductions folded into passes the
+	// step makes anyway: the strain comes from the spring force kernels at the start of the step
+	// (or from the spring passes of XPBD and projective dynamics), the speed ratio from the
+	// velocity clamp. Reading them costs nothing.
+	struct StabilityReport {
+		float maxStrain = 0.0f;     // largest spring length / rest length
+		int32_t worstSpring = -1;   // index into getSprings()
+		float maxSpeedRatio = 0.0f; // largest speed / speed of the previous step
+		int32_t worstParticle = -1;
+	};
+	const StabilityReport &getStabilityReport() const { return stability; }
+
+	bool isSpringLengthUnstable() const;
+
+	bool isVelocityUnstable() const;
+
+	// Unstable when the springs are overstretched and the velocities jump at the same time
+	bool isUnstable() const;
+
+	// Self-collision between particles, and between particles and triangles, keeping them at
+	// least the collision thickness apart
+	void setSelfCollision(bool enabled) { selfCollisionEnabled = enabled; }
+	bool isSelfCollisionEnabled() const { return selfCollisionEnabled; }
+	void setCollisionThickness(float thickness) { collisionThickness = thickness; }
+	float getCollisionThickness() const { return collisionThickness; }
+
+	// Self-collision contacts of the last update(); a particle-particle contact counts once for
+	// each of its particles
+	size_t getSelfContactCount() const {
+		return selfCollisionEnabled ? selfCollision.getContactCount() : 0;
+	}
+
+	// Continuous self-collision: the motion of every step is checked for particles crossing
+	// triangles and edges crossing edges, and colliding regions are moved rigidly instead, so
+	// large steps and fast motion cannot make the cloth pass through itself
+	void setContinuousCollision(bool enabled) { continuousCollisionEnabled = enabled; }
+	bool isContinuousCollisionEnabled() const { return continuousCollisionEnabled; }
+	const ContinuousCollision &getContinuousCollision() const { return continuousCollision; }
+
+	// Impacts found by the continuous check of the last update()
+	size_t getContinuousImpactCount() const {
+		return continuousCollisionEnabled ? continuousCollision.getImpactCount() : 0;
+	}
+
+	// Tearing: after integration, every spring stretched past its type's tear ratio (length over
+	// rest length) breaks. A particle whose triangles are no longer all joined by springs is then
+	// split, one copy for each group of its triangles that still is, so the cloth opens along the
+	// tear; triangles the tear runs through are collapsed to a point. Springs are removed in place
+	// and keep their colors, and the triangles are patched in place (see getTrianglePatches()),
+	// so tearing never rebuilds the cloth.
+	void setTearing(bool enabled) { tearingEnabled = enabled; }
+	bool isTearingEnabled() const { return tearingEnabled; }
+	void setTearRatio(Spring::SpringType type, float ratio);
+	float getTearRatio(Spring::SpringType type) const { return tearRatios[int(type)]; }
+
+	// Springs broken and particles added by the last update()
+	size_t getTornSpringCount() const { return tearingEnabled ? tornSpringCount : 0; }
+	size_t getSplitParticleCount() const { return tearingEnabled ? splitParticleCount : 0; }
+
+	// For each particle, the particle of the untorn cloth it was split from (itself if it was
+	// never split). Features with a common source were joined before the tear.
+	const std::vector<uint32_t> &getParticleSources() const { return particleSources; }
+
+	// Triangle corner rewritten by tearing: getTriangles()[corner] became particle
+	struct TrianglePatch {
+		uint32_t corner;
+		uint32_t particle;
+	};
 
-	bool isSpringLengthUnstable();
-
-	bool isVelocityUnstable();
+	// Every triangle patch since init(), in order, so a copy of the triangles taken after init()
+	// is kept up to date by applying the patches it has not seen yet
+	const std::vector<TrianglePatch> &getTrianglePatches() const { return trianglePatches; }
+
+	// Bumped by init() and loadCheckpoint(), which replace the triangles; tearing only patches
+	// them
+	uint64_t getMeshVersion() const { return meshVersion; }
+
+	// Checkpoints hold the particles, the springs in their color order, the pins, the triangles,
+	// the parameters and the integrator's state, so a run resumes exactly where it was saved.
+	// Colliders are part of the scene rather than the cloth and are not saved, and the stability
+	// history, the tear counts and the triangle patches start over. Both return false and write
+	// the reason to std::cerr on failure; a failed load leaves the cloth as it was.
+	bool saveCheckpoint(const std::string &path) const;
+	bool loadCheckpoint(const std::string &path);
+
+	// Analytic shapes (planes, spheres, capsules, boxes) the cloth drapes over. They are resolved
+	// after self-collision and keep the particles the collision thickness away from their surfaces.
+	ColliderSet &getColliders() { return colliders; }
+	const ColliderSet &getColliders() const { return colliders; }
+
+	// Particle-collider contacts of the last update()
+	size_t getColliderContactCount() const { return colliders.getContactCount(); }
+
+	// Bounding volume hierarchy over getTriangles() at the current positions, for collision and
+	// picking queries. It is built on first use after each init() and refitted (or
+	// rebuilt, once refitting has degraded it) on first use after each step, so steps that never
+	// query it pay nothing.
+	const TriangleBVH &getTriangleBVH();
+
+	// Nearest triangle hit by the ray origin + t * direction for t in [0, maxDistance]
+	TriangleBVH::RayHit raycast(const glm::vec3 &origin,
+	                            const glm::vec3 &direction,
+	                            float maxDistance = INFINITY) {
+		return getTriangleBVH().raycast(origin, direction, maxDistance);
+	}
+
+	// Use the SIMD spring force kernel when the CPU supports it, or force the scalar reference
+	void setVectorizedForces(bool enabled);
+	const char *getForceKernelName() const { return getSpringForceKernelName(forceKernel); }
+
+	// A step never depends on the thread count: parallel work is split into fixed chunks whose
+	// partial results are combined in chunk order, and each particle sums its spring forces in
+	// the fixed order of the spring colors. What still differs between machines is the SIMD
+	// force kernel, which rounds differently from the scalar one and only runs where the CPU
+	// supports it. Deterministic mode evaluates the springs with the scalar kernel whatever
+	// setVectorizedForces() asked for. The rest of the step only uses correctly rounded
+	// operations (see Math/PortableMath.h) and loomix_core is compiled without FMA contraction,
+	// so a run reproduces bit for bit on any thread count and on any x86-64 or AArch64 machine.
+	void setDeterministic(bool enabled);
+	bool isDeterministic() const { return deterministic; }
+
+	// 64-bit hash of the bits of the particle state (positions, velocities and inverse masses)
+	// and of the springs' particles, for comparing runs frame by frame
+	uint64_t computeStateHash() const;
+
+	// Springs are grouped by color; no two springs of one color share a particle
+	uint32_t getSpringColorCount() const {
+		return springColorOffsets.empty() ? 0 : uint32_t(springColorOffsets.size() - 1);
+	}
+	const std::vector<uint32_t> &getSpringColorOffsets() const { return springColorOffsets; }
+
+	// Net force (gravity, springs and dampers) on every particle for the given state
+	void computeForces(const Vec3Array &positions, const Vec3Array &velocities, Vec3Array &forces);
+
+	// Topology and parameters for integrators that need more than the net force. Tearing removes
+	// springs and moves others to fill the gaps, so spring indices only hold for one step.
+	const std::vector<Spring> &getSprings() const { return springs; }
+	const SpringArrays &getSpringArrays() const { return springData; }
+
+	// Three particle indices per triangle, two triangles per grid cell (or the mesh's triangles)
+	// as they are rendered
+	const std::vector<uint32_t> &getTriangles() const { return triangles; }
+
+	// 3x3 block sparsity of the spring system matrices, built in init(). Only the implicit solvers
+	// and self-collision read it, so a step that tears the cloth just marks it stale, and it is
+	// rebuilt on first use afterwards.
+	const BlockSparsePattern &getSpringPattern() const;
+
+	// Bumped when the springs or the pinned set change (init, pinCorners, tearing), and when the
+	// spring constants or the mass change, so integrators can tell when a cached system is stale
+	uint64_t getTopologyVersion() const { return topologyVersion; }
+	uint64_t getParameterVersion() const { return parameterVersion; }
 
   private:
 	// Helper methods
+	// The parts of init() shared by grids and meshes: clearing the old cloth, and building the
+	// spring colors, the sparsity pattern and the versions once the springs are in
+	void resetTopology(uint32_t particleCount);
+	void finishTopology();
+
 	void addSpring(int p1Index, int p2Index, Spring::SpringType type);
 
-	std::vector<glm::vec3> computeForces(const std::vector<glm::vec3> &positions,
-	                                     const std::vector<glm::vec3> &velocities);
+	// Greedy graph coloring of the springs, then regroup them so each color is contiguous
+	void buildSpringColors();
+
+	// Refresh the SoA spring parameters read by the force kernels, and the tear lengths
+	void syncSpringArrays();
+
+	// Breaks the overstretched springs and splits the particles around them
+	void tear();
+
+	// Springs and triangles around each particle, for tearing
+	void buildIncidence();
+
+	// Removes springs[k] and keeps every color contiguous: the last spring of k's color fills
+	// the hole, which leaves a hole at the end of that color. It becomes the first slot of the
+	// next color, whose last spring fills it in turn, and so on up to the end of the array. Only
+	// springs after k move, one per color.
+	void removeSpring(uint32_t k);
+	void moveSpring(uint32_t from, uint32_t to);
 
-	void velocityClamp(std::vector<glm::vec3> &velocities);
+	// Whether a spring joins particles p and q
+	bool hasSpring(uint32_t p, uint32_t q) const;
+
+	// Gives each group of p's triangles that is still joined across springs its own particle,
+	// and collapses the groups no spring holds onto p
+	void splitParticle(uint32_t p);
+
+	// Appends a copy of particle source with room for the given incidence
+	uint32_t appendParticle(uint32_t source, uint32_t springCapacity, uint32_t triangleCapacity);
+
+	void velocityClamp(Vec3Array &velocities);
+
+	// Inverse mass of particle i given the current mass and pin state
+	float inverseMassOf(size_t i) const;
 
   private:
 	// Grid resolution
 	uint32_t numX, numY;
 	uint32_t totalPoints;
+	bool fromMesh = false;
+
+	// Top-left, top-right, bottom-left and bottom-right, for pinCorners()
+	uint32_t cornerParticles[4] = {0, 0, 0, 0};
 
 	// Cloth geometry
 	float spacing;
 	float mass; // each node's mass
 	glm::vec3 gravity;
 	float maxSpeed;
+	int solverIterations = 10;
+	float errorTolerance = 1e-3f;
+	bool assembledSystemProduct = false;
 
 	float structureSpringConstant;
 	float shearSpringConstant;
@@ -115,12 +344,76 @@ class Cloth {
 	std::vector<bool> pinned;
 
 	// Particles and Springs
-	std::vector<Particle> particles;
+	ParticleState particles;
 	std::vector<Spring> springs;
-	std::vector<glm::vec3> X; // positions
-	std::vector<glm::vec3> V; // velocities
+
+	// Color c spans springs[springColorOffsets[c], springColorOffsets[c + 1]). Springs of one color
+	// touch disjoint particles, so a color can be evaluated in parallel without write conflicts.
+	std::vector<uint32_t> springColorOffsets;
+
+	std::vector<uint32_t> triangles;
+
+	// SoA mirror of springs for the force kernels
+	SpringArrays springData;
+	SpringForceKernel forceKernel;
+	bool vectorizedForces = true, deterministic = false;
+
+	// Edge k of the pattern is springs[k]; a cache rebuilt by getSpringPattern() after a tear
+	mutable BlockSparsePattern springPattern;
+	mutable bool springPatternStale = false;
 
 	std::unique_ptr<Integrator> integrator;
+	IntegrationMethod integrationMethod = IntegrationMethod::EXPLICIT_EULER;
+
+	uint64_t topologyVersion = 0;
+	uint64_t parameterVersion = 0;
+
+	SelfCollision selfCollision;
+	bool selfCollisionEnabled = false;
+	float collisionThickness = 0.02f;
+
+	ColliderSet colliders;
+
+	// Positions at the start of the step, kept while continuous collision is on
+	ContinuousCollision continuousCollision;
+	bool continuousCollisionEnabled = false;
+	Vec3Array stepStart;
+
+	// Steps taken by update(), and the mesh and step the triangle BVH was last fitted to
+	TriangleBVH triangleBVH;
+	uint64_t stepCount = 0;
+	bool bvhBuilt = false;
+	uint64_t bvhMeshVersion = 0, bvhStep = 0;
+
+	// Tearing. Each spring tears at tearLengths[k], its rest length times its type's ratio.
+	bool tearingEnabled = false;
+	float tearRatios[3] = {1.5f, 1.75f, 2.0f}; // structure, shear, bend
+	AlignedVector<float> tearLengths;
+	size_t tornSpringCount = 0, splitParticleCount = 0;
+	std::vector<uint32_t> particleSources;
+	std::vector<TrianglePatch> trianglePatches;
+	uint64_t meshVersion = 0;
+
+	// Spring indices and triangle indices around each particle, built by the first tear after
+	// init() and edited in place from then on
+	bool incidenceBuilt = false;
+	IncidenceLists particleSprings, particleTriangles;
+
+	// Tearing scratch: broken springs per chunk, then in order; the particles to check for a
+	// split; the sources of the particles added this step; and the triangle groups of one split
+	// with the particle each group ends up on
+	std::vector<std::vector<uint32_t>> chunkTears;
+	std::vector<uint32_t> tornSprings, splitCandidates, appendedSources;
+	std::vector<uint32_t> fan, fanGroups, groupParticles, springMoves, springDrops;
+
+	// Stability monitoring: running maxima filled during the step, the report of the last step,
+	// and each particle's speed after the previous step (empty until the first step). Only the
+	// first force evaluation of a step feeds strainMax: it is the one at the committed positions,
+	// while later ones (RK4 and RK45 stages) see trial positions that may never be taken.
+	IndexedMax strainMax, speedRatioMax;
+	bool measureStrain = false;
+	StabilityReport stability;
+	AlignedVector<float> previousSpeeds;
 };
 
 #endif // CLOTH_H
@@ -0,0 +1,260 @@
+//
+// Created by Leonard Chan on 10/15/26.
+//
+
+#include "ColliderSet.h"
+
+#include "../Tasks/TaskScheduler.h"
+
+#include <algorithm>
+#include <cmath>
+
+static constexpr size_t particleChunkSize = 2048;
+
+// Particles per culling block; their signed distances live on the stack
+static constexpr size_t blockSize = 256;
+
+static bool overlaps(const glm::vec3 &lowerA,
+                     const glm::vec3 &upperA,
+                     const glm::vec3 &lowerB,
+                     const glm::vec3 &upperB) {
+	return lowerA.x <= upperB.x && lowerA.y <= upperB.y && lowerA.z <= upperB.z &&
+	       lowerB.x <= upperA.x && lowerB.y <= upperA.y && lowerB.z <= upperA.z;
+}
+
+// Minimum and maximum of x[begin, end). A single running minimum is a serial dependency chain
+// the compiler may not reorder, so the block is reduced in independent lanes that vectorize.
+static float minMax(const float *x, size_t begin, size_t end, float &maximum) {
+	constexpr size_t lanes = 8;
+	float low[lanes], high[lanes];
+	for (size_t l = 0; l < lanes; l++) {
+		low[l] = high[l] = x[begin];
+	}
+	size_t i = begin;
+	for (; i + lanes <= end; i += lanes) {
+		for (size_t l = 0; l < lanes; l++) {
+			low[l] = std::min(low[l], x[i + l]);
+			high[l] = std::max(high[l], x[i + l]);
+		}
+	}
+	for (; i < end; i++) {
+		low[0] = std::min(low[0], x[i]);
+		high[0] = std::max(high[0], x[i]);
+	}
+	maximum = *std::max_element(high, high + lanes);
+	return *std::min_element(low, low + lanes);
+}
+
+void ColliderSet::addPlane(const glm::vec3 &normal, float offset) {
+	float length = glm::length(normal);
+	planes.push_back({normal / length, offset / length});
+}
+
+void ColliderSet::addSphere(const glm::vec3 &center, float radius) {
+	spheres.push_back({center, radius});
+}
+
+void ColliderSet::addCapsule(const glm::vec3 &a, const glm::vec3 &b, float radius) {
+	glm::vec3 axis = b - a;
+	float length2 = glm::dot(axis, axis);
+	capsules.push_back({a, axis, radius, length2 > 0.0f ? 1.0f / length2 : 0.0f,
+	                    glm::min(a, b) - glm::vec3(radius), glm::max(a, b) + glm::vec3(radius)});
+}
+
+void ColliderSet::addBox(const glm::vec3 &center,
+                         const glm::mat3 &rotation,
+                         const glm::vec3 &halfExtents) {
+	glm::vec3 extent = glm::abs(rotation[0]) * halfExtents.x +
+	                   glm::abs(rotation[1]) * halfExtents.y +
+	                   glm::abs(rotation[2]) * halfExtents.z;
+	boxes.push_back({center, rotation, halfExtents, center - extent, center + extent});
+}
+
+void ColliderSet::clear() {
+	planes.clear();
+	spheres.clear();
+	capsules.clear();
+	boxes.clear();
+}
+
+template <typename Distance, typename Contact>
+uint32_t ColliderSet::resolveBlock(ParticleState &state,
+                                   size_t begin,
+                                   size_t end,
+                                   float thickness,
+                                   Distance &&distance,
+                                   Contact &&contact) const {
+	const float *x = state.positions.x.data(), *y = state.positions.y.data(),
+	            *z = state.positions.z.data();
+	const float *invMass = state.inverseMass.data();
+
+	float distances[blockSize];
+	for (size_t i = begin; i < end; i++) {
+		distances[i - begin] = distance(x[i], y[i], z[i]);
+	}
+
+	uint32_t contacts = 0;
+	for (size_t i = begin; i < end; i++) {
+		if (!(distances[i - begin] < thickness) || invMass[i] == 0.0f)
+			continue;
+		glm::vec3 p = state.positions.get(i), v = state.velocities.get(i), normal;
+		float d = contact(p, normal);
+		if (!(d < thickness))
+			continue;
+		respond(p, v, normal, thickness - d);
+		state.positions.set(i, p);
+		state.velocities.set(i, v);
+		contacts++;
+	}
+	return contacts;
+}
+
+void ColliderSet::respond(glm::vec3 &p,
+                          glm::vec3 &v,
+                          const glm::vec3 &normal,
+                          float depth) const {
+	p += depth * normal;
+
+	float normalSpeed = glm::dot(v, normal);
+	if (normalSpeed >= 0.0f)
+		return;
+
+	// Reflect the approaching normal velocity, and take friction times that change off the
+	// tangential velocity without reversing it
+	glm::vec3 tangential = v - normalSpeed * normal;
+	float normalChange = -(1.0f + restitution) * normalSpeed;
+	float tangentialSpeed = glm::length(tangential);
+	if (tangentialSpeed > 0.0f)
+		tangential *= std::max(0.0f, 1.0f - friction * normalChange / tangentialSpeed);
+	v = tangential - restitution * normalSpeed * normal;
+}
+
+void ColliderSet::resolve(ParticleState &state, float thickness) {
+	const size_t N = state.size();
+	contactCount = 0;
+	if (N == 0 || empty())
+		return;
+
+	chunkContacts.resize(TaskScheduler::chunkCount(0, N, particleChunkSize));
+	TaskScheduler::get().parallelForChunks(0, N, particleChunkSize, [&](size_t chunk,
+	                                                                    size_t chunkBegin,
+	                                                                    size_t chunkEnd) {
+		uint32_t contacts = 0;
+		for (size_t begin = chunkBegin; begin < chunkEnd; begin += blockSize) {
+			const size_t end = std::min(begin + blockSize, chunkEnd);
+
+			// Bounds of the block, grown by the thickness
+			glm::vec3 lower, upper;
+			for (int axis = 0; axis < 3; axis++) {
+				lower[axis] = minMax(state.positions.component(axis), begin, end, upper[axis]) -
+				              thickness;
+				upper[axis] += thickness;
+			}
+			const glm::vec3 center = 0.5f * (lower + upper), halfSize = 0.5f * (upper - lower);
+
+			for (const Plane &plane : planes) {
+				// Lowest point of the block bounds along the normal
+				if (glm::dot(plane.normal, center) - glm::dot(glm::abs(plane.normal), halfSize) >=
+				    plane.offset)
+					continue;
+				const glm::vec3 n = plane.normal;
+				contacts += resolveBlock(
+				    state, begin, end, thickness,
+				    [&](float x, float y, float z) {
+					    return n.x * x + n.y * y + n.z * z - plane.offset;
+				    },
+				    [&](const glm::vec3 &p, glm::vec3 &normal) {
+					    normal = n;
+					    return glm::dot(n, p) - plane.offset;
+				    });
+			}
+
+			for (const Sphere &sphere : spheres) {
+				const glm::vec3 c = sphere.center;
+				if (!overlaps(lower, upper, c - glm::vec3(sphere.radius),
+				              c + glm::vec3(sphere.radius)))
+					continue;
+				contacts += resolveBlock(
+				    state, begin, end, thickness,
+				    [&](float x, float y, float z) {
+					    float dx = x - c.x, dy = y - c.y, dz = z - c.z;
+					    return std::sqrt(dx * dx + dy * dy + dz * dz) - sphere.radius;
+				    },
+				    [&](const glm::vec3 &p, glm::vec3 &normal) {
+					    glm::vec3 d = p - c;
+					    float length = glm::length(d);
+					    normal = length > 0.0f ? d / length : glm::vec3(0.0f, 1.0f, 0.0f);
+					    return length - sphere.radius;
+				    });
+			}
+
+			for (const Capsule &capsule : capsules) {
+				if (!overlaps(lower, upper, capsule.lower, capsule.upper))
+					continue;
+				const glm::vec3 a = capsule.a, axis = capsule.axis;
+				contacts += resolveBlock(
+				    state, begin, end, thickness,
+				    [&](float x, float y, float z) {
+					    float dx = x - a.x, dy = y - a.y, dz = z - a.z;
+					    float t = std::clamp((dx * axis.x + dy * axis.y + dz * axis.z) *
+					                             capsule.inverseLength2,
+					                         0.0f, 1.0f);
+					    dx -= t * axis.x;
+					    dy -= t * axis.y;
+					    dz -= t * axis.z;
+					    return std::sqrt(dx * dx + dy * dy + dz * dz) - capsule.radius;
+				    },
+				    [&](const glm::vec3 &p, glm::vec3 &normal) {
+					    float t = std::clamp(glm::dot(p - a, axis) * capsule.inverseLength2, 0.0f,
+					                         1.0f);
+					    glm::vec3 d = p - (a + t * axis);
+					    float length = glm::length(d);
+					    normal = length > 0.0f ? d / length : glm::vec3(0.0f, 1.0f, 0.0f);
+					    return length - capsule.radius;
+				    });
+			}
+
+			for (const Box &box : boxes) {
+				if (!overlaps(lower, upper, box.lower, box.upper))
+					continue;
+				const glm::vec3 c = box.center, h = box.halfExtents;
+				const glm::vec3 u = box.rotation[0], v = box.rotation[1], w = box.rotation[2];
+				contacts += resolveBlock(
+				    state, begin, end, thickness,
+				    [&](float x, float y, float z) {
+					    float dx = x - c.x, dy = y - c.y, dz = z - c.z;
+					    float qx = std::abs(u.x * dx + u.y * dy + u.z * dz) - h.x;
+					    float qy = std::abs(v.x * dx + v.y * dy + v.z * dz) - h.y;
+					    float qz = std::abs(w.x * dx + w.y * dy + w.z * dz) - h.z;
+					    float ox = std::max(qx, 0.0f), oy = std::max(qy, 0.0f),
+					          oz = std::max(qz, 0.0f);
+					    return std::sqrt(ox * ox + oy * oy + oz * oz) +
+					           std::min(std::max(qx, std::max(qy, qz)), 0.0f);
+				    },
+				    [&](const glm::vec3 &p, glm::vec3 &normal) {
+					    glm::vec3 d = p - c;
+					    glm::vec3 local(glm::dot(u, d), glm::dot(v, d), glm::dot(w, d));
+					    glm::vec3 q = glm::abs(local) - h;
+					    glm::vec3 sign(local.x < 0.0f ? -1.0f : 1.0f, local.y < 0.0f ? -1.0f : 1.0f,
+					                   local.z < 0.0f ? -1.0f : 1.0f);
+					    glm::vec3 outside = glm::max(q, glm::vec3(0.0f));
+					    float length = glm::length(outside);
+					    if (length > 0.0f) {
+						    outside = outside * sign / length;
+						    normal = box.rotation * outside;
+						    return length;
+					    }
+					    // Inside: leave through the nearest face
+					    int axis = q.x >= q.y && q.x >= q.z ? 0 : q.y >= q.z ? 1 : 2;
+					    normal = box.rotation[axis] * sign[axis];
+					    return q[axis];
+				    });
+			}
+		}
+		chunkContacts[chunk] = contacts;
+	});
+
+	for (uint32_t contacts : chunkContacts) {
+		contactCount += contacts;
+	}
+}
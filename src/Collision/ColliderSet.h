@@ -0,0 +1,105 @@
+//
+// Created by Leonard Chan on 10/15/26.
+//
+
+#ifndef COLLIDERSET_H
+#define COLLIDERSET_H
+
+#include "../ParticleState.h"
+
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vector>
+
+// Static analytic shapes the cloth collides with: infinite planes, spheres, capsules and oriented
+// boxes. resolve() runs after integration and keeps every free particle at least the collision
+// thickness outside each shape. A contact moves the particle out along the surface normal,
+// reflects the approaching normal velocity scaled by the restitution, and reduces the tangential
+// velocity by the friction coefficient times the normal velocity change (Coulomb friction, which
+// brings sliding particles to rest).
+//
+// Particles are processed in blocks of consecutive indices, which are spatially coherent on a
+// cloth. Each block is culled against the bounds of every shape, so shapes far from a block cost
+// one box test. For the shapes that survive, the signed distances of the whole block are computed
+// by one branch-free loop over the SoA positions, which the compiler vectorizes; only the
+// particles it finds in contact take the scalar response path. Shapes are applied in order, each
+// seeing the corrections of the previous ones, and blocks are independent, so the result does not
+// depend on the thread count.
+class ColliderSet {
+  public:
+	// Half-space dot(normal, p) < offset is solid; the normal is normalized on insertion
+	void addPlane(const glm::vec3 &normal, float offset);
+	void addSphere(const glm::vec3 &center, float radius);
+	// Segment from a to b swept by a sphere of the given radius
+	void addCapsule(const glm::vec3 &a, const glm::vec3 &b, float radius);
+	// Box with the given half extents along the columns of rotation (orthonormal)
+	void addBox(const glm::vec3 &center, const glm::mat3 &rotation, const glm::vec3 &halfExtents);
+
+	void clear();
+	bool empty() const {
+		return planes.empty() && spheres.empty() && capsules.empty() && boxes.empty();
+	}
+	size_t size() const { return planes.size() + spheres.size() + capsules.size() + boxes.size(); }
+
+	// Fraction of the normal velocity change removed from the tangential velocity
+	void setFriction(float friction) { this->friction = friction; }
+	float getFriction() const { return friction; }
+
+	// Fraction of the approaching normal velocity kept after a contact (0 = inelastic)
+	void setRestitution(float restitution) { this->restitution = restitution; }
+	float getRestitution() const { return restitution; }
+
+	// Pushes the particles with a nonzero inverse mass out of every shape
+	void resolve(ParticleState &state, float thickness);
+
+	// Particle-shape contacts found by the last resolve()
+	size_t getContactCount() const { return contactCount; }
+
+  private:
+	struct Plane {
+		glm::vec3 normal;
+		float offset;
+	};
+	struct Sphere {
+		glm::vec3 center;
+		float radius;
+	};
+	struct Capsule {
+		glm::vec3 a, axis; // axis = b - a
+		float radius;
+		float inverseLength2;
+		glm::vec3 lower, upper;
+	};
+	struct Box {
+		glm::vec3 center;
+		glm::mat3 rotation;
+		glm::vec3 halfExtents;
+		glm::vec3 lower, upper;
+	};
+
+	// Applies the contacts of one shape to particles [begin, end): distance(x, y, z) is the
+	// branch-free signed distance, contact(p, normal) the exact distance and outward normal
+	template <typename Distance, typename Contact>
+	uint32_t resolveBlock(ParticleState &state,
+	                      size_t begin,
+	                      size_t end,
+	                      float thickness,
+	                      Distance &&distance,
+	                      Contact &&contact) const;
+
+	void respond(glm::vec3 &p, glm::vec3 &v, const glm::vec3 &normal, float depth) const;
+
+  private:
+	std::vector<Plane> planes;
+	std::vector<Sphere> spheres;
+	std::vector<Capsule> capsules;
+	std::vector<Box> boxes;
+
+	float friction = 0.5f;
+	float restitution = 0.0f;
+
+	std::vector<uint32_t> chunkContacts;
+	size_t contactCount = 0;
+};
+
+#endif // COLLIDERSET_H
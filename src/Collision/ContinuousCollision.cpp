@@ -0,0 +1,504 @@
+//
+// Created by Leonard Chan on 10/15/26.
+//
+
+#include "ContinuousCollision.h"
+
+#include "../Cloth.h"
+#include "../Math/PortableMath.h"
+#include "ClosestPoints.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+static constexpr size_t zoneGrainSize = 16;
+
+// Impacts count when the particles come closer than this fraction of the collision thickness
+static constexpr float proximityFraction = 0.1f;
+
+namespace {
+
+struct Vec3d {
+	double x, y, z;
+};
+
+Vec3d operator-(const Vec3d &a, const Vec3d &b) { return {a.x - b.x, a.y - b.y, a.z - b.z}; }
+
+Vec3d toDouble(const glm::vec3 &v) { return {v.x, v.y, v.z}; }
+
+double determinant(const Vec3d &a, const Vec3d &b, const Vec3d &c) {
+	return a.x * (b.y * c.z - b.z * c.y) - a.y * (b.x * c.z - b.z * c.x) +
+	       a.z * (b.x * c.y - b.y * c.x);
+}
+
+double evaluate(const double c[4], double t) { return ((c[3] * t + c[2]) * t + c[1]) * t + c[0]; }
+
+// Roots of c[3] t^3 + c[2] t^2 + c[1] t + c[0] in [0, 1], ascending. The interval is split at the
+// extrema of the cubic into monotone pieces, and each piece whose ends differ in sign is bisected.
+// A cubic that vanishes identically reports the ends and the middle of the interval.
+int unitIntervalRoots(const double c[4], double roots[3]) {
+	const double scale = std::abs(c[0]) + std::abs(c[1]) + std::abs(c[2]) + std::abs(c[3]);
+	if (scale == 0.0) {
+		roots[0] = 0.0;
+		roots[1] = 0.5;
+		roots[2] = 1.0;
+		return 3;
+	}
+	const double epsilon = 1e-12 * scale;
+
+	// Extrema: roots of 3 c3 t^2 + 2 c2 t + c1 inside (0, 1)
+	double pieces[4] = {0.0};
+	int pieceCount = 1;
+	double a = 3.0 * c[3], b = 2.0 * c[2];
+	if (std::abs(a) > epsilon) {
+		double discriminant = b * b - 4.0 * a * c[1];
+		if (discriminant >= 0.0) {
+			double root = std::sqrt(discriminant);
+			double t0 = (-b - root) / (2.0 * a), t1 = (-b + root) / (2.0 * a);
+			if (t0 > t1)
+				std::swap(t0, t1);
+			for (double t : {t0, t1}) {
+				if (t > 0.0 && t < 1.0)
+					pieces[pieceCount++] = t;
+			}
+		}
+	} else if (std::abs(b) > epsilon) {
+		double t = -c[1] / b;
+		if (t > 0.0 && t < 1.0)
+			pieces[pieceCount++] = t;
+	}
+	pieces[pieceCount++] = 1.0;
+
+	int count = 0;
+	auto addRoot = [&](double t) {
+		if (count == 0 || t > roots[count - 1] + 1e-9)
+			roots[count++] = t;
+	};
+	for (int p = 0; p + 1 < pieceCount && count < 3; p++) {
+		double low = pieces[p], high = pieces[p + 1];
+		double fLow = evaluate(c, low), fHigh = evaluate(c, high);
+		if (std::abs(fLow) <= epsilon) {
+			addRoot(low);
+			continue;
+		}
+		if (std::abs(fHigh) <= epsilon) {
+			addRoot(high);
+			continue;
+		}
+		if ((fLow < 0.0) == (fHigh < 0.0))
+			continue;
+		for (int iteration = 0; iteration < 52; iteration++) {
+			double middle = 0.5 * (low + high);
+			double fMiddle = evaluate(c, middle);
+			if ((fMiddle < 0.0) == (fLow < 0.0)) {
+				low = middle;
+				fLow = fMiddle;
+			} else {
+				high = middle;
+			}
+		}
+		addRoot(0.5 * (low + high));
+	}
+	return count;
+}
+
+// Times in [0, 1] at which four points moving in straight lines from start to end are coplanar
+int coplanarTimes(const glm::vec3 start[4], const glm::vec3 end[4], double times[3]) {
+	Vec3d x0 = toDouble(start[0]), y0 = toDouble(end[0]);
+	Vec3d a = toDouble(start[1]) - x0, b = toDouble(start[2]) - x0, c = toDouble(start[3]) - x0;
+	Vec3d da = toDouble(end[1]) - y0 - a, db = toDouble(end[2]) - y0 - b,
+	      dc = toDouble(end[3]) - y0 - c;
+
+	// det(a + t da, b + t db, c + t dc), lowest order first
+	double coefficients[4] = {
+	    determinant(a, b, c),
+	    determinant(da, b, c) + determinant(a, db, c) + determinant(a, b, dc),
+	    determinant(a, db, dc) + determinant(da, b, dc) + determinant(da, db, c),
+	    determinant(da, db, dc)};
+	return unitIntervalRoots(coefficients, times);
+}
+
+glm::vec3 lerp(const glm::vec3 &a, const glm::vec3 &b, float t) { return a + t * (b - a); }
+
+float vertexTriangleDistance(const glm::vec3 x[4]) {
+	glm::vec3 weights = closestPointOnTriangle(x[0], x[1], x[2], x[3]);
+	glm::vec3 offset = x[0] - (weights.x * x[1] + weights.y * x[2] + weights.z * x[3]);
+	return glm::length(offset);
+}
+
+float edgeEdgeDistance(const glm::vec3 x[4]) {
+	float s, u;
+	closestPointsOnSegments(x[0], x[1], x[2], x[3], s, u);
+	return glm::length(lerp(x[0], x[1], s) - lerp(x[2], x[3], u));
+}
+
+// Whether two boxes are more than tolerance apart along some axis
+bool boxesApart(const glm::vec3 &lowerA,
+                const glm::vec3 &upperA,
+                const glm::vec3 &lowerB,
+                const glm::vec3 &upperB,
+                float tolerance) {
+	glm::vec3 gap = glm::max(lowerA - upperB, lowerB - upperA);
+	return std::max(gap.x, std::max(gap.y, gap.z)) >= tolerance;
+}
+
+// Whether the distance between the two features stays at least tolerance over the step. Moving
+// the points of either feature by at most m changes their distance by at most m, so the distance
+// at time t is at least d0 - M t and at least d1 - M (1 - t), where M bounds the motion of both
+// features together; the smaller of the two bounds peaks at (d0 + d1 - M) / 2. This filter is
+// exact, and for the usual small steps it rejects almost every candidate before the cubic.
+template <typename Distance>
+bool staysApart(const glm::vec3 start[4],
+                const glm::vec3 end[4],
+                int firstFeatureSize,
+                float tolerance,
+                Distance &&distance) {
+	float motionA = 0.0f, motionB = 0.0f;
+	for (int k = 0; k < 4; k++) {
+		glm::vec3 d = end[k] - start[k];
+		float &motion = k < firstFeatureSize ? motionA : motionB;
+		motion = std::max(motion, glm::dot(d, d));
+	}
+	float motion = std::sqrt(motionA) + std::sqrt(motionB);
+	return 0.5f * (distance(start) + distance(end) - motion) >= tolerance;
+}
+
+// Whether point 0 comes within tolerance of triangle 1-2-3 while the four are coplanar
+bool vertexTriangleImpact(const glm::vec3 start[4], const glm::vec3 end[4], float tolerance) {
+	if (staysApart(start, end, 1, tolerance, vertexTriangleDistance))
+		return false;
+
+	double times[3];
+	int count = coplanarTimes(start, end, times);
+	for (int r = 0; r < count; r++) {
+		float t = float(times[r]);
+		glm::vec3 p = lerp(start[0], end[0], t), a = lerp(start[1], end[1], t),
+		          b = lerp(start[2], end[2], t), c = lerp(start[3], end[3], t);
+		glm::vec3 weights = closestPointOnTriangle(p, a, b, c);
+		glm::vec3 offset = p - (weights.x * a + weights.y * b + weights.z * c);
+		if (glm::dot(offset, offset) < tolerance * tolerance)
+			return true;
+	}
+	return false;
+}
+
+// Whether edge 0-1 comes within tolerance of edge 2-3 while the four are coplanar
+bool edgeEdgeImpact(const glm::vec3 start[4], const glm::vec3 end[4], float tolerance) {
+	if (staysApart(start, end, 2, tolerance, edgeEdgeDistance))
+		return false;
+
+	double times[3];
+	int count = coplanarTimes(start, end, times);
+	for (int r = 0; r < count; r++) {
+		float t = float(times[r]);
+		glm::vec3 p1 = lerp(start[0], end[0], t), q1 = lerp(start[1], end[1], t),
+		          p2 = lerp(start[2], end[2], t), q2 = lerp(start[3], end[3], t);
+		float s, u;
+		closestPointsOnSegments(p1, q1, p2, q2, s, u);
+		glm::vec3 offset = lerp(p1, q1, s) - lerp(p2, q2, u);
+		if (glm::dot(offset, offset) < tolerance * tolerance)
+			return true;
+	}
+	return false;
+}
+
+// v rotated by angle about the unit axis (Rodrigues)
+glm::vec3 rotate(const glm::vec3 &v, const glm::vec3 &axis, float angle) {
+	float s, c;
+	portableSinCos(angle, s, c);
+	return v * c + glm::cross(axis, v) * s + axis * (glm::dot(axis, v) * (1.0f - c));
+}
+
+} // namespace
+
+void ContinuousCollision::resolve(const Cloth &cloth,
+                                  const Vec3Array &start,
+                                  ParticleState &state,
+                                  float dt) {
+	const size_t N = state.size();
+	impactCount = zoneCount = 0;
+	iterations = 0;
+	if (N == 0 || dt <= 0.0f || start.size() != N)
+		return;
+
+	const float tolerance = proximityFraction * cloth.getCollisionThickness();
+	bvh.setSweep(&start, tolerance);
+	// Tearing changes the topology but only renumbers triangle corners, so the tree is refitted
+	// and just the feature ownership is redone
+	if (!bvhBuilt || meshVersion != cloth.getMeshVersion()) {
+		bvh.build(cloth.getTriangles(), state.positions);
+		bvhBuilt = true;
+		meshVersion = cloth.getMeshVersion();
+	} else {
+		bvh.update();
+	}
+	if (!topologyBuilt || topologyVersion != cloth.getTopologyVersion())
+		buildTopology(cloth);
+
+	if (zoneParent.size() != N) {
+		zoneParent.resize(N);
+		std::iota(zoneParent.begin(), zoneParent.end(), 0u);
+		inZone.assign(N, 0);
+	}
+
+	for (int iteration = 0; iteration < maxIterations; iteration++) {
+		if (iteration > 0)
+			bvh.refit();
+		detect(cloth.getTriangles(), cloth.getParticleSources(), start, state.positions,
+		       tolerance);
+		iterations = iteration + 1;
+
+		size_t count = 0;
+		for (const std::vector<Impact> &impacts : taskImpacts) {
+			count += impacts.size();
+		}
+		if (iteration == 0)
+			impactCount = count;
+		if (count == 0)
+			break;
+
+		resolveZones(start, state, dt, iteration == maxIterations - 1);
+	}
+	zoneCount = zoneOffsets.empty() ? 0 : zoneOffsets.size() - 1;
+
+	// Every particle is its own zone again for the next step
+	for (uint32_t i : zoneParticles) {
+		zoneParent[i] = i;
+		inZone[i] = 0;
+	}
+	zoneParticles.clear();
+	zoneOffsets.clear();
+}
+
+void ContinuousCollision::buildTopology(const Cloth &cloth) {
+	const std::vector<uint32_t> &triangles = cloth.getTriangles();
+	const uint32_t corners = uint32_t(triangles.size() / 3 * 3);
+
+	// The first triangle listing a particle owns it, and the first triangle listing an edge owns
+	// the edge
+	ownedFeatures.assign(corners / 3, 0);
+	std::vector<uint8_t> vertexOwned(cloth.getParticles().size(), 0);
+	for (uint32_t corner = 0; corner < corners; corner++) {
+		uint32_t v = triangles[corner];
+		if (!vertexOwned[v]) {
+			vertexOwned[v] = 1;
+			ownedFeatures[corner / 3] |= uint8_t(1u << (corner % 3));
+		}
+	}
+
+	struct EdgeUse {
+		uint64_t key;
+		uint32_t corner; // edge from this corner to the next one of its triangle
+	};
+	std::vector<EdgeUse> uses;
+	uses.reserve(corners);
+	for (uint32_t corner = 0; corner < corners; corner++) {
+		uint32_t t = corner / 3, k = corner % 3;
+		uint32_t a = triangles[3 * t + k], b = triangles[3 * t + (k + 1) % 3];
+		uses.push_back({uint64_t(std::min(a, b)) << 32 | std::max(a, b), corner});
+	}
+	std::sort(uses.begin(), uses.end(), [](const EdgeUse &x, const EdgeUse &y) {
+		return x.key < y.key || (x.key == y.key && x.corner < y.corner);
+	});
+	for (size_t u = 0; u < uses.size(); u++) {
+		if (u == 0 || uses[u].key != uses[u - 1].key)
+			ownedFeatures[uses[u].corner / 3] |= uint8_t(8u << (uses[u].corner % 3));
+	}
+
+	topologyBuilt = true;
+	topologyVersion = cloth.getTopologyVersion();
+}
+
+void ContinuousCollision::detect(const std::vector<uint32_t> &triangles,
+                                 const std::vector<uint32_t> &sources,
+                                 const Vec3Array &start,
+                                 const Vec3Array &positions,
+                                 float tolerance) {
+	taskImpacts.resize(bvh.preparePairTasks());
+	for (std::vector<Impact> &impacts : taskImpacts) {
+		impacts.clear();
+	}
+
+	// Every pair of triangles whose swept boxes overlap tests the features they own against each
+	// other: its vertices against the other triangle, and its edges against the other's edges.
+	// Features are owned by exactly one triangle and lie inside its box, so each vertex-triangle
+	// and edge-edge pair that can collide is tested exactly once.
+	bvh.forEachOverlappingPair([&](size_t task, uint32_t ta, uint32_t tb) {
+		std::vector<Impact> &impacts = taskImpacts[task];
+		const uint8_t ownedA = ownedFeatures[ta], ownedB = ownedFeatures[tb];
+
+		// Corners 0-2 are triangle a and 3-5 triangle b, with the boxes they sweep over the step.
+		// Most feature pairs of neighbouring triangles are rejected by their boxes alone. Features
+		// count as sharing a particle if they share its source, so the two sides of a tear are
+		// not taken for an impact where they part.
+		uint32_t corner[6], source[6];
+		glm::vec3 x0[6], x1[6], lower[6], upper[6];
+		for (int c = 0; c < 6; c++) {
+			corner[c] = c < 3 ? triangles[3 * ta + c] : triangles[3 * tb + c - 3];
+			source[c] = sources[corner[c]];
+			x0[c] = start.get(corner[c]);
+			x1[c] = positions.get(corner[c]);
+			lower[c] = glm::min(x0[c], x1[c]);
+			upper[c] = glm::max(x0[c], x1[c]);
+		}
+		const glm::vec3 triangleLower[2] = {glm::min(lower[0], glm::min(lower[1], lower[2])),
+		                                    glm::min(lower[3], glm::min(lower[4], lower[5]))};
+		const glm::vec3 triangleUpper[2] = {glm::max(upper[0], glm::max(upper[1], upper[2])),
+		                                    glm::max(upper[3], glm::max(upper[4], upper[5]))};
+
+		auto vertexTriangle = [&](int v, int triangle) {
+			const int t = 3 * triangle;
+			const uint32_t i = source[v];
+			if (i == source[t] || i == source[t + 1] || i == source[t + 2] ||
+			    boxesApart(lower[v], upper[v], triangleLower[triangle], triangleUpper[triangle],
+			               tolerance))
+				return;
+			const glm::vec3 y0[4] = {x0[v], x0[t], x0[t + 1], x0[t + 2]};
+			const glm::vec3 y1[4] = {x1[v], x1[t], x1[t + 1], x1[t + 2]};
+			if (vertexTriangleImpact(y0, y1, tolerance))
+				impacts.push_back({{corner[v], corner[t], corner[t + 1], corner[t + 2]}});
+		};
+		for (int k = 0; k < 3; k++) {
+			if (ownedA & (1u << k))
+				vertexTriangle(k, 1);
+			if (ownedB & (1u << k))
+				vertexTriangle(3 + k, 0);
+		}
+
+		for (int k = 0; k < 3; k++) {
+			if (!(ownedA & (8u << k)))
+				continue;
+			const int a = k, b = (k + 1) % 3;
+			const glm::vec3 edgeLower = glm::min(lower[a], lower[b]),
+			                edgeUpper = glm::max(upper[a], upper[b]);
+			for (int l = 0; l < 3; l++) {
+				if (!(ownedB & (8u << l)))
+					continue;
+				const int c = 3 + l, d = 3 + (l + 1) % 3;
+				if (source[c] == source[a] || source[c] == source[b] || source[d] == source[a] ||
+				    source[d] == source[b] ||
+				    boxesApart(edgeLower, edgeUpper, glm::min(lower[c], lower[d]),
+				               glm::max(upper[c], upper[d]), tolerance))
+					continue;
+				const glm::vec3 y0[4] = {x0[a], x0[b], x0[c], x0[d]};
+				const glm::vec3 y1[4] = {x1[a], x1[b], x1[c], x1[d]};
+				if (edgeEdgeImpact(y0, y1, tolerance))
+					impacts.push_back({{corner[a], corner[b], corner[c], corner[d]}});
+			}
+		}
+	});
+}
+
+void ContinuousCollision::resolveZones(const Vec3Array &start,
+                                       ParticleState &state,
+                                       float dt,
+                                       bool freeze) {
+	// 1) Merge the particles of every impact into one zone, in task order
+	for (const std::vector<Impact> &impacts : taskImpacts) {
+		for (const Impact &impact : impacts) {
+			for (uint32_t i : impact.particles) {
+				if (!inZone[i]) {
+					inZone[i] = 1;
+					zoneParticles.push_back(i);
+				}
+			}
+			uint32_t root = findZone(impact.particles[0]);
+			for (int k = 1; k < 4; k++) {
+				uint32_t other = findZone(impact.particles[k]);
+				if (other != root) {
+					// The smaller index becomes the root, so zones do not depend on merge order
+					if (other < root)
+						std::swap(other, root);
+					zoneParent[other] = root;
+				}
+			}
+		}
+	}
+
+	// 2) Group the zone particles by zone
+	for (uint32_t i : zoneParticles) {
+		findZone(i);
+	}
+	std::sort(zoneParticles.begin(), zoneParticles.end(), [this](uint32_t a, uint32_t b) {
+		return zoneParent[a] < zoneParent[b] || (zoneParent[a] == zoneParent[b] && a < b);
+	});
+	zoneOffsets.clear();
+	for (size_t k = 0; k < zoneParticles.size(); k++) {
+		if (k == 0 || zoneParent[zoneParticles[k]] != zoneParent[zoneParticles[k - 1]])
+			zoneOffsets.push_back(uint32_t(k));
+	}
+	zoneOffsets.push_back(uint32_t(zoneParticles.size()));
+
+	// 3) Move every zone rigidly with its momentum over the step
+	const float *invMass = state.inverseMass.data();
+	const size_t zones = zoneOffsets.size() - 1;
+	TaskScheduler::get().parallelFor(0, zones, zoneGrainSize, [&](size_t begin, size_t end) {
+		for (size_t z = begin; z < end; z++) {
+			const uint32_t *first = zoneParticles.data() + zoneOffsets[z];
+			const uint32_t *last = zoneParticles.data() + zoneOffsets[z + 1];
+
+			bool fixed = freeze;
+			float mass = 0.0f;
+			glm::vec3 center(0.0f), displacement(0.0f);
+			for (const uint32_t *i = first; i < last; i++) {
+				if (invMass[*i] == 0.0f) {
+					fixed = true;
+					break;
+				}
+				float m = 1.0f / invMass[*i];
+				mass += m;
+				center += m * start.get(*i);
+				displacement += m * (state.positions.get(*i) - start.get(*i));
+			}
+
+			if (fixed) {
+				for (const uint32_t *i = first; i < last; i++) {
+					state.positions.set(*i, start.get(*i));
+					state.velocities.set(*i, glm::vec3(0.0f));
+				}
+				continue;
+			}
+
+			// Momentum in units of the step: displacements stand in for velocities
+			center /= mass;
+			displacement /= mass;
+			glm::vec3 angularMomentum(0.0f);
+			glm::mat3 inertia(0.0f);
+			for (const uint32_t *i = first; i < last; i++) {
+				float m = 1.0f / invMass[*i];
+				glm::vec3 r = start.get(*i) - center;
+				glm::vec3 v = state.positions.get(*i) - start.get(*i) - displacement;
+				angularMomentum += m * glm::cross(r, v);
+				inertia += m * (glm::dot(r, r) * glm::mat3(1.0f) - glm::outerProduct(r, r));
+			}
+
+			// Zones on a line have no inertia about it; the regularization gives them no spin
+			float trace = inertia[0][0] + inertia[1][1] + inertia[2][2];
+			inertia += (1e-6f * trace + 1e-20f) * glm::mat3(1.0f);
+			glm::vec3 spin = glm::inverse(inertia) * angularMomentum;
+			float angle = glm::length(spin);
+			glm::vec3 axis = angle > 0.0f ? spin / angle : glm::vec3(0.0f, 1.0f, 0.0f);
+
+			for (const uint32_t *i = first; i < last; i++) {
+				glm::vec3 x0 = start.get(*i);
+				glm::vec3 x1 = center + displacement + rotate(x0 - center, axis, angle);
+				state.positions.set(*i, x1);
+				state.velocities.set(*i, (x1 - x0) / dt);
+			}
+		}
+	});
+}
+
+uint32_t ContinuousCollision::findZone(uint32_t particle) {
+	uint32_t root = particle;
+	while (zoneParent[root] != root) {
+		root = zoneParent[root];
+	}
+	while (zoneParent[particle] != root) {
+		uint32_t next = zoneParent[particle];
+		zoneParent[particle] = root;
+		particle = next;
+	}
+	return root;
+}
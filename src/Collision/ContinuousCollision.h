@@ -0,0 +1,100 @@
+//
+// Created by Leonard Chan on 10/15/26.
+//
+
+#ifndef CONTINUOUSCOLLISION_H
+#define CONTINUOUSCOLLISION_H
+
+#include "../ParticleState.h"
+#include "TriangleBVH.h"
+
+#include <cstdint>
+#include <vector>
+
+class Cloth;
+
+// Continuous self-collision for a cloth, run last in the step. Every particle is assumed to move
+// in a straight line from its position at the start of the step to its position at the end, and
+// the step is checked for the two events that let the cloth pass through itself:
+//   - vertex-triangle: a particle crosses a triangle it does not belong to
+//   - edge-edge: two triangle edges without a common particle cross each other
+// Each event happens when the four particles involved become coplanar, a cubic in time, and
+// counts if they are also closer than a fraction of the collision thickness at a root of that
+// cubic in [0, 1]. Candidates come from traversing a TriangleBVH, whose boxes cover each
+// triangle's motion over the step, against itself. Each particle and each edge is represented by
+// one triangle containing it, so every candidate pair of features is tested once.
+//
+// Impacts are resolved with rigid impact zones (Provot, "Collision and self-collision handling
+// in cloth model dedicated to design garments"; Harmon et al., "Robust treatment of simultaneous
+// collisions"): the particles of impacts that share a particle form one zone, whose motion over
+// the step is replaced by the rigid motion with the same linear and angular momentum. A rigid
+// motion cannot make a zone pass through itself. Zones are disjoint, so they are resolved in
+// parallel; the step is then checked again, and zones that still collide grow and merge. A zone
+// holding a pinned particle does not move at all. If impacts remain after the iteration limit,
+// their zones are left at the start of the step.
+//
+// The start of the step must be free of intersections, which holds from the flat initial cloth
+// as long as the mode stays on.
+class ContinuousCollision {
+  public:
+	// start holds the positions at the start of the step; state is corrected in place and its
+	// velocities are replaced by the corrected displacement over dt for particles in a zone
+	void resolve(const Cloth &cloth, const Vec3Array &start, ParticleState &state, float dt);
+
+	// Impacts found by the first check of the last resolve()
+	size_t getImpactCount() const { return impactCount; }
+	// Checks run by the last resolve(), including the final one that found no impacts
+	int getIterations() const { return iterations; }
+	size_t getZoneCount() const { return zoneCount; }
+
+	void setMaxIterations(int iterations) { maxIterations = iterations; }
+
+  private:
+	// Four particles that collide: a vertex and a triangle, or two edges
+	struct Impact {
+		uint32_t particles[4];
+	};
+
+	// Assigns every particle and every edge to one triangle containing it
+	void buildTopology(const Cloth &cloth);
+
+	// Fills taskImpacts for the motion from start to positions
+	void detect(const std::vector<uint32_t> &triangles,
+	            const std::vector<uint32_t> &sources,
+	            const Vec3Array &start,
+	            const Vec3Array &positions,
+	            float tolerance);
+
+	// Merges the particles of the impacts into zones and moves each zone rigidly
+	void resolveZones(const Vec3Array &start, ParticleState &state, float dt, bool freeze);
+
+	uint32_t findZone(uint32_t particle);
+
+  private:
+	TriangleBVH bvh;
+	bool bvhBuilt = false;
+	uint64_t meshVersion = 0;
+
+	bool topologyBuilt = false;
+	uint64_t topologyVersion = 0;
+	// Per triangle, the features it owns: bit k for the particle at corner k, bit 3 + k for the
+	// edge from corner k to corner k + 1
+	std::vector<uint8_t> ownedFeatures;
+
+	// Impacts found by each task of the BVH self-traversal
+	std::vector<std::vector<Impact>> taskImpacts;
+
+	// Union-find over the particles; zoneParent[i] == i for roots. Particles in some zone are
+	// listed in zoneParticles, grouped by zone in zoneOffsets after each merge.
+	std::vector<uint32_t> zoneParent;
+	std::vector<uint8_t> inZone;
+	std::vector<uint32_t> zoneParticles;
+	std::vector<uint32_t> zoneOffsets;
+
+	int maxIterations = 16;
+	size_t impactCount = 0;
+	int iterations = 0;
+	size_t zoneCount = 0;
+};
+
+#endif // CONTINUOUSCOLLISION_H
@@ -0,0 +1,201 @@
+//
+// Created by Leonard Chan on 10/15/26.
+//
+
+#include "SelfCollision.h"
+
+#include "../Cloth.h"
+#include "ClosestPoints.h"
+
+#include <algorithm>
+#include <cmath>
+
+static constexpr size_t particleChunkSize = 2048;
+
+// Triangle edges are assumed to stretch at most this far beyond their rest length. Triangles
+// stretched further can miss vertex-triangle contacts near their corners.
+static constexpr float stretchAllowance = 1.5f;
+
+// Whether particles i and j are joined by a spring; rows of the pattern are sorted
+static bool areNeighbors(const BlockSparsePattern &pattern, uint32_t i, uint32_t j) {
+	auto first = pattern.columns.begin() + pattern.rowOffsets[i];
+	auto last = pattern.columns.begin() + pattern.rowOffsets[i + 1];
+	return std::binary_search(first, last, j);
+}
+
+void SelfCollision::resolve(const Cloth &cloth, ParticleState &state) {
+	size_t N = state.size();
+	TaskScheduler &scheduler = TaskScheduler::get();
+	const float thickness = cloth.getCollisionThickness();
+	contactCount = 0;
+	if (N == 0 || thickness <= 0.0f)
+		return;
+
+	if (!topologyBuilt || topologyVersion != cloth.getTopologyVersion())
+		buildTopology(cloth);
+
+	const BlockSparsePattern &pattern = cloth.getSpringPattern();
+	const std::vector<uint32_t> &triangles = cloth.getTriangles();
+	const std::vector<uint32_t> &sources = cloth.getParticleSources();
+	const Vec3Array &X = state.positions;
+	const Vec3Array &V = state.velocities;
+	const float *invMass = state.inverseMass.data();
+
+	// 1) Hash the particles, and the triangle centroids with cells sized by how far a triangle
+	// reaches (see measureTriangles() and buildTriangleHash()). The two hashes build concurrently.
+	const float thickness2 = thickness * thickness;
+	if (hashBuild.empty()) {
+		hashBuild.addTask([this]() { particleHash.build(*hashPositions, hashThickness); });
+		TaskGraph::NodeId measure = hashBuild.addTask([this]() { measureTriangles(); });
+		TaskGraph::NodeId hash = hashBuild.addTask([this]() { buildTriangleHash(); });
+		hashBuild.addDependency(measure, hash);
+	}
+	hashPositions = &X;
+	hashTriangles = &triangles;
+	hashThickness = thickness;
+	scheduler.run(hashBuild);
+
+	positionCorrections.resize(N);
+	velocityCorrections.resize(N);
+	chunkContacts.resize(TaskScheduler::chunkCount(0, N, particleChunkSize));
+
+	// 2) Every particle averages the corrections of its contacts
+	scheduler.parallelForChunks(0, N, particleChunkSize, [&](size_t chunk, size_t begin,
+	                                                         size_t end) {
+		uint32_t chunkContactCount = 0;
+		for (size_t i = begin; i < end; i++) {
+			glm::vec3 dx(0.0f), dv(0.0f);
+			int contacts = 0;
+			const float wi = invMass[i];
+			const glm::vec3 p = X.get(i), v = V.get(i);
+
+			auto respond = [&](const glm::vec3 &normal, float depth, float share,
+			                   const glm::vec3 &otherVelocity) {
+				dx += share * depth * normal;
+				float approach = glm::dot(v - otherVelocity, normal);
+				if (approach < 0.0f)
+					dv -= share * approach * normal;
+				contacts++;
+			};
+
+			if (wi > 0.0f) {
+				// Particle-particle
+				particleHash.forEachNear(p, [&](uint32_t j) {
+					glm::vec3 d = p - X.get(j);
+					float dist2 = glm::dot(d, d);
+					if (sources[j] == sources[i] || !(dist2 < thickness2) || dist2 <= 1e-14f ||
+					    areNeighbors(pattern, uint32_t(i), j))
+						return;
+					float dist = std::sqrt(dist2);
+					respond(d / dist, thickness - dist, wi / (wi + invMass[j]), V.get(j));
+				});
+
+				// Vertex-triangle
+				triangleHash.forEachNear(p, [&](uint32_t t) {
+					glm::vec3 toCentroid = p - centroids.get(t);
+					if (!(glm::dot(toCentroid, toCentroid) < bounds[t] * bounds[t]))
+						return;
+					const uint32_t *tri = &triangles[3 * t];
+					const uint32_t source = sources[i];
+					if (sources[tri[0]] == source || sources[tri[1]] == source ||
+					    sources[tri[2]] == source)
+						return;
+
+					glm::vec3 xa = X.get(tri[0]), xb = X.get(tri[1]), xc = X.get(tri[2]);
+					// Degenerate triangles give NaN weights, and NaN distances never count
+					glm::vec3 weights = closestPointOnTriangle(p, xa, xb, xc);
+					glm::vec3 offset = p - (weights.x * xa + weights.y * xb + weights.z * xc);
+					float dist2 = glm::dot(offset, offset);
+					if (!(dist2 < thickness2) || dist2 <= 1e-14f)
+						return;
+					if (areNeighbors(pattern, uint32_t(i), tri[0]) ||
+					    areNeighbors(pattern, uint32_t(i), tri[1]) ||
+					    areNeighbors(pattern, uint32_t(i), tri[2]))
+						return;
+
+					// Generalized inverse mass and velocity of the contact point
+					float wt = weights.x * weights.x * invMass[tri[0]] +
+					           weights.y * weights.y * invMass[tri[1]] +
+					           weights.z * weights.z * invMass[tri[2]];
+					glm::vec3 vq = weights.x * V.get(tri[0]) + weights.y * V.get(tri[1]) +
+					               weights.z * V.get(tri[2]);
+					float dist = std::sqrt(dist2);
+					respond(offset / dist, thickness - dist, wi / (wi + wt), vq);
+				});
+			}
+
+			if (contacts > 0) {
+				dx /= float(contacts);
+				dv /= float(contacts);
+			}
+			positionCorrections.set(i, dx);
+			velocityCorrections.set(i, dv);
+			chunkContactCount += contacts;
+		}
+		chunkContacts[chunk] = chunkContactCount;
+	});
+
+	// 3) Apply the corrections once every particle has read the uncorrected state
+	scheduler.parallelFor(0, N, particleChunkSize, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			state.positions.add(i, positionCorrections.get(i));
+			state.velocities.add(i, velocityCorrections.get(i));
+		}
+	});
+
+	for (uint32_t contacts : chunkContacts) {
+		contactCount += contacts;
+	}
+}
+
+void SelfCollision::buildTopology(const Cloth &cloth) {
+	// Triangle edges are the structure and shear springs
+	maxRestEdge = 0.0f;
+	for (const Spring &s : cloth.getSprings()) {
+		if (s.type != Spring::SpringType::BEND)
+			maxRestEdge = std::max(maxRestEdge, s.restLength);
+	}
+
+	topologyBuilt = true;
+	topologyVersion = cloth.getTopologyVersion();
+}
+
+// A triangle can only touch particles within the thickness plus its centroid-to-corner distance
+// of its centroid. Measures that bound and the centroid of every triangle.
+void SelfCollision::measureTriangles() {
+	const Vec3Array &X = *hashPositions;
+	const std::vector<uint32_t> &triangles = *hashTriangles;
+	const float thickness = hashThickness;
+	const size_t triangleCount = triangles.size() / 3;
+	centroids.resize(triangleCount);
+	bounds.resize(triangleCount);
+	chunkBounds.resize(TaskScheduler::chunkCount(0, triangleCount, particleChunkSize));
+	TaskScheduler::get().parallelForChunks(
+	    0, triangleCount, particleChunkSize, [&](size_t chunk, size_t begin, size_t end) {
+		    float largest = 0.0f;
+		    for (size_t t = begin; t < end; t++) {
+			    const uint32_t *v = &triangles[3 * t];
+			    glm::vec3 a = X.get(v[0]), b = X.get(v[1]), c = X.get(v[2]);
+			    glm::vec3 centroid = (a + b + c) * (1.0f / 3.0f);
+			    float corner2 = std::max({glm::dot(a - centroid, a - centroid),
+			                              glm::dot(b - centroid, b - centroid),
+			                              glm::dot(c - centroid, c - centroid)});
+			    centroids.set(t, centroid);
+			    bounds[t] = thickness + std::sqrt(corner2);
+			    largest = std::max(largest, bounds[t]);
+		    }
+		    chunkBounds[chunk] = largest;
+	    });
+}
+
+// The largest bound is the cell size of the triangle hash. It is capped by the stretch
+// allowance, so a single overstretched triangle cannot inflate every cell.
+void SelfCollision::buildTriangleHash() {
+	const float thickness = hashThickness;
+
+	// Every point of a triangle lies within two thirds of its longest edge of the centroid
+	float reach = thickness + stretchAllowance * (2.0f / 3.0f) * maxRestEdge;
+	if (!chunkBounds.empty())
+		reach = std::min(reach, *std::max_element(chunkBounds.begin(), chunkBounds.end()));
+	triangleHash.build(centroids, std::max(reach, thickness));
+}
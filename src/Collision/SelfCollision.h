@@ -0,0 +1,79 @@
+//
+// Created by Leonard Chan on 10/15/26.
+//
+
+#ifndef SELFCOLLISION_H
+#define SELFCOLLISION_H
+
+#include "../ParticleState.h"
+#include "../Tasks/TaskGraph.h"
+#include "SpatialHash.h"
+
+#include <cstdint>
+#include <vector>
+
+class Cloth;
+
+// Discrete self-collision for a cloth, run after the integrator. Two kinds of contact are
+// resolved:
+//   - particle-particle: two particles closer than the collision thickness
+//   - vertex-triangle: a particle closer than the thickness to a cloth triangle
+// Pairs that are topological neighbours never collide: particles joined by a spring, and
+// triangles touching the particle or one of its spring neighbours. Particles split apart by
+// tearing count as the same particle. Candidates come from two SpatialHashes rebuilt every step:
+// one over the particles with cells of the thickness, and one over the triangle centroids with
+// cells of the thickness plus the largest centroid-to-corner distance in the cloth.
+//
+// Every particle gathers its own correction from all of its contacts (a Jacobi pass), so the
+// pass is parallel without write conflicts and its result does not depend on the thread count.
+// A contact moves the particle out to the thickness in proportion to its share of the inverse
+// mass, and removes the approaching part of the relative velocity along the contact normal.
+// The other side of a vertex-triangle contact is left to the contacts of the triangle's own
+// vertices. Particles that have already passed through the cloth are pushed back out on the
+// side they ended up on.
+class SelfCollision {
+  public:
+	SelfCollision() = default;
+
+	// The hash build tasks point back at their SelfCollision
+	SelfCollision(const SelfCollision &) = delete;
+	SelfCollision &operator=(const SelfCollision &) = delete;
+
+	void resolve(const Cloth &cloth, ParticleState &state);
+
+	// Contacts found by the last resolve()
+	size_t getContactCount() const { return contactCount; }
+
+  private:
+	// Longest rest edge of the triangles, per topology
+	void buildTopology(const Cloth &cloth);
+
+	// Tasks of hashBuild, on the inputs in hashPositions, hashTriangles and hashThickness
+	void measureTriangles();
+	void buildTriangleHash();
+
+  private:
+	SpatialHash particleHash, triangleHash;
+
+	// Builds both hashes. The particle hash only needs the positions, so it is built while the
+	// triangles are measured and hashed. Created on the first resolve().
+	TaskGraph hashBuild;
+	const Vec3Array *hashPositions = nullptr;
+	const std::vector<uint32_t> *hashTriangles = nullptr;
+	float hashThickness = 0.0f;
+
+	// Per triangle: centroid, and how far from it a particle can be and still touch the triangle
+	Vec3Array centroids;
+	AlignedVector<float> bounds;
+	std::vector<float> chunkBounds;
+
+	bool topologyBuilt = false;
+	uint64_t topologyVersion = 0;
+	float maxRestEdge = 0.0f;
+
+	Vec3Array positionCorrections, velocityCorrections;
+	std::vector<uint32_t> chunkContacts;
+	size_t contactCount = 0;
+};
+
+#endif // SELFCOLLISION_H
@@ -0,0 +1,95 @@
+//
+// Created by Leonard Chan on 10/15/26.
+//
+
+#include "SpatialHash.h"
+
+#include "../Tasks/TaskScheduler.h"
+
+#include <atomic>
+#include <bit>
+
+static constexpr size_t pointGrainSize = 4096;
+static constexpr size_t slotChunkSize = 16384;
+
+void SpatialHash::build(const Vec3Array &points, float cellSize) {
+	TaskScheduler &scheduler = TaskScheduler::get();
+	size_t n = points.size();
+	this->cellSize = cellSize;
+	inverseCellSize = 1.0f / cellSize;
+
+	// At least four slots, so the three slots of a row in forEachNear() are always distinct
+	size_t slotCount = std::bit_ceil(std::max<size_t>(2 * n, 4));
+	slotMask = uint32_t(slotCount - 1);
+	slotStart.assign(slotCount + 1, 0);
+	cursor.resize(slotCount);
+	pointSlot.resize(n);
+	entries.resize(n);
+	entryCells.resize(n);
+
+	// 1) Count the points of every slot
+	scheduler.parallelFor(0, n, pointGrainSize, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			uint32_t slot = slotOf(cellOf(points.get(i)));
+			pointSlot[i] = slot;
+			std::atomic_ref<uint32_t>(slotStart[slot]).fetch_add(1, std::memory_order_relaxed);
+		}
+	});
+
+	// 2) Exclusive prefix sum of the counts: per-chunk totals, a scan over the chunks, then the
+	// offsets within each chunk
+	chunkTotals.resize(TaskScheduler::chunkCount(0, slotCount, slotChunkSize));
+	scheduler.parallelForChunks(
+	    0, slotCount, slotChunkSize, [&](size_t chunk, size_t begin, size_t end) {
+		    uint32_t total = 0;
+		    for (size_t s = begin; s < end; s++) {
+			    total += slotStart[s];
+		    }
+		    chunkTotals[chunk] = total;
+	    });
+	uint32_t offset = 0;
+	for (uint32_t &total : chunkTotals) {
+		uint32_t count = total;
+		total = offset;
+		offset += count;
+	}
+	scheduler.parallelForChunks(
+	    0, slotCount, slotChunkSize, [&](size_t chunk, size_t begin, size_t end) {
+		    uint32_t start = chunkTotals[chunk];
+		    for (size_t s = begin; s < end; s++) {
+			    uint32_t count = slotStart[s];
+			    slotStart[s] = cursor[s] = start;
+			    start += count;
+		    }
+	    });
+	slotStart[slotCount] = uint32_t(n);
+
+	// 3) Scatter the point indices into their slots
+	scheduler.parallelFor(0, n, pointGrainSize, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			std::atomic_ref<uint32_t> slotCursor(cursor[pointSlot[i]]);
+			entries[slotCursor.fetch_add(1, std::memory_order_relaxed)] = uint32_t(i);
+		}
+	});
+
+	// 4) The scatter order depends on the thread timing; sort each (short) slot to remove it
+	scheduler.parallelFor(0, slotCount, slotChunkSize, [&](size_t begin, size_t end) {
+		for (size_t s = begin; s < end; s++) {
+			for (uint32_t e = slotStart[s] + 1; e < slotStart[s + 1]; e++) {
+				uint32_t index = entries[e];
+				uint32_t k = e;
+				for (; k > slotStart[s] && entries[k - 1] > index; k--) {
+					entries[k] = entries[k - 1];
+				}
+				entries[k] = index;
+			}
+		}
+	});
+
+	// 5) Cells of the sorted entries
+	scheduler.parallelFor(0, n, pointGrainSize, [&](size_t begin, size_t end) {
+		for (size_t e = begin; e < end; e++) {
+			entryCells[e] = cellOf(points.get(entries[e]));
+		}
+	});
+}
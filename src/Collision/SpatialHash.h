@@ -0,0 +1,100 @@
+//
+// Created by Leonard Chan on 10/15/26.
+//
+
+#ifndef SPATIALHASH_H
+#define SPATIALHASH_H
+
+#include "../ParticleState.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vector>
+
+// Uniform grid over a point set, hashed into a table of about two slots per point. The build is a
+// counting sort: every point is counted into its slot, the counts are prefix-summed into slot
+// offsets, and the point indices are scattered into one flat array. Every pass is parallel and
+// the build never allocates once the arrays have grown to size. Each slot's indices are sorted
+// afterwards, so queries visit points in the same order whatever the thread count.
+class SpatialHash {
+  public:
+	// Rebuilds the grid over points with cubic cells of the given size
+	void build(const Vec3Array &points, float cellSize);
+
+	float getCellSize() const { return cellSize; }
+
+	// Integer cell containing p; non-finite coordinates map to cell 0
+	glm::ivec3 cellOf(const glm::vec3 &p) const {
+		return glm::ivec3(cellCoordinate(p.x), cellCoordinate(p.y), cellCoordinate(p.z));
+	}
+
+	// Calls visit(index) for every point whose cell is within one cell of p's cell in each axis:
+	// every point closer to p than the cell size, and possibly some farther ones. Entries carry
+	// their cell, so points that merely share a hash slot with those cells are skipped without
+	// touching their positions.
+	template <typename Visitor>
+	void forEachNear(const glm::vec3 &p, Visitor &&visit) const {
+		if (slotStart.empty())
+			return;
+
+		glm::ivec3 center = cellOf(p);
+		for (int dz = -1; dz <= 1; dz++) {
+			for (int dy = -1; dy <= 1; dy++) {
+				// The three cells of a row along x have consecutive slots, usually one range
+				glm::ivec3 first = center + glm::ivec3(-1, dy, dz);
+				uint32_t slot = slotOf(first);
+				uint32_t last = slot + 3;
+				if (last > slotMask + 1) {
+					visitRow(slotStart[slot], slotStart[slotMask + 1], first, visit);
+					slot = 0;
+					last -= slotMask + 1;
+				}
+				visitRow(slotStart[slot], slotStart[last], first, visit);
+			}
+		}
+	}
+
+  private:
+	int32_t cellCoordinate(float v) const {
+		float c = std::floor(v * inverseCellSize);
+		// Far-away and non-finite points share the outermost cells instead of overflowing
+		return std::isfinite(c) ? int32_t(std::clamp(c, -1e9f, 1e9f)) : 0;
+	}
+
+	// The y and z coordinates are hashed (with the primes of Teschner et al., "Optimized Spatial
+	// Hashing for Collision Detection of Deformable Objects") and x is added, so neighbouring
+	// cells along x share cache lines of the slot table
+	uint32_t slotOf(const glm::ivec3 &cell) const {
+		uint32_t h = uint32_t(cell.y) * 19349663u ^ uint32_t(cell.z) * 83492791u;
+		return (h + uint32_t(cell.x)) & slotMask;
+	}
+
+	// Visits the entries in [begin, end) that lie in the row of three cells starting at first
+	template <typename Visitor>
+	void visitRow(uint32_t begin, uint32_t end, const glm::ivec3 &first, Visitor &visit) const {
+		for (uint32_t e = begin; e < end; e++) {
+			const glm::ivec3 &cell = entryCells[e];
+			if (cell.y == first.y && cell.z == first.z && uint32_t(cell.x - first.x) <= 2u)
+				visit(entries[e]);
+		}
+	}
+
+  private:
+	float cellSize = 1.0f, inverseCellSize = 1.0f;
+	uint32_t slotMask = 0;
+
+	// Slot s holds entries[slotStart[s], slotStart[s + 1]), sorted by point index, and
+	// entryCells holds the cell of each entry
+	std::vector<uint32_t> slotStart;
+	std::vector<uint32_t> entries;
+	std::vector<glm::ivec3> entryCells;
+
+	// Build scratch: the slot of every point and the scatter cursor of every slot
+	std::vector<uint32_t> pointSlot;
+	std::vector<uint32_t> cursor;
+	std::vector<uint32_t> chunkTotals;
+};
+
+#endif // SPATIALHASH_H
@@ -0,0 +1,304 @@
+//
+// Created by Leonard Chan on 10/15/26.
+//
+
+#include "TriangleBVH.h"
+
+#include "../Tasks/TaskScheduler.h"
+
+#include <algorithm>
+#include <numeric>
+
+static constexpr uint32_t leafSize = 4;
+static constexpr size_t triangleGrainSize = 4096;
+static constexpr size_t nodeChunkSize = 1024;
+
+// Enough self-traversal tasks to balance the load across the threads
+static constexpr size_t pairTaskTarget = 256;
+
+static float surfaceArea(const glm::vec3 &lower, const glm::vec3 &upper) {
+	glm::vec3 e = glm::max(upper - lower, glm::vec3(0.0f));
+	return 2.0f * (e.x * e.y + e.y * e.z + e.z * e.x);
+}
+
+// Distance along the ray to its entry into the box, or INFINITY if it misses within maxDistance
+static float rayBoxEntry(const TriangleBVH::Node &box,
+                         const glm::vec3 &origin,
+                         const glm::vec3 &inverseDirection,
+                         float maxDistance) {
+	glm::vec3 t0 = (box.lower - origin) * inverseDirection;
+	glm::vec3 t1 = (box.upper - origin) * inverseDirection;
+	glm::vec3 near = glm::min(t0, t1), far = glm::max(t0, t1);
+	float entry = std::max({near.x, near.y, near.z, 0.0f});
+	float exit = std::min({far.x, far.y, far.z, maxDistance});
+	return entry <= exit ? entry : INFINITY;
+}
+
+void TriangleBVH::build(const std::vector<uint32_t> &triangles, const Vec3Array &positions) {
+	TaskScheduler &scheduler = TaskScheduler::get();
+	this->triangles = &triangles;
+	this->positions = &positions;
+	const size_t triangleCount = triangles.size() / 3;
+
+	nodes.clear();
+	levelOffsets.clear();
+	triangleOrder.resize(triangleCount);
+	std::iota(triangleOrder.begin(), triangleOrder.end(), 0u);
+	if (triangleCount == 0) {
+		cost = buildCost = 0.0f;
+		return;
+	}
+
+	centroids.resize(triangleCount);
+	scheduler.parallelFor(0, triangleCount, triangleGrainSize, [&](size_t begin, size_t end) {
+		for (size_t t = begin; t < end; t++) {
+			const uint32_t *v = &triangles[3 * t];
+			centroids.set(t, (positions.get(v[0]) + positions.get(v[1]) + positions.get(v[2])) *
+			                     (1.0f / 3.0f));
+		}
+	});
+
+	// Split one level at a time. The nodes of a level cover disjoint ranges of triangleOrder, so
+	// they are partitioned in parallel; their children then form the next level.
+	nodes.push_back({glm::vec3(0.0f), 0, glm::vec3(0.0f), uint32_t(triangleCount)});
+	levelOffsets.push_back(0);
+	levelOffsets.push_back(1);
+	while (levelOffsets[levelOffsets.size() - 2] < levelOffsets.back()) {
+		const size_t levelBegin = levelOffsets[levelOffsets.size() - 2];
+		const size_t levelEnd = levelOffsets.back();
+		const size_t levelSize = levelEnd - levelBegin;
+		splits.assign(levelSize, 0);
+
+		// Aim for about triangleGrainSize triangles of partitioning per task
+		size_t grain = std::max<size_t>(1, triangleGrainSize * levelSize / triangleCount);
+		scheduler.parallelFor(levelBegin, levelEnd, grain, [&](size_t begin, size_t end) {
+			for (size_t n = begin; n < end; n++) {
+				const Node &node = nodes[n];
+				if (node.count <= leafSize)
+					continue;
+
+				uint32_t *first = triangleOrder.data() + node.first;
+				uint32_t *last = first + node.count;
+				glm::vec3 lower(INFINITY), upper(-INFINITY);
+				for (uint32_t *t = first; t < last; t++) {
+					glm::vec3 c = centroids.get(*t);
+					lower = glm::min(lower, c);
+					upper = glm::max(upper, c);
+				}
+				glm::vec3 extent = upper - lower;
+				int axis = extent.x >= extent.y && extent.x >= extent.z ? 0
+				           : extent.y >= extent.z                       ? 1
+				                                                        : 2;
+
+				// Median split; ties are broken by index so the order is fully determined
+				const float *key = centroids.component(axis);
+				uint32_t *middle = first + node.count / 2;
+				std::nth_element(first, middle, last, [key](uint32_t a, uint32_t b) {
+					return key[a] < key[b] || (key[a] == key[b] && a < b);
+				});
+				splits[n - levelBegin] = uint32_t(middle - triangleOrder.data());
+			}
+		});
+
+		for (size_t n = levelBegin; n < levelEnd; n++) {
+			uint32_t split = splits[n - levelBegin];
+			if (split == 0)
+				continue;
+			Node node = nodes[n];
+			nodes[n].first = uint32_t(nodes.size());
+			nodes[n].count = 0;
+			nodes.push_back({glm::vec3(0.0f), node.first, glm::vec3(0.0f), split - node.first});
+			nodes.push_back(
+			    {glm::vec3(0.0f), split, glm::vec3(0.0f), node.first + node.count - split});
+		}
+		levelOffsets.push_back(uint32_t(nodes.size()));
+	}
+	levelOffsets.pop_back();
+
+	triangleBoxes.resize(triangleCount);
+	refit();
+	buildCost = cost;
+}
+
+void TriangleBVH::refit() {
+	if (nodes.empty())
+		return;
+
+	// Deepest level first: leaves bound their triangles, internal nodes their children
+	TaskScheduler &scheduler = TaskScheduler::get();
+	double total = 0.0;
+	for (size_t level = levelOffsets.size() - 1; level-- > 0;) {
+		const size_t levelBegin = levelOffsets[level], levelEnd = levelOffsets[level + 1];
+		chunkCosts.resize(TaskScheduler::chunkCount(levelBegin, levelEnd, nodeChunkSize));
+		scheduler.parallelForChunks(
+		    levelBegin, levelEnd, nodeChunkSize, [&](size_t chunk, size_t begin, size_t end) {
+			    double area = 0.0;
+			    for (size_t n = begin; n < end; n++) {
+				    Node &node = nodes[n];
+				    if (node.count > 0) {
+					    node.lower = glm::vec3(INFINITY);
+					    node.upper = glm::vec3(-INFINITY);
+					    for (uint32_t k = node.first; k < node.first + node.count; k++) {
+						    const Node &box = triangleBoxes[k] = triangleBounds(triangleOrder[k]);
+						    node.lower = glm::min(node.lower, box.lower);
+						    node.upper = glm::max(node.upper, box.upper);
+					    }
+				    } else {
+					    const Node &left = nodes[node.first], &right = nodes[node.first + 1];
+					    node.lower = glm::min(left.lower, right.lower);
+					    node.upper = glm::max(left.upper, right.upper);
+				    }
+				    area += surfaceArea(node.lower, node.upper);
+			    }
+			    chunkCosts[chunk] = area;
+		    });
+		for (double area : chunkCosts) {
+			total += area;
+		}
+	}
+	cost = float(total);
+}
+
+void TriangleBVH::update() {
+	if (nodes.empty())
+		return;
+
+	refit();
+	if (cost > rebuildThreshold * buildCost) {
+		build(*triangles, *positions);
+		rebuildCount++;
+	}
+}
+
+size_t TriangleBVH::preparePairTasks() {
+	pairTasks.clear();
+	if (nodes.empty())
+		return 0;
+
+	// Expand the pairs one level at a time, the same way the traversal does, dropping pairs that
+	// do not overlap, until there are enough of them or only leaves are left
+	pairTasks.push_back({0, 0});
+	bool expanded = true;
+	while (expanded && pairTasks.size() < pairTaskTarget) {
+		expanded = false;
+		expandedTasks.clear();
+		for (const NodePair &pair : pairTasks) {
+			const Node &a = nodes[pair.a], &b = nodes[pair.b];
+			if (pair.a == pair.b) {
+				if (a.count > 0) {
+					expandedTasks.push_back(pair);
+				} else {
+					expandedTasks.push_back({a.first, a.first});
+					expandedTasks.push_back({a.first + 1, a.first + 1});
+					expandedTasks.push_back({a.first, a.first + 1});
+					expanded = true;
+				}
+			} else if (!overlaps(a, b)) {
+				continue;
+			} else if (a.count > 0 && b.count > 0) {
+				expandedTasks.push_back(pair);
+			} else if (splitsFirst(pair)) {
+				expandedTasks.push_back({a.first, pair.b});
+				expandedTasks.push_back({a.first + 1, pair.b});
+				expanded = true;
+			} else {
+				expandedTasks.push_back({pair.a, b.first});
+				expandedTasks.push_back({pair.a, b.first + 1});
+				expanded = true;
+			}
+		}
+		pairTasks.swap(expandedTasks);
+	}
+	return pairTasks.size();
+}
+
+TriangleBVH::RayHit TriangleBVH::raycast(const glm::vec3 &origin,
+                                         const glm::vec3 &direction,
+                                         float maxDistance) const {
+	if (nodes.empty())
+		return RayHit{};
+	RayHit hit;
+	hit.distance = maxDistance;
+
+	const glm::vec3 inverseDirection = 1.0f / direction;
+	uint32_t stack[maxDepth];
+	float stackEntry[maxDepth];
+	int top = 0;
+	float rootEntry = rayBoxEntry(nodes[0], origin, inverseDirection, maxDistance);
+	if (rootEntry == INFINITY)
+		return RayHit{};
+	stack[top] = 0;
+	stackEntry[top++] = rootEntry;
+
+	while (top > 0) {
+		top--;
+		// Boxes entered beyond the closest hit so far cannot hold a closer one
+		if (stackEntry[top] > hit.distance)
+			continue;
+		const Node &node = nodes[stack[top]];
+
+		if (node.count > 0) {
+			for (uint32_t k = node.first; k < node.first + node.count; k++) {
+				// Möller-Trumbore
+				uint32_t t = triangleOrder[k];
+				const uint32_t *v = &(*triangles)[3 * t];
+				glm::vec3 a = positions->get(v[0]);
+				glm::vec3 e1 = positions->get(v[1]) - a, e2 = positions->get(v[2]) - a;
+				glm::vec3 p = glm::cross(direction, e2);
+				float det = glm::dot(e1, p);
+				if (std::abs(det) < 1e-12f)
+					continue;
+				float inverseDet = 1.0f / det;
+				glm::vec3 s = origin - a;
+				float u = glm::dot(s, p) * inverseDet;
+				if (u < 0.0f || u > 1.0f)
+					continue;
+				glm::vec3 q = glm::cross(s, e1);
+				float w = glm::dot(direction, q) * inverseDet;
+				if (w < 0.0f || u + w > 1.0f)
+					continue;
+				float distance = glm::dot(e2, q) * inverseDet;
+				if (distance >= 0.0f && distance <= hit.distance) {
+					hit.triangle = int32_t(t);
+					hit.distance = distance;
+					hit.u = u;
+					hit.v = w;
+				}
+			}
+			continue;
+		}
+
+		// Push the farther child first so the nearer one is searched first
+		uint32_t children[2] = {node.first, node.first + 1};
+		float entries[2];
+		for (int c = 0; c < 2; c++) {
+			entries[c] = rayBoxEntry(nodes[children[c]], origin, inverseDirection, hit.distance);
+		}
+		if (entries[0] < entries[1]) {
+			std::swap(children[0], children[1]);
+			std::swap(entries[0], entries[1]);
+		}
+		for (int c = 0; c < 2; c++) {
+			if (entries[c] != INFINITY) {
+				stack[top] = children[c];
+				stackEntry[top++] = entries[c];
+			}
+		}
+	}
+
+	return hit.triangle >= 0 ? hit : RayHit{};
+}
+
+TriangleBVH::Node TriangleBVH::triangleBounds(uint32_t t) const {
+	const uint32_t *v = &(*triangles)[3 * t];
+	glm::vec3 a = positions->get(v[0]), b = positions->get(v[1]), c = positions->get(v[2]);
+	glm::vec3 lower = glm::min(a, glm::min(b, c)), upper = glm::max(a, glm::max(b, c));
+	if (sweepStart) {
+		a = sweepStart->get(v[0]);
+		b = sweepStart->get(v[1]);
+		c = sweepStart->get(v[2]);
+		lower = glm::min(lower, glm::min(a, glm::min(b, c)));
+		upper = glm::max(upper, glm::max(a, glm::max(b, c)));
+	}
+	return {lower - glm::vec3(margin), 0, upper + glm::vec3(margin), 0};
+}
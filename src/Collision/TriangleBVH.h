@@ -0,0 +1,197 @@
+//
+// Created by Leonard Chan on 10/15/26.
+//
+
+#ifndef TRIANGLEBVH_H
+#define TRIANGLEBVH_H
+
+#include "../ParticleState.h"
+#include "../Tasks/TaskScheduler.h"
+
+#include <cmath>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vector>
+
+// Bounding volume hierarchy of axis-aligned boxes over the triangles of a deforming mesh. The
+// tree is built once per topology, level by level with median splits along the longest axis of
+// the triangle centroids; every node of a level is split in parallel. Each step it is refitted
+// instead: the boxes are recomputed bottom-up, one level at a time in parallel, keeping the tree
+// shape. A refitted tree is always correct but can grow loose as the mesh deforms, so update()
+// rebuilds it once the summed surface area of its boxes (the surface area heuristic cost, up to
+// a constant) exceeds the cost right after the last build by the rebuild threshold.
+class TriangleBVH {
+  public:
+	// Internal nodes have count 0 and children first and first + 1; leaves cover
+	// triangleOrder[first, first + count)
+	struct Node {
+		glm::vec3 lower;
+		uint32_t first;
+		glm::vec3 upper;
+		uint32_t count;
+	};
+
+	struct RayHit {
+		int32_t triangle = -1; // -1 if nothing was hit
+		float distance = INFINITY;
+		float u = 0.0f, v = 0.0f; // barycentric weights of the second and third corner
+	};
+
+	// Builds the hierarchy over triangles (three particle indices each) at the given positions.
+	// Both must outlive the tree, which reads them again in refit() and the queries.
+	void build(const std::vector<uint32_t> &triangles, const Vec3Array &positions);
+
+	// Makes the triangle boxes cover the straight motion from start to the current positions,
+	// grown by margin, for continuous collision queries. Takes effect at the next build or
+	// refit; start must outlive the tree. nullptr restores the boxes of the current positions.
+	void setSweep(const Vec3Array *start, float margin) {
+		sweepStart = start;
+		this->margin = margin;
+	}
+
+	// Recomputes every box for the current positions
+	void refit();
+
+	// Refits, then rebuilds if the refitted tree has degraded past the rebuild threshold
+	void update();
+
+	// Summed surface area after the last refit relative to right after the last build
+	float getQuality() const { return buildCost > 0.0f ? cost / buildCost : 1.0f; }
+	void setRebuildThreshold(float threshold) { rebuildThreshold = threshold; }
+	uint64_t getRebuildCount() const { return rebuildCount; }
+
+	bool empty() const { return nodes.empty(); }
+	const std::vector<Node> &getNodes() const { return nodes; }
+
+	// Calls visit(triangle) for every triangle whose (swept) box overlaps [lower, upper]
+	template <typename Visitor>
+	void forEachOverlap(const glm::vec3 &lower, const glm::vec3 &upper, Visitor &&visit) const {
+		if (nodes.empty())
+			return;
+
+		uint32_t stack[maxDepth];
+		int top = 0;
+		stack[top++] = 0;
+		while (top > 0) {
+			const Node &node = nodes[stack[--top]];
+			if (!overlaps(node, lower, upper))
+				continue;
+			if (node.count > 0) {
+				for (uint32_t k = node.first; k < node.first + node.count; k++) {
+					if (overlaps(triangleBoxes[k], lower, upper))
+						visit(triangleOrder[k]);
+				}
+			} else {
+				stack[top++] = node.first;
+				stack[top++] = node.first + 1;
+			}
+		}
+	}
+
+	// Splits the traversal of the tree against itself into independent tasks and returns their
+	// number. The split depends only on the tree, not on the thread count.
+	size_t preparePairTasks();
+
+	// Calls visit(task, a, b) once for every unordered pair of distinct triangles whose boxes
+	// overlap, for the tasks of the last preparePairTasks(). Tasks run in parallel, each visiting
+	// its pairs in a fixed order, so results kept per task combine deterministically.
+	template <typename Visitor>
+	void forEachOverlappingPair(Visitor &&visit) const {
+		TaskScheduler::get().parallelFor(0, pairTasks.size(), 1, [&](size_t begin, size_t end) {
+			for (size_t task = begin; task < end; task++) {
+				NodePair stack[4 * maxDepth];
+				int top = 0;
+				stack[top++] = pairTasks[task];
+				while (top > 0) {
+					NodePair pair = stack[--top];
+					const Node &a = nodes[pair.a], &b = nodes[pair.b];
+					if (pair.a == pair.b) {
+						if (a.count == 0) {
+							stack[top++] = {a.first, a.first};
+							stack[top++] = {a.first + 1, a.first + 1};
+							stack[top++] = {a.first, a.first + 1};
+							continue;
+						}
+						for (uint32_t k = a.first; k < a.first + a.count; k++) {
+							for (uint32_t l = k + 1; l < a.first + a.count; l++) {
+								if (overlaps(triangleBoxes[k], triangleBoxes[l]))
+									visit(task, triangleOrder[k], triangleOrder[l]);
+							}
+						}
+						continue;
+					}
+					if (!overlaps(a, b))
+						continue;
+					if (a.count > 0 && b.count > 0) {
+						for (uint32_t k = a.first; k < a.first + a.count; k++) {
+							for (uint32_t l = b.first; l < b.first + b.count; l++) {
+								if (overlaps(triangleBoxes[k], triangleBoxes[l]))
+									visit(task, triangleOrder[k], triangleOrder[l]);
+							}
+						}
+					} else if (splitsFirst(pair)) {
+						stack[top++] = {a.first, pair.b};
+						stack[top++] = {a.first + 1, pair.b};
+					} else {
+						stack[top++] = {pair.a, b.first};
+						stack[top++] = {pair.a, b.first + 1};
+					}
+				}
+			}
+		});
+	}
+
+	// Nearest triangle hit by the ray origin + t * direction for t in [0, maxDistance]
+	RayHit raycast(const glm::vec3 &origin, const glm::vec3 &direction, float maxDistance) const;
+
+  private:
+	// Deeper than any median-split tree over 2^32 triangles
+	static constexpr int maxDepth = 64;
+
+	struct NodePair {
+		uint32_t a, b;
+	};
+
+	Node triangleBounds(uint32_t t) const;
+
+	static bool overlaps(const Node &box, const glm::vec3 &lower, const glm::vec3 &upper) {
+		return box.lower.x <= upper.x && box.lower.y <= upper.y && box.lower.z <= upper.z &&
+		       lower.x <= box.upper.x && lower.y <= box.upper.y && lower.z <= box.upper.z;
+	}
+	static bool overlaps(const Node &a, const Node &b) { return overlaps(a, b.lower, b.upper); }
+
+	// Of two distinct overlapping nodes, not both leaves, whether to descend into the first: the
+	// internal one, or the shallower one (nodes are numbered breadth-first)
+	bool splitsFirst(const NodePair &pair) const {
+		return nodes[pair.b].count > 0 || (nodes[pair.a].count == 0 && pair.a < pair.b);
+	}
+
+  private:
+	const std::vector<uint32_t> *triangles = nullptr;
+	const Vec3Array *positions = nullptr;
+	const Vec3Array *sweepStart = nullptr;
+	float margin = 0.0f;
+
+	// Nodes in breadth-first order: level d spans nodes[levelOffsets[d], levelOffsets[d + 1])
+	std::vector<Node> nodes;
+	std::vector<uint32_t> levelOffsets;
+	std::vector<uint32_t> triangleOrder;
+
+	// Box of the triangle triangleOrder[k], refitted with the nodes
+	std::vector<Node> triangleBoxes;
+
+	// Node pairs the self-traversal starts from, one per task
+	std::vector<NodePair> pairTasks, expandedTasks;
+
+	// Build scratch
+	Vec3Array centroids;
+	std::vector<uint32_t> splits;
+
+	// Summed surface area of the boxes, per chunk of a level and in total
+	std::vector<double> chunkCosts;
+	float cost = 0.0f, buildCost = 0.0f;
+	float rebuildThreshold = 1.5f;
+	uint64_t rebuildCount = 0;
+};
+
+#endif // TRIANGLEBVH_H
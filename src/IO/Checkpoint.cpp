@@ -0,0 +1,174 @@
+//
+// Created by Leonard Chan on 10/15/26.
+//
+
+#include "Checkpoint.h"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+
+namespace {
+
+uint64_t alignUp(uint64_t offset) {
+	const uint64_t a = CheckpointFormat::alignment;
+	return (offset + a - 1) / a * a;
+}
+
+} // namespace
+
+void CheckpointWriter::add(CheckpointSection id,
+                           const void *data,
+                           uint32_t elementSize,
+                           uint64_t count) {
+	sections.push_back({{uint32_t(id), elementSize, 0, count}, data});
+}
+
+void CheckpointWriter::add(CheckpointSection id, const Vec3Array &array) {
+	for (int axis = 0; axis < 3; axis++) {
+		add(CheckpointSection(uint32_t(id) + uint32_t(axis)), array.component(axis), array.size());
+	}
+}
+
+bool CheckpointWriter::write(const std::string &path) {
+	// Lay the sections out after the header and the table
+	CheckpointFormat::Header header{};
+	std::memcpy(header.magic, CheckpointFormat::magic, sizeof(header.magic));
+	header.version = CheckpointFormat::version;
+	header.byteOrderMark = CheckpointFormat::byteOrderMark;
+	header.sectionCount = uint32_t(sections.size());
+
+	uint64_t offset = sizeof(header) + sections.size() * sizeof(CheckpointFormat::Section);
+	for (Pending &pending : sections) {
+		offset = alignUp(offset);
+		pending.section.offset = offset;
+		offset += pending.section.elementSize * pending.section.count;
+	}
+	header.fileSize = offset;
+
+	const std::string temporary = path + ".tmp";
+	{
+		std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+		if (!out) {
+			error = "cannot create " + temporary;
+			return false;
+		}
+		out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+		for (const Pending &pending : sections) {
+			out.write(reinterpret_cast<const char *>(&pending.section), sizeof(pending.section));
+		}
+
+		static const char padding[CheckpointFormat::alignment] = {};
+		uint64_t written = sizeof(header) + sections.size() * sizeof(CheckpointFormat::Section);
+		for (const Pending &pending : sections) {
+			out.write(padding, std::streamsize(pending.section.offset - written));
+			uint64_t bytes = pending.section.elementSize * pending.section.count;
+			if (bytes > 0)
+				out.write(static_cast<const char *>(pending.data), std::streamsize(bytes));
+			written = pending.section.offset + bytes;
+		}
+		out.flush();
+		if (!out) {
+			error = "cannot write " + temporary;
+			out.close();
+			std::remove(temporary.c_str());
+			return false;
+		}
+	}
+
+	std::error_code code;
+	std::filesystem::rename(temporary, path, code);
+	if (code) {
+		error = "cannot replace " + path + ": " + code.message();
+		std::remove(temporary.c_str());
+		return false;
+	}
+	return true;
+}
+
+bool CheckpointReader::open(const std::string &path) {
+	sections = nullptr;
+	sectionCount = 0;
+	if (!file.open(path)) {
+		error = file.getError();
+		return false;
+	}
+
+	const char *data = file.data();
+	const size_t size = file.size();
+	CheckpointFormat::Header header;
+	if (size < sizeof(header)) {
+		error = path + " is not a checkpoint";
+		return false;
+	}
+	std::memcpy(&header, data, sizeof(header));
+	if (std::memcmp(header.magic, CheckpointFormat::magic, sizeof(header.magic)) != 0) {
+		error = path + " is not a checkpoint";
+		return false;
+	}
+	if (header.byteOrderMark != CheckpointFormat::byteOrderMark) {
+		error = path + " was written on a machine with another byte order";
+		return false;
+	}
+	if (header.version != CheckpointFormat::version) {
+		error = path + " is checkpoint version " + std::to_string(header.version) +
+		        ", expected " + std::to_string(CheckpointFormat::version);
+		return false;
+	}
+	if (header.fileSize != size ||
+	    header.sectionCount > (size - sizeof(header)) / sizeof(CheckpointFormat::Section)) {
+		error = path + " is truncated";
+		return false;
+	}
+
+	// The table sits right after the header, which keeps it 8-byte aligned in the mapping
+	sections = reinterpret_cast<const CheckpointFormat::Section *>(data + sizeof(header));
+	sectionCount = header.sectionCount;
+	for (uint32_t s = 0; s < sectionCount; s++) {
+		const CheckpointFormat::Section &section = sections[s];
+		bool inside = section.offset <= size &&
+		              (section.elementSize == 0 ||
+		               section.count <= (size - section.offset) / section.elementSize);
+		if (section.offset % CheckpointFormat::alignment != 0 || !inside) {
+			error = path + " has a section outside the file";
+			sections = nullptr;
+			sectionCount = 0;
+			return false;
+		}
+	}
+	return true;
+}
+
+const void *CheckpointReader::find(CheckpointSection id,
+                                   uint32_t elementSize,
+                                   size_t &count) const {
+	count = 0;
+	for (uint32_t s = 0; s < sectionCount; s++) {
+		const CheckpointFormat::Section &section = sections[s];
+		if (section.id != uint32_t(id))
+			continue;
+		if (section.elementSize != elementSize)
+			return nullptr;
+		count = size_t(section.count);
+		return file.data() + section.offset;
+	}
+	return nullptr;
+}
+
+bool CheckpointReader::copy(CheckpointSection id, size_t count, Vec3Array &array) const {
+	const float *axes[3];
+	for (int axis = 0; axis < 3; axis++) {
+		size_t n = 0;
+		axes[axis] = get<float>(CheckpointSection(uint32_t(id) + uint32_t(axis)), n);
+		if (!axes[axis] || n != count)
+			return false;
+	}
+	array.resize(count);
+	for (int axis = 0; axis < 3; axis++) {
+		if (count > 0)
+			std::memcpy(array.component(axis), axes[axis], count * sizeof(float));
+	}
+	return true;
+}
@@ -0,0 +1,132 @@
+//
+// Created by Leonard Chan on 10/15/26.
+//
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include "../ParticleState.h"
+#include "MappedFile.h"
+
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Sections of a cloth checkpoint. Each Vec3Array takes three consecutive ids, one per axis. Ids
+// are never reused, so a reader can tell what a section holds whatever version wrote it.
+enum class CheckpointSection : uint32_t {
+	PARAMETERS = 1,
+	INVERSE_MASS = 2,
+	PINNED = 3,
+	SPRINGS = 4,
+	SPRING_COLOR_OFFSETS = 5,
+	TRIANGLES = 6,
+	PARTICLE_SOURCES = 7,
+	POSITIONS = 16,            // 16-18
+	VELOCITIES = 20,           // 20-22
+	INTEGRATOR_POSITIONS = 64, // 64-66
+	INTEGRATOR_STEP_SIZE = 68,
+};
+
+// A checkpoint file is a header, a table of sections, and the sections' raw arrays, each starting
+// on a 64-byte boundary like the simulation's own arrays. The format is the in-memory layout of
+// the machine that wrote it; files from a machine with another byte order, or another size of a
+// section's element type, are rejected rather than converted.
+struct CheckpointFormat {
+	static constexpr char magic[8] = {'L', 'O', 'O', 'M', 'I', 'X', 'C', 'P'};
+	static constexpr uint32_t version = 1;
+	static constexpr uint32_t byteOrderMark = 0x01020304;
+	static constexpr uint64_t alignment = 64;
+
+	struct Header {
+		char magic[8];
+		uint32_t version;
+		uint32_t byteOrderMark;
+		uint32_t sectionCount;
+		uint32_t reserved;
+		uint64_t fileSize;
+	};
+
+	struct Section {
+		uint32_t id;
+		uint32_t elementSize;
+		uint64_t offset; // from the start of the file
+		uint64_t count;  // elements
+	};
+};
+
+// Collects sections and writes them out in one go. Only pointers are kept until write(), so the
+// arrays must outlive it.
+class CheckpointWriter {
+  public:
+	void add(CheckpointSection id, const void *data, uint32_t elementSize, uint64_t count);
+
+	template <typename T> void add(CheckpointSection id, const T *data, size_t count) {
+		static_assert(std::is_trivially_copyable_v<T>, "sections hold raw bytes");
+		add(id, static_cast<const void *>(data), uint32_t(sizeof(T)), uint64_t(count));
+	}
+	template <typename T, typename Allocator>
+	void add(CheckpointSection id, const std::vector<T, Allocator> &values) {
+		add(id, values.data(), values.size());
+	}
+	template <typename T> void addValue(CheckpointSection id, const T &value) {
+		add(id, &value, 1);
+	}
+
+	// Three sections, id to id + 2, one per axis
+	void add(CheckpointSection id, const Vec3Array &array);
+
+	// Writes to a temporary file next to path and renames it over path, so an interrupted write
+	// never leaves a truncated checkpoint behind. On failure returns false, leaving the reason in
+	// getError().
+	bool write(const std::string &path);
+
+	const std::string &getError() const { return error; }
+
+  private:
+	struct Pending {
+		CheckpointFormat::Section section;
+		const void *data;
+	};
+	std::vector<Pending> sections;
+	std::string error;
+};
+
+// Maps a checkpoint and checks its header and section table. Sections are then read in place:
+// get() turns a section's file offset into a typed pointer into the mapping, so nothing is
+// parsed or copied until the caller copies the arrays it needs.
+class CheckpointReader {
+  public:
+	// On failure returns false, leaving the reason in getError()
+	bool open(const std::string &path);
+
+	// The elements of section id and their count, or nullptr if the file has no such section or
+	// its elements are not the size of T
+	template <typename T> const T *get(CheckpointSection id, size_t &count) const {
+		static_assert(std::is_trivially_copyable_v<T>, "sections hold raw bytes");
+		return static_cast<const T *>(find(id, uint32_t(sizeof(T)), count));
+	}
+
+	// A single value, which must be the only element of its section
+	template <typename T> const T *getValue(CheckpointSection id) const {
+		size_t count = 0;
+		const T *value = get<T>(id, count);
+		return count == 1 ? value : nullptr;
+	}
+
+	// Copies the three sections of a Vec3Array if each holds count floats
+	bool copy(CheckpointSection id, size_t count, Vec3Array &array) const;
+
+	const std::string &getError() const { return error; }
+
+  private:
+	const void *find(CheckpointSection id, uint32_t elementSize, size_t &count) const;
+
+	MappedFile file;
+	const CheckpointFormat::Section *sections = nullptr;
+	uint32_t sectionCount = 0;
+	std::string error;
+};
+
+#endif // CHECKPOINT_H
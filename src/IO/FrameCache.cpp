@@ -0,0 +1,549 @@
+//
+// Created by Leonard Chan on 10/15/26.
+//
+
+#include "FrameCache.h"
+
+#include "../Utilities/Timer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <utility>
+
+namespace {
+
+// Every difference fits in 35 bits once zig-zagged, so five 7-bit groups
+constexpr size_t maxVarintBytes = 5;
+
+uint64_t zigzag(int64_t value) { return (uint64_t(value) << 1) ^ uint64_t(value >> 63); }
+int64_t unzigzag(uint64_t value) { return int64_t(value >> 1) ^ -int64_t(value & 1); }
+
+uint8_t *putVarint(uint8_t *out, uint64_t value) {
+	while (value >= 0x80) {
+		*out++ = uint8_t(value) | 0x80;
+		value >>= 7;
+	}
+	*out++ = uint8_t(value);
+	return out;
+}
+
+// Returns false on a varint that runs past end or is longer than any the writer makes
+bool getVarint(const uint8_t *&in, const uint8_t *end, uint64_t &value) {
+	value = 0;
+	for (int shift = 0; shift < 64 && in < end; shift += 7) {
+		uint8_t byte = *in++;
+		value |= uint64_t(byte & 0x7F) << shift;
+		if (byte < 0x80)
+			return true;
+	}
+	return false;
+}
+
+int32_t quantize(float value, float scale) {
+	float scaled = value * scale;
+	if (std::isnan(scaled))
+		return 0;
+	scaled = std::clamp(scaled, -2147483520.0f, 2147483520.0f);
+	return int32_t(std::lrint(scaled));
+}
+
+// Where a particle would be a frame after beforeLast and last if it kept its velocity
+int64_t predict(int32_t beforeLast, int32_t last) { return 2 * int64_t(last) - beforeLast; }
+
+} // namespace
+
+bool FrameCacheWriter::open(const std::string &path, const FrameCacheOptions &options) {
+	close();
+	this->options = options;
+	this->options.keyframeInterval = std::max(this->options.keyframeInterval, 1u);
+	this->options.queueLength = std::max(this->options.queueLength, size_t(1));
+	if (!(this->options.quantum > 0.0f)) {
+		error = "the quantum must be positive";
+		return false;
+	}
+
+	out.open(path, std::ios::binary | std::ios::trunc);
+	if (!out) {
+		error = "cannot create " + path;
+		return false;
+	}
+	FrameCacheFormat::Header header{};
+	std::memcpy(header.magic, FrameCacheFormat::magic, sizeof(header.magic));
+	header.version = FrameCacheFormat::version;
+	header.byteOrderMark = FrameCacheFormat::byteOrderMark;
+	header.quantum = this->options.quantum;
+	header.keyframeInterval = this->options.keyframeInterval;
+	out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+	if (!out) {
+		error = "cannot write " + path;
+		out.close();
+		return false;
+	}
+
+	frames.assign(this->options.queueLength, Frame{});
+	queued.clear();
+	idle.clear();
+	for (size_t f = 0; f < frames.size(); f++) {
+		idle.push_back(f);
+	}
+	closing = false;
+	stallMillis = 0.0f;
+	index.clear();
+	fileOffset = sizeof(header);
+	lastKeyframe = 0;
+	lastMeshFrame = FrameCacheFormat::noMesh;
+	failed = false;
+	framesWritten.store(0);
+	bytesWritten.store(sizeof(header));
+	rawBytes.store(0);
+	error.clear();
+
+	thread = std::thread([this]() { run(); });
+	opened = true;
+	return true;
+}
+
+void FrameCacheWriter::addFrame(float time,
+                                const Vec3Array &positions,
+                                const std::vector<uint32_t> *triangles,
+                                const Cloth::TrianglePatch *patches,
+                                size_t patchCount) {
+	if (!opened)
+		return;
+
+	size_t slot;
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		if (idle.empty()) {
+			Timer timer;
+			frameWritten.wait(lock, [&]() { return !idle.empty(); });
+			stallMillis += timer.elapsedMillis();
+		}
+		slot = idle.front();
+		idle.pop_front();
+	}
+
+	// The buffers keep their capacity, so this only allocates while the queue fills up
+	Frame &frame = frames[slot];
+	frame.time = time;
+	frame.positions = positions;
+	frame.hasMesh = triangles != nullptr;
+	if (triangles)
+		frame.triangles = *triangles;
+	else
+		frame.triangles.clear();
+	if (triangles || patchCount == 0)
+		frame.patches.clear();
+	else
+		frame.patches.assign(patches, patches + patchCount);
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		queued.push_back(slot);
+	}
+	frameQueued.notify_one();
+}
+
+bool FrameCacheWriter::close() {
+	if (!opened)
+		return true;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		closing = true;
+	}
+	frameQueued.notify_one();
+	thread.join();
+	opened = false;
+
+	// The index goes after the last record, and the header is rewritten to point to it
+	FrameCacheFormat::Header header{};
+	std::memcpy(header.magic, FrameCacheFormat::magic, sizeof(header.magic));
+	header.version = FrameCacheFormat::version;
+	header.byteOrderMark = FrameCacheFormat::byteOrderMark;
+	header.quantum = options.quantum;
+	header.keyframeInterval = options.keyframeInterval;
+	header.indexOffset = fileOffset;
+	header.frameCount = index.size();
+	if (!failed) {
+		out.write(reinterpret_cast<const char *>(index.data()),
+		          std::streamsize(index.size() * sizeof(FrameCacheFormat::IndexEntry)));
+		out.seekp(0);
+		out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+		out.flush();
+		if (!out) {
+			error = "cannot write the frame cache index";
+			failed = true;
+		} else {
+			bytesWritten.fetch_add(index.size() * sizeof(FrameCacheFormat::IndexEntry));
+		}
+	}
+	out.close();
+
+	frames.clear();
+	index.clear();
+	index.shrink_to_fit();
+	for (int axis = 0; axis < 3; axis++) {
+		last[axis] = {};
+		beforeLast[axis] = {};
+	}
+	return !failed;
+}
+
+void FrameCacheWriter::run() {
+	while (true) {
+		size_t slot;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			frameQueued.wait(lock, [&]() { return closing || !queued.empty(); });
+			if (queued.empty())
+				return;
+			slot = queued.front();
+			queued.pop_front();
+		}
+
+		if (!failed)
+			encode(frames[slot]);
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			idle.push_back(slot);
+		}
+		frameWritten.notify_one();
+	}
+}
+
+void FrameCacheWriter::encode(const Frame &frame) {
+	const size_t n = frame.positions.size();
+	const uint32_t number = uint32_t(index.size());
+	const bool keyframe = number == 0 || number - lastKeyframe >= options.keyframeInterval ||
+	                      n != last[0].size();
+	const bool predicting = !keyframe && number - lastKeyframe >= 2;
+
+	FrameCacheFormat::Record record{};
+	record.magic = FrameCacheFormat::recordMagic;
+	record.flags = keyframe ? uint32_t(FrameCacheFormat::KEYFRAME) : 0u;
+	record.particleCount = uint32_t(n);
+	record.time = frame.time;
+
+	payload.resize((frame.triangles.size() + 1 + 2 * (frame.patches.size() + 1) + 3 * n) *
+	               maxVarintBytes);
+	uint8_t *cursor = payload.data();
+
+	// Topology: indices as differences to the index before them, which neighbouring triangles
+	// keep small
+	if (frame.hasMesh) {
+		record.flags |= FrameCacheFormat::MESH;
+		cursor = putVarint(cursor, frame.triangles.size());
+		int64_t previous = 0;
+		for (uint32_t vertex : frame.triangles) {
+			cursor = putVarint(cursor, zigzag(int64_t(vertex) - previous));
+			previous = vertex;
+		}
+	} else if (!frame.patches.empty()) {
+		record.flags |= FrameCacheFormat::PATCHES;
+		cursor = putVarint(cursor, frame.patches.size());
+		int64_t previous = 0;
+		for (const Cloth::TrianglePatch &patch : frame.patches) {
+			cursor = putVarint(cursor, zigzag(int64_t(patch.corner) - previous));
+			cursor = putVarint(cursor, patch.particle);
+			previous = patch.corner;
+		}
+	}
+	record.topologyBytes = uint32_t(cursor - payload.data());
+
+	// Positions, one axis after another. The rounded values replace those of the frame before
+	// last as they are used, and the two buffers swap roles afterwards.
+	const float scale = 1.0f / options.quantum;
+	for (int axis = 0; axis < 3; axis++) {
+		const float *p = frame.positions.component(axis);
+		std::vector<int32_t> &lastAxis = last[axis], &beforeLastAxis = beforeLast[axis];
+		beforeLastAxis.resize(n);
+		if (keyframe) {
+			int64_t previous = 0;
+			for (size_t i = 0; i < n; i++) {
+				int32_t q = quantize(p[i], scale);
+				cursor = putVarint(cursor, zigzag(q - previous));
+				previous = q;
+				beforeLastAxis[i] = q;
+			}
+		} else if (predicting) {
+			for (size_t i = 0; i < n; i++) {
+				int32_t q = quantize(p[i], scale);
+				cursor = putVarint(cursor, zigzag(q - predict(beforeLastAxis[i], lastAxis[i])));
+				beforeLastAxis[i] = q;
+			}
+		} else {
+			for (size_t i = 0; i < n; i++) {
+				int32_t q = quantize(p[i], scale);
+				cursor = putVarint(cursor, zigzag(int64_t(q) - lastAxis[i]));
+				beforeLastAxis[i] = q;
+			}
+		}
+		std::swap(lastAxis, beforeLastAxis);
+	}
+	record.payloadBytes = uint32_t(cursor - payload.data());
+
+	out.write(reinterpret_cast<const char *>(&record), sizeof(record));
+	out.write(reinterpret_cast<const char *>(payload.data()), record.payloadBytes);
+	if (!out) {
+		failed = true;
+		error = "cannot write frame " + std::to_string(number);
+		return;
+	}
+
+	if (keyframe)
+		lastKeyframe = number;
+	if (frame.hasMesh)
+		lastMeshFrame = number;
+
+	FrameCacheFormat::IndexEntry entry{};
+	entry.offset = fileOffset;
+	entry.flags = record.flags;
+	entry.particleCount = record.particleCount;
+	entry.payloadBytes = record.payloadBytes;
+	entry.topologyBytes = record.topologyBytes;
+	entry.time = record.time;
+	entry.keyframe = lastKeyframe;
+	entry.meshFrame = lastMeshFrame;
+	index.push_back(entry);
+
+	const uint64_t bytes = sizeof(record) + record.payloadBytes;
+	fileOffset += bytes;
+	bytesWritten.fetch_add(bytes, std::memory_order_relaxed);
+	rawBytes.fetch_add(3 * n * sizeof(float), std::memory_order_relaxed);
+	framesWritten.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool FrameCacheReader::open(const std::string &path) {
+	index.clear();
+	complete = false;
+	decodedFrame = SIZE_MAX;
+	if (!file.open(path)) {
+		error = file.getError();
+		return false;
+	}
+
+	const char *data = file.data();
+	const size_t size = file.size();
+	FrameCacheFormat::Header header;
+	if (size < sizeof(header)) {
+		error = path + " is not a frame cache";
+		return false;
+	}
+	std::memcpy(&header, data, sizeof(header));
+	if (std::memcmp(header.magic, FrameCacheFormat::magic, sizeof(header.magic)) != 0) {
+		error = path + " is not a frame cache";
+		return false;
+	}
+	if (header.byteOrderMark != FrameCacheFormat::byteOrderMark) {
+		error = path + " was written on a machine with another byte order";
+		return false;
+	}
+	if (header.version != FrameCacheFormat::version) {
+		error = path + " is frame cache version " + std::to_string(header.version) +
+		        ", expected " + std::to_string(FrameCacheFormat::version);
+		return false;
+	}
+	if (!(header.quantum > 0.0f)) {
+		error = path + " has an invalid quantum";
+		return false;
+	}
+	quantum = header.quantum;
+
+	// Whether a record of the given size fits at offset
+	auto fits = [&](uint64_t offset, uint64_t payloadBytes) {
+		return offset >= sizeof(header) && offset <= size &&
+		       size - offset >= sizeof(FrameCacheFormat::Record) &&
+		       size - offset - sizeof(FrameCacheFormat::Record) >= payloadBytes;
+	};
+
+	using Entry = FrameCacheFormat::IndexEntry;
+	if (header.indexOffset != 0) {
+		if (header.indexOffset > size ||
+		    header.frameCount != (size - header.indexOffset) / sizeof(Entry) ||
+		    (size - header.indexOffset) % sizeof(Entry) != 0) {
+			error = path + " is truncated";
+			return false;
+		}
+		index.resize(header.frameCount);
+		if (!index.empty())
+			std::memcpy(index.data(), data + header.indexOffset, index.size() * sizeof(Entry));
+		complete = true;
+	} else {
+		// The writer never closed the cache: index the records that made it to the disk
+		uint64_t offset = sizeof(header);
+		FrameCacheFormat::Record record;
+		while (fits(offset, 0)) {
+			std::memcpy(&record, data + offset, sizeof(record));
+			bool first = index.empty();
+			if (record.magic != FrameCacheFormat::recordMagic ||
+			    !fits(offset, record.payloadBytes) ||
+			    (first && !(record.flags & FrameCacheFormat::KEYFRAME)))
+				break;
+
+			Entry entry{};
+			entry.offset = offset;
+			entry.flags = record.flags;
+			entry.particleCount = record.particleCount;
+			entry.payloadBytes = record.payloadBytes;
+			entry.topologyBytes = record.topologyBytes;
+			entry.time = record.time;
+			uint32_t number = uint32_t(index.size());
+			entry.keyframe = record.flags & FrameCacheFormat::KEYFRAME ? number
+			                                                           : index.back().keyframe;
+			entry.meshFrame = record.flags & FrameCacheFormat::MESH ? number
+			                  : first                                ? FrameCacheFormat::noMesh
+			                                                         : index.back().meshFrame;
+			index.push_back(entry);
+			offset += sizeof(record) + record.payloadBytes;
+		}
+	}
+
+	// Check what decoding relies on, so a damaged cache is rejected here rather than misread
+	for (size_t f = 0; f < index.size(); f++) {
+		const Entry &entry = index[f];
+		FrameCacheFormat::Record record;
+		bool valid = fits(entry.offset, entry.payloadBytes) &&
+		             entry.topologyBytes <= entry.payloadBytes && entry.keyframe <= f &&
+		             (index[entry.keyframe].flags & FrameCacheFormat::KEYFRAME) &&
+		             (entry.meshFrame == FrameCacheFormat::noMesh ||
+		              (entry.meshFrame <= f &&
+		               (index[entry.meshFrame].flags & FrameCacheFormat::MESH)));
+		if (valid && !(entry.flags & FrameCacheFormat::KEYFRAME))
+			valid = f > 0 && entry.particleCount == index[f - 1].particleCount;
+		if (valid) {
+			std::memcpy(&record, data + entry.offset, sizeof(record));
+			valid = record.magic == FrameCacheFormat::recordMagic &&
+			        record.payloadBytes == entry.payloadBytes;
+		}
+		if (!valid) {
+			error = path + " has a corrupt index at frame " + std::to_string(f);
+			index.clear();
+			return false;
+		}
+	}
+	return true;
+}
+
+bool FrameCacheReader::decode(size_t frame) {
+	const FrameCacheFormat::IndexEntry &entry = index[frame];
+	const uint8_t *base = reinterpret_cast<const uint8_t *>(file.data()) + entry.offset +
+	                      sizeof(FrameCacheFormat::Record);
+	const uint8_t *in = base + entry.topologyBytes;
+	const uint8_t *end = base + entry.payloadBytes;
+	const size_t n = entry.particleCount;
+	const bool keyframe = entry.keyframe == frame;
+	const bool predicting = !keyframe && frame - entry.keyframe >= 2;
+
+	// As in the writer, the new values replace the frame before last and the buffers swap
+	for (int axis = 0; axis < 3; axis++) {
+		std::vector<int32_t> &currentAxis = current[axis], &previousAxis = previous[axis];
+		previousAxis.resize(n);
+		int64_t value = 0;
+		for (size_t i = 0; i < n; i++) {
+			uint64_t difference;
+			if (!getVarint(in, end, difference))
+				return false;
+			if (keyframe)
+				value += unzigzag(difference);
+			else if (predicting)
+				value = predict(previousAxis[i], currentAxis[i]) + unzigzag(difference);
+			else
+				value = currentAxis[i] + unzigzag(difference);
+			previousAxis[i] = int32_t(value);
+		}
+		std::swap(currentAxis, previousAxis);
+	}
+	return in == end;
+}
+
+bool FrameCacheReader::readFrame(size_t frame, Vec3Array &positions) {
+	if (frame >= index.size()) {
+		error = "frame " + std::to_string(frame) + " is not in the cache";
+		return false;
+	}
+
+	// Continue from the frame decoded last when it lies between the keyframe and this frame
+	size_t keyframe = index[frame].keyframe;
+	size_t first = decodedFrame != SIZE_MAX && decodedFrame >= keyframe && decodedFrame <= frame
+	                   ? decodedFrame + 1
+	                   : keyframe;
+	for (size_t f = first; f <= frame; f++) {
+		if (!decode(f)) {
+			error = "frame " + std::to_string(f) + " is corrupt";
+			decodedFrame = SIZE_MAX;
+			return false;
+		}
+		decodedFrame = f;
+	}
+
+	const size_t n = index[frame].particleCount;
+	positions.resize(n);
+	for (int axis = 0; axis < 3; axis++) {
+		float *p = positions.component(axis);
+		const int32_t *q = current[axis].data();
+		for (size_t i = 0; i < n; i++) {
+			p[i] = float(q[i]) * quantum;
+		}
+	}
+	return true;
+}
+
+bool FrameCacheReader::readTriangles(size_t frame, std::vector<uint32_t> &triangles) {
+	if (frame >= index.size()) {
+		error = "frame " + std::to_string(frame) + " is not in the cache";
+		return false;
+	}
+	const uint32_t meshFrame = index[frame].meshFrame;
+	if (meshFrame == FrameCacheFormat::noMesh) {
+		error = "the cache holds no triangles at frame " + std::to_string(frame);
+		return false;
+	}
+
+	auto topology = [&](size_t f, const uint8_t *&end) {
+		const FrameCacheFormat::IndexEntry &entry = index[f];
+		const uint8_t *base = reinterpret_cast<const uint8_t *>(file.data()) + entry.offset +
+		                      sizeof(FrameCacheFormat::Record);
+		end = base + entry.topologyBytes;
+		return base;
+	};
+	auto corrupt = [&](size_t f) {
+		error = "the triangles of frame " + std::to_string(f) + " are corrupt";
+		triangles.clear();
+		return false;
+	};
+
+	const uint8_t *end;
+	const uint8_t *in = topology(meshFrame, end);
+	uint64_t count, difference;
+	if (!getVarint(in, end, count) || count > uint64_t(end - in))
+		return corrupt(meshFrame);
+	triangles.resize(count);
+	int64_t vertex = 0;
+	for (uint32_t &t : triangles) {
+		if (!getVarint(in, end, difference))
+			return corrupt(meshFrame);
+		vertex += unzigzag(difference);
+		t = uint32_t(vertex);
+	}
+
+	for (size_t f = size_t(meshFrame) + 1; f <= frame; f++) {
+		if (!(index[f].flags & FrameCacheFormat::PATCHES))
+			continue;
+		in = topology(f, end);
+		if (!getVarint(in, end, count))
+			return corrupt(f);
+		int64_t corner = 0;
+		for (uint64_t p = 0; p < count; p++) {
+			uint64_t particle;
+			if (!getVarint(in, end, difference) || !getVarint(in, end, particle))
+				return corrupt(f);
+			corner += unzigzag(difference);
+			if (corner < 0 || uint64_t(corner) >= triangles.size())
+				return corrupt(f);
+			triangles[size_t(corner)] = uint32_t(particle);
+		}
+	}
+	return true;
+}
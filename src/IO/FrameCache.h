@@ -0,0 +1,210 @@
+//
+// Created by Leonard Chan on 10/15/26.
+//
+
+#ifndef FRAMECACHE_H
+#define FRAMECACHE_H
+
+#include "../Cloth.h"
+#include "../ParticleState.h"
+#include "MappedFile.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// A frame cache records the particle positions of a simulation, frame by frame, for offline
+// rendering and playback. Positions are rounded to multiples of a quantum and stored as integers:
+// every keyframe whole (each particle as a difference to the one before it, which is small on a
+// cloth), and the frames between as differences to where the two frames before them predict each
+// particle to be if it kept its velocity, all as variable-length integers. Differences are taken
+// between the rounded values, so rounding errors never add up and every frame is within about
+// half a quantum of what was simulated. The triangles are stored with the first frame, again
+// whenever the mesh is replaced, and as patches when it tears.
+//
+// The file is a header, the frame records, and an index of the records, which the header points
+// to once the writer is closed. Every record also carries its own header, so a cache whose writer
+// never closed can still be read by walking the records.
+struct FrameCacheFormat {
+	static constexpr char magic[8] = {'L', 'O', 'O', 'M', 'I', 'X', 'F', 'C'};
+	static constexpr uint32_t version = 1;
+	static constexpr uint32_t byteOrderMark = 0x01020304;
+	static constexpr uint32_t recordMagic = 0x454D5246; // "FRME"
+	static constexpr uint32_t noMesh = UINT32_MAX;
+
+	enum Flags : uint32_t {
+		KEYFRAME = 1, // positions stored whole rather than as differences
+		MESH = 2,     // the whole triangle list precedes the positions
+		PATCHES = 4,  // triangle patches since the previous frame precede the positions
+	};
+
+	struct Header {
+		char magic[8];
+		uint32_t version;
+		uint32_t byteOrderMark;
+		float quantum;
+		uint32_t keyframeInterval;
+		uint64_t indexOffset; // 0 until the writer is closed
+		uint64_t frameCount;
+	};
+
+	struct Record {
+		uint32_t magic;
+		uint32_t flags;
+		uint32_t particleCount;
+		uint32_t payloadBytes;
+		float time;
+		uint32_t topologyBytes; // of the payload, before the positions
+	};
+
+	struct IndexEntry {
+		uint64_t offset; // of the record header
+		uint32_t flags;
+		uint32_t particleCount;
+		uint32_t payloadBytes;
+		uint32_t topologyBytes;
+		float time;
+		uint32_t keyframe;  // latest keyframe at or before this frame
+		uint32_t meshFrame; // latest frame at or before this one holding the mesh, or noMesh
+		uint32_t reserved;
+	};
+};
+
+struct FrameCacheOptions {
+	// Every keyframeInterval-th frame is stored whole, which bounds how many frames a seek has to
+	// decode. A frame whose particle count changed (the cloth tore) is always a keyframe.
+	uint32_t keyframeInterval = 30;
+
+	// Positions are rounded to multiples of this, in world units
+	float quantum = 1e-4f;
+
+	// Frames waiting to be written before addFrame() blocks
+	size_t queueLength = 16;
+};
+
+// Streams frames to a cache from a background thread. addFrame() only copies the positions into
+// a recycled buffer and queues it; rounding, encoding and writing happen on the writer thread, so
+// the simulation only waits if the disk falls queueLength frames behind.
+class FrameCacheWriter {
+  public:
+	FrameCacheWriter() = default;
+	~FrameCacheWriter() { close(); }
+
+	FrameCacheWriter(const FrameCacheWriter &) = delete;
+	FrameCacheWriter &operator=(const FrameCacheWriter &) = delete;
+
+	// Creates the cache and starts the writer thread. On failure returns false, leaving the
+	// reason in getError().
+	bool open(const std::string &path, const FrameCacheOptions &options = {});
+
+	// Queues a frame. triangles is the whole mesh, passed with the first frame and whenever the
+	// mesh is replaced (nullptr otherwise); patches are the triangle patches since the previous
+	// frame, and are dropped on a frame that passes the mesh, which already includes them.
+	void addFrame(float time,
+	              const Vec3Array &positions,
+	              const std::vector<uint32_t> *triangles,
+	              const Cloth::TrianglePatch *patches,
+	              size_t patchCount);
+
+	// Writes the queued frames and the index and closes the file. Returns false if any write
+	// failed.
+	bool close();
+
+	bool isOpen() const { return opened; }
+	const std::string &getError() const { return error; }
+
+	// Frames written so far, the bytes they took, and the bytes they would take as raw floats
+	uint64_t getFrameCount() const { return framesWritten.load(std::memory_order_relaxed); }
+	uint64_t getBytesWritten() const { return bytesWritten.load(std::memory_order_relaxed); }
+	uint64_t getRawBytes() const { return rawBytes.load(std::memory_order_relaxed); }
+
+	// Time addFrame() spent waiting for a free buffer
+	float getStallMillis() const { return stallMillis; }
+
+  private:
+	struct Frame {
+		float time = 0.0f;
+		Vec3Array positions;
+		bool hasMesh = false;
+		std::vector<uint32_t> triangles;
+		std::vector<Cloth::TrianglePatch> patches;
+	};
+
+	void run();
+	void encode(const Frame &frame);
+
+  private:
+	FrameCacheOptions options;
+	std::ofstream out;
+	bool opened = false;
+	std::string error;
+
+	std::thread thread;
+	std::mutex mutex;
+	std::condition_variable frameQueued, frameWritten;
+	std::vector<Frame> frames;       // queueLength buffers, recycled
+	std::deque<size_t> queued, idle; // indices into frames, guarded by mutex
+	bool closing = false;            // guarded by mutex
+	float stallMillis = 0.0f;        // caller thread only
+
+	// Writer thread only: the rounded positions of the last two frames written, the index, and
+	// the encoding buffer
+	std::vector<int32_t> last[3], beforeLast[3];
+	std::vector<FrameCacheFormat::IndexEntry> index;
+	std::vector<uint8_t> payload;
+	uint64_t fileOffset = 0;
+	uint32_t lastKeyframe = 0, lastMeshFrame = FrameCacheFormat::noMesh;
+	bool failed = false;
+
+	std::atomic<uint64_t> framesWritten{0}, bytesWritten{0}, rawBytes{0};
+};
+
+// Reads a cache through a memory mapping. Frames can be read in any order: a frame is decoded
+// from the latest keyframe before it, or onward from the frame read last when that is closer, so
+// playing forwards decodes each frame once and scrubbing costs at most a keyframe interval.
+class FrameCacheReader {
+  public:
+	// On failure returns false, leaving the reason in getError()
+	bool open(const std::string &path);
+
+	size_t getFrameCount() const { return index.size(); }
+	float getFrameTime(size_t frame) const { return index[frame].time; }
+	uint32_t getParticleCount(size_t frame) const { return index[frame].particleCount; }
+	float getQuantum() const { return quantum; }
+
+	// Whether the writer closed the cache; an unclosed cache was indexed by walking the records
+	bool isComplete() const { return complete; }
+
+	// The positions at a frame. Returns false if the frame's data is corrupt.
+	bool readFrame(size_t frame, Vec3Array &positions);
+
+	// The triangles at a frame: the latest whole mesh, with the patches since applied. Returns
+	// false if the cache holds no mesh or its data is corrupt.
+	bool readTriangles(size_t frame, std::vector<uint32_t> &triangles);
+
+	const std::string &getError() const { return error; }
+
+  private:
+	// Decodes frame into current, which must hold frame - 1 and previous frame - 2 as far as
+	// frame's prediction needs them
+	bool decode(size_t frame);
+
+  private:
+	MappedFile file;
+	std::vector<FrameCacheFormat::IndexEntry> index;
+	float quantum = 0.0f;
+	bool complete = false;
+	std::string error;
+
+	// Rounded positions of decodedFrame and the frame before it
+	std::vector<int32_t> current[3], previous[3];
+	size_t decodedFrame = SIZE_MAX;
+};
+
+#endif // FRAMECACHE_H
@@ -0,0 +1,107 @@
+//
+// Created by Leonard Chan on 10/15/26.
+//
+
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string &path) {
+	close();
+	HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+	                            FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (handle == INVALID_HANDLE_VALUE) {
+		error = "cannot open " + path;
+		return false;
+	}
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(handle, &fileSize)) {
+		CloseHandle(handle);
+		error = "cannot read the size of " + path;
+		return false;
+	}
+	file = handle;
+	length = size_t(fileSize.QuadPart);
+	if (length > 0) {
+		mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		bytes = mapping ? static_cast<const char *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0))
+		                : nullptr;
+		if (!bytes) {
+			close();
+			error = "cannot map " + path;
+			return false;
+		}
+	}
+	opened = true;
+	return true;
+}
+
+void MappedFile::close() {
+	if (bytes)
+		UnmapViewOfFile(bytes);
+	if (mapping)
+		CloseHandle(mapping);
+	if (file)
+		CloseHandle(file);
+	bytes = nullptr;
+	mapping = file = nullptr;
+	length = 0;
+	opened = false;
+}
+
+#else
+
+bool MappedFile::open(const std::string &path) {
+	close();
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		error = "cannot open " + path + ": " + std::strerror(errno);
+		return false;
+	}
+	struct stat status;
+	if (fstat(fd, &status) != 0) {
+		error = "cannot read the size of " + path + ": " + std::strerror(errno);
+		::close(fd);
+		return false;
+	}
+	length = size_t(status.st_size);
+	if (length > 0) {
+		void *mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (mapped == MAP_FAILED) {
+			error = "cannot map " + path + ": " + std::strerror(errno);
+			::close(fd);
+			length = 0;
+			return false;
+		}
+		// Parsers sweep the file front to back, a range per thread
+		madvise(mapped, length, MADV_WILLNEED);
+		bytes = static_cast<const char *>(mapped);
+	}
+	// The mapping keeps the file alive
+	::close(fd);
+	opened = true;
+	return true;
+}
+
+void MappedFile::close() {
+	if (bytes)
+		munmap(const_cast<char *>(bytes), length);
+	bytes = nullptr;
+	length = 0;
+	opened = false;
+}
+
+#endif
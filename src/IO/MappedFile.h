@@ -0,0 +1,43 @@
+//
+// Created by Leonard Chan on 10/15/26.
+//
+
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+
+// Read-only memory mapping of a whole file. Pages are read in on first touch, so large files can
+// be parsed by several threads at once without a copy into the heap. An empty file maps to an
+// empty range.
+class MappedFile {
+  public:
+	MappedFile() = default;
+	~MappedFile() { close(); }
+
+	MappedFile(const MappedFile &) = delete;
+	MappedFile &operator=(const MappedFile &) = delete;
+
+	// Maps the file; on failure returns false, leaving the reason in getError()
+	bool open(const std::string &path);
+	void close();
+
+	bool isOpen() const { return opened; }
+	const char *data() const { return bytes; }
+	size_t size() const { return length; }
+	const std::string &getError() const { return error; }
+
+  private:
+	const char *bytes = nullptr;
+	size_t length = 0;
+	bool opened = false;
+	std::string error;
+
+#ifdef _WIN32
+	void *file = nullptr;
+	void *mapping = nullptr;
+#endif
+};
+
+#endif // MAPPEDFILE_H
@@ -0,0 +1,901 @@
+//
+// Created by Leonard Chan on 10/15/26.
+//
+
+#include "MeshLoader.h"
+
+#include "../Tasks/TaskScheduler.h"
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+//------------------------------------
+// Text scanning
+
+bool isBlank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+void skipBlanks(const char *&p, const char *end) {
+	while (p < end && isBlank(*p))
+		p++;
+}
+
+// Start of the line after the one p is on, or end
+const char *nextLine(const char *p, const char *end) {
+	const void *newline = std::memchr(p, '\n', size_t(end - p));
+	return newline ? static_cast<const char *>(newline) + 1 : end;
+}
+
+// First line that starts at or after offset: chunk boundaries fall mid-line, and a line belongs
+// to the chunk it starts in
+const char *firstLineFrom(const char *data, const char *end, size_t offset) {
+	if (offset == 0)
+		return data;
+	return nextLine(data + offset - 1, end);
+}
+
+// Decimal number with optional sign, fraction and exponent. The digits are gathered into an
+// integer and scaled once, which is exact to within a float for the values meshes hold and far
+// faster than strtof. Leaves p after the number; returns false if there is none.
+bool parseNumber(const char *&p, const char *end, double &value) {
+	static const double powersOfTen[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+	                                     1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+	                                     1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+	skipBlanks(p, end);
+	bool negative = false;
+	if (p < end && (*p == '-' || *p == '+'))
+		negative = *p++ == '-';
+
+	uint64_t mantissa = 0;
+	int exponent = 0, digits = 0;
+	for (; p < end && unsigned(*p - '0') < 10; p++, digits++) {
+		if (mantissa < (uint64_t(1) << 59))
+			mantissa = mantissa * 10 + uint64_t(*p - '0');
+		else
+			exponent++;
+	}
+	if (p < end && *p == '.') {
+		for (p++; p < end && unsigned(*p - '0') < 10; p++, digits++) {
+			if (mantissa < (uint64_t(1) << 59)) {
+				mantissa = mantissa * 10 + uint64_t(*p - '0');
+				exponent--;
+			}
+		}
+	}
+	if (digits == 0)
+		return false;
+	if (p < end && (*p == 'e' || *p == 'E')) {
+		const char *mark = p++;
+		bool negativeExponent = false;
+		if (p < end && (*p == '-' || *p == '+'))
+			negativeExponent = *p++ == '-';
+		int e = 0;
+		if (p == end || unsigned(*p - '0') >= 10) {
+			p = mark; // not an exponent after all
+		} else {
+			for (; p < end && unsigned(*p - '0') < 10; p++)
+				e = std::min(e * 10 + (*p - '0'), 100000);
+			exponent += negativeExponent ? -e : e;
+		}
+	}
+
+	double x = double(mantissa);
+	if (exponent != 0 && mantissa != 0) {
+		if (std::abs(exponent) <= 22)
+			x = exponent > 0 ? x * powersOfTen[exponent] : x / powersOfTen[-exponent];
+		else
+			x *= std::pow(10.0, double(exponent));
+	}
+	value = negative ? -x : x;
+	return true;
+}
+
+bool parseInteger(const char *&p, const char *end, int64_t &value) {
+	skipBlanks(p, end);
+	bool negative = false;
+	if (p < end && (*p == '-' || *p == '+'))
+		negative = *p++ == '-';
+	if (p == end || unsigned(*p - '0') >= 10)
+		return false;
+	int64_t x = 0;
+	for (; p < end && unsigned(*p - '0') < 10; p++)
+		x = std::min<int64_t>(x * 10 + (*p - '0'), INT64_MAX / 10);
+	value = negative ? -x : x;
+	return true;
+}
+
+// Whether the line at p starts with keyword followed by a blank
+bool startsWith(const char *p, const char *end, const char *keyword) {
+	size_t n = std::strlen(keyword);
+	return size_t(end - p) > n && std::memcmp(p, keyword, n) == 0 && isBlank(p[n]);
+}
+
+std::string lowercaseExtension(const std::string &path) {
+	size_t dot = path.find_last_of('.');
+	size_t slash = path.find_last_of("/\\");
+	if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+		return "";
+	std::string extension = path.substr(dot + 1);
+	for (char &c : extension) {
+		c = char(std::tolower(static_cast<unsigned char>(c)));
+	}
+	return extension;
+}
+
+// Triangles of every chunk, concatenated in chunk order
+void gatherTriangles(const std::vector<std::vector<uint32_t>> &chunkTriangles,
+                     std::vector<uint32_t> &triangles) {
+	std::vector<size_t> offsets(chunkTriangles.size() + 1, 0);
+	for (size_t c = 0; c < chunkTriangles.size(); c++) {
+		offsets[c + 1] = offsets[c] + chunkTriangles[c].size();
+	}
+	triangles.resize(offsets.back());
+	TaskScheduler::get().parallelFor(0, chunkTriangles.size(), 1, [&](size_t begin, size_t end) {
+		for (size_t c = begin; c < end; c++) {
+			std::copy(chunkTriangles[c].begin(), chunkTriangles[c].end(),
+			          triangles.begin() + ptrdiff_t(offsets[c]));
+		}
+	});
+}
+
+// First error reported by any chunk, if any
+const std::string *firstError(const std::vector<std::string> &errors) {
+	for (const std::string &error : errors) {
+		if (!error.empty())
+			return &error;
+	}
+	return nullptr;
+}
+
+//------------------------------------
+// Wavefront OBJ
+
+bool isVertexLine(const char *p, const char *end) { return startsWith(p, end, "v"); }
+
+// Two passes over the chunks: the first counts the vertices of each chunk, so that the second
+// knows where each chunk's vertices go and can resolve relative (negative) face indices, which
+// count back from the last vertex read.
+bool parseObj(const char *data, size_t size, size_t chunkBytes, TriangleMesh &mesh,
+              std::string &error) {
+	TaskScheduler &scheduler = TaskScheduler::get();
+	const char *end = data + size;
+	const size_t chunks = TaskScheduler::chunkCount(0, size, chunkBytes);
+
+	// 1) Vertices per chunk
+	std::vector<size_t> vertexOffsets(chunks + 1, 0);
+	scheduler.parallelForChunks(0, size, chunkBytes, [&](size_t chunk, size_t begin, size_t stop) {
+		size_t count = 0;
+		for (const char *line = firstLineFrom(data, end, begin); line < data + stop;
+		     line = nextLine(line, end)) {
+			const char *p = line;
+			skipBlanks(p, end);
+			count += isVertexLine(p, end);
+		}
+		vertexOffsets[chunk + 1] = count;
+	});
+	for (size_t c = 0; c < chunks; c++) {
+		vertexOffsets[c + 1] += vertexOffsets[c];
+	}
+	const size_t vertexCount = vertexOffsets.back();
+	if (vertexCount > UINT32_MAX) {
+		error = "too many vertices";
+		return false;
+	}
+	mesh.positions.resize(vertexCount);
+
+	// 2) Vertices and faces
+	std::vector<std::vector<uint32_t>> chunkTriangles(chunks);
+	std::vector<std::string> errors(chunks);
+	scheduler.parallelForChunks(0, size, chunkBytes, [&](size_t chunk, size_t begin, size_t stop) {
+		std::vector<uint32_t> &triangles = chunkTriangles[chunk];
+		size_t vertex = vertexOffsets[chunk];
+		for (const char *line = firstLineFrom(data, end, begin); line < data + stop;
+		     line = nextLine(line, end)) {
+			const char *p = line;
+			skipBlanks(p, end);
+			if (isVertexLine(p, end)) {
+				p++;
+				double x, y, z;
+				if (!parseNumber(p, end, x) || !parseNumber(p, end, y) || !parseNumber(p, end, z)) {
+					errors[chunk] = "malformed vertex at byte " + std::to_string(line - data);
+					return;
+				}
+				mesh.positions[vertex++] = glm::vec3(float(x), float(y), float(z));
+			} else if (startsWith(p, end, "f")) {
+				// Corners are v, v/vt, v//vn or v/vt/vn; only v matters
+				p++;
+				uint32_t first = 0, previous = 0;
+				int corners = 0;
+				for (;;) {
+					skipBlanks(p, end);
+					if (p == end || *p == '\n')
+						break;
+					int64_t index;
+					if (!parseInteger(p, end, index)) {
+						errors[chunk] = "malformed face at byte " + std::to_string(line - data);
+						return;
+					}
+					while (p < end && !isBlank(*p) && *p != '\n')
+						p++;
+					int64_t resolved = index > 0 ? index - 1 : int64_t(vertex) + index;
+					if (index == 0 || resolved < 0 || resolved >= int64_t(vertexCount)) {
+						errors[chunk] = "face index " + std::to_string(index) +
+						                " out of range at byte " + std::to_string(line - data);
+						return;
+					}
+					uint32_t current = uint32_t(resolved);
+					if (corners == 0)
+						first = current;
+					else if (corners >= 2)
+						triangles.insert(triangles.end(), {first, previous, current});
+					previous = current;
+					corners++;
+				}
+			}
+		}
+	});
+	if (const std::string *chunkError = firstError(errors)) {
+		error = *chunkError;
+		return false;
+	}
+
+	gatherTriangles(chunkTriangles, mesh.triangles);
+	return true;
+}
+
+//------------------------------------
+// PLY
+
+enum class PlyType : uint8_t { NONE, INT8, UINT8, INT16, UINT16, INT32, UINT32, FLOAT32, FLOAT64 };
+
+PlyType plyType(const std::string &name) {
+	if (name == "char" || name == "int8")
+		return PlyType::INT8;
+	if (name == "uchar" || name == "uint8")
+		return PlyType::UINT8;
+	if (name == "short" || name == "int16")
+		return PlyType::INT16;
+	if (name == "ushort" || name == "uint16")
+		return PlyType::UINT16;
+	if (name == "int" || name == "int32")
+		return PlyType::INT32;
+	if (name == "uint" || name == "uint32")
+		return PlyType::UINT32;
+	if (name == "float" || name == "float32")
+		return PlyType::FLOAT32;
+	if (name == "double" || name == "float64")
+		return PlyType::FLOAT64;
+	return PlyType::NONE;
+}
+
+size_t plySize(PlyType type) {
+	static const size_t sizes[] = {0, 1, 1, 2, 2, 4, 4, 4, 8};
+	return sizes[size_t(type)];
+}
+
+struct PlyProperty {
+	std::string name;
+	PlyType type = PlyType::NONE;      // of the value, or of the list items
+	PlyType countType = PlyType::NONE; // of the list length; NONE for scalars
+};
+
+struct PlyElement {
+	std::string name;
+	size_t count = 0;
+	std::vector<PlyProperty> properties;
+
+	bool hasLists() const {
+		return std::any_of(properties.begin(), properties.end(),
+		                   [](const PlyProperty &p) { return p.countType != PlyType::NONE; });
+	}
+	int find(const char *propertyName) const {
+		for (size_t k = 0; k < properties.size(); k++) {
+			if (properties[k].name == propertyName)
+				return int(k);
+		}
+		return -1;
+	}
+};
+
+// Reads one binary value, swapping its bytes if the file's byte order is not the machine's
+double readBinary(const char *p, PlyType type, bool swap) {
+	unsigned char bytes[8];
+	const size_t n = plySize(type);
+	std::memcpy(bytes, p, n);
+	if (swap)
+		std::reverse(bytes, bytes + n);
+	switch (type) {
+	case PlyType::INT8:
+		return double(int8_t(bytes[0]));
+	case PlyType::UINT8:
+		return double(bytes[0]);
+	case PlyType::INT16: {
+		int16_t v;
+		std::memcpy(&v, bytes, 2);
+		return double(v);
+	}
+	case PlyType::UINT16: {
+		uint16_t v;
+		std::memcpy(&v, bytes, 2);
+		return double(v);
+	}
+	case PlyType::INT32: {
+		int32_t v;
+		std::memcpy(&v, bytes, 4);
+		return double(v);
+	}
+	case PlyType::UINT32: {
+		uint32_t v;
+		std::memcpy(&v, bytes, 4);
+		return double(v);
+	}
+	case PlyType::FLOAT32: {
+		float v;
+		std::memcpy(&v, bytes, 4);
+		return double(v);
+	}
+	case PlyType::FLOAT64: {
+		double v;
+		std::memcpy(&v, bytes, 8);
+		return v;
+	}
+	default:
+		return 0.0;
+	}
+}
+
+struct PlyHeader {
+	enum class Format { ASCII, BINARY_LITTLE_ENDIAN, BINARY_BIG_ENDIAN } format = Format::ASCII;
+	std::vector<PlyElement> elements;
+	size_t bodyOffset = 0;
+};
+
+bool parsePlyHeader(const char *data, size_t size, PlyHeader &header, std::string &error) {
+	const char *end = data + size;
+	const char *line = data;
+	auto word = [&](const char *&p, const char *lineEnd) {
+		skipBlanks(p, lineEnd);
+		const char *start = p;
+		while (p < lineEnd && !isBlank(*p) && *p != '\n')
+			p++;
+		return std::string(start, p);
+	};
+
+	bool formatSeen = false;
+	for (int lineNumber = 0; line < end; lineNumber++) {
+		const char *lineEnd = nextLine(line, end);
+		const char *p = line;
+		std::string keyword = word(p, lineEnd);
+		if (lineNumber == 0) {
+			if (keyword != "ply") {
+				error = "not a PLY file";
+				return false;
+			}
+		} else if (keyword == "format") {
+			std::string format = word(p, lineEnd);
+			if (format == "ascii")
+				header.format = PlyHeader::Format::ASCII;
+			else if (format == "binary_little_endian")
+				header.format = PlyHeader::Format::BINARY_LITTLE_ENDIAN;
+			else if (format == "binary_big_endian")
+				header.format = PlyHeader::Format::BINARY_BIG_ENDIAN;
+			else {
+				error = "unknown PLY format " + format;
+				return false;
+			}
+			formatSeen = true;
+		} else if (keyword == "element") {
+			PlyElement element;
+			element.name = word(p, lineEnd);
+			int64_t count;
+			if (!parseInteger(p, lineEnd, count) || count < 0) {
+				error = "malformed element " + element.name;
+				return false;
+			}
+			element.count = size_t(count);
+			header.elements.push_back(element);
+		} else if (keyword == "property") {
+			if (header.elements.empty()) {
+				error = "property outside an element";
+				return false;
+			}
+			PlyProperty property;
+			std::string type = word(p, lineEnd);
+			if (type == "list") {
+				property.countType = plyType(word(p, lineEnd));
+				type = word(p, lineEnd);
+				if (property.countType == PlyType::NONE) {
+					error = "unknown PLY list type";
+					return false;
+				}
+			}
+			property.type = plyType(type);
+			property.name = word(p, lineEnd);
+			if (property.type == PlyType::NONE) {
+				error = "unknown PLY type " + type;
+				return false;
+			}
+			header.elements.back().properties.push_back(property);
+		} else if (keyword == "end_header") {
+			if (!formatSeen) {
+				error = "PLY header without a format";
+				return false;
+			}
+			header.bodyOffset = size_t(lineEnd - data);
+			return true;
+		}
+		// comment, obj_info and anything unknown are skipped
+		line = lineEnd;
+	}
+	error = "PLY header without end_header";
+	return false;
+}
+
+// Where a face element keeps its vertex indices
+int faceIndexProperty(const PlyElement &element) {
+	int k = element.find("vertex_indices");
+	return k >= 0 ? k : element.find("vertex_index");
+}
+
+bool parsePlyBinary(const char *data, size_t size, const PlyHeader &header, TriangleMesh &mesh,
+                    std::string &error) {
+	TaskScheduler &scheduler = TaskScheduler::get();
+	const bool bigEndian = header.format == PlyHeader::Format::BINARY_BIG_ENDIAN;
+	const bool swap = bigEndian != (std::endian::native == std::endian::big);
+	const char *p = data + header.bodyOffset, *end = data + size;
+	size_t vertexCount = 0;
+
+	// Size of one list property at q, or 0 if it runs past the end
+	auto listBytes = [&](const char *q, const PlyProperty &property) -> size_t {
+		size_t countSize = plySize(property.countType);
+		if (size_t(end - q) < countSize)
+			return 0;
+		double n = readBinary(q, property.countType, swap);
+		size_t bytes = countSize + size_t(std::max(n, 0.0)) * plySize(property.type);
+		return bytes <= size_t(end - q) ? bytes : 0;
+	};
+
+	for (const PlyElement &element : header.elements) {
+		const bool isVertex = element.name == "vertex", isFace = element.name == "face";
+		std::vector<size_t> offsets; // byte offset of each scalar property in a fixed record
+		size_t stride = 0;
+		for (const PlyProperty &property : element.properties) {
+			offsets.push_back(stride);
+			stride += plySize(property.countType == PlyType::NONE ? property.type
+			                                                        : property.countType);
+		}
+
+		if (!element.hasLists()) {
+			// Fixed-size records: every vertex is read independently. Divide rather than multiply,
+			// since a hostile count can overflow stride * count.
+			if (stride > 0 && element.count > size_t(end - p) / stride) {
+				error = "PLY file ends inside element " + element.name;
+				return false;
+			}
+			if (isVertex) {
+				int x = element.find("x"), y = element.find("y"), z = element.find("z");
+				if (x < 0 || y < 0 || z < 0) {
+					error = "PLY vertices without x, y and z";
+					return false;
+				}
+				vertexCount = element.count;
+				mesh.positions.resize(vertexCount);
+				const PlyType tx = element.properties[x].type, ty = element.properties[y].type,
+				              tz = element.properties[z].type;
+				scheduler.parallelFor(0, vertexCount, 65536, [&](size_t begin, size_t stop) {
+					for (size_t i = begin; i < stop; i++) {
+						const char *record = p + i * stride;
+						mesh.positions[i] = glm::vec3(readBinary(record + offsets[x], tx, swap),
+						                              readBinary(record + offsets[y], ty, swap),
+						                              readBinary(record + offsets[z], tz, swap));
+					}
+				});
+			}
+			p += stride * element.count;
+			continue;
+		}
+
+		const int indices = isFace ? faceIndexProperty(element) : -1;
+		if (isFace && indices < 0) {
+			error = "PLY faces without vertex_indices";
+			return false;
+		}
+
+		// Faces that are all triangles, with no other lists, have fixed-size records too. Check
+		// that in parallel and read them in parallel; anything else is walked record by record.
+		bool triangleRecords = false;
+		size_t recordSize = 0, indexOffset = 0;
+		const PlyProperty *indexProperty = nullptr;
+		if (isFace && std::count_if(element.properties.begin(), element.properties.end(),
+		                            [](const PlyProperty &q) {
+			                            return q.countType != PlyType::NONE;
+		                            }) == 1) {
+			indexProperty = &element.properties[indices];
+			indexOffset = offsets[indices];
+			recordSize = stride + 3 * plySize(indexProperty->type);
+			for (size_t k = indices + 1; k < offsets.size(); k++) {
+				offsets[k] += 3 * plySize(indexProperty->type);
+			}
+			if (element.count <= size_t(end - p) / recordSize) {
+				std::atomic<bool> allTriangles{true};
+				scheduler.parallelFor(0, element.count, 65536, [&](size_t begin, size_t stop) {
+					for (size_t f = begin; f < stop && allTriangles.load(std::memory_order_relaxed);
+					     f++) {
+						const char *record = p + f * recordSize + indexOffset;
+						if (readBinary(record, indexProperty->countType, swap) != 3.0)
+							allTriangles.store(false, std::memory_order_relaxed);
+					}
+				});
+				triangleRecords = allTriangles.load();
+			}
+		}
+
+		if (triangleRecords) {
+			const size_t countSize = plySize(indexProperty->countType);
+			const size_t itemSize = plySize(indexProperty->type);
+			mesh.triangles.resize(3 * element.count);
+			std::atomic<bool> inRange{true};
+			scheduler.parallelFor(0, element.count, 65536, [&](size_t begin, size_t stop) {
+				for (size_t f = begin; f < stop; f++) {
+					const char *items = p + f * recordSize + indexOffset + countSize;
+					for (int c = 0; c < 3; c++) {
+						double v = readBinary(items + c * itemSize, indexProperty->type, swap);
+						if (!(v >= 0.0 && v < double(vertexCount)))
+							inRange.store(false, std::memory_order_relaxed);
+						mesh.triangles[3 * f + c] = uint32_t(v);
+					}
+				}
+			});
+			if (!inRange.load()) {
+				error = "PLY face index out of range";
+				return false;
+			}
+			p += recordSize * element.count;
+			continue;
+		}
+
+		// Variable-size records
+		for (size_t r = 0; r < element.count; r++) {
+			for (size_t k = 0; k < element.properties.size(); k++) {
+				const PlyProperty &property = element.properties[k];
+				if (property.countType == PlyType::NONE) {
+					if (size_t(end - p) < plySize(property.type)) {
+						error = "PLY file ends inside element " + element.name;
+						return false;
+					}
+					p += plySize(property.type);
+					continue;
+				}
+				size_t bytes = listBytes(p, property);
+				if (bytes == 0) {
+					error = "PLY file ends inside element " + element.name;
+					return false;
+				}
+				if (int(k) == indices) {
+					const size_t itemSize = plySize(property.type);
+					const size_t n = (bytes - plySize(property.countType)) / itemSize;
+					const char *items = p + plySize(property.countType);
+					uint32_t first = 0, previous = 0;
+					for (size_t c = 0; c < n; c++) {
+						double v = readBinary(items + c * itemSize, property.type, swap);
+						if (!(v >= 0.0 && v < double(vertexCount))) {
+							error = "PLY face index out of range";
+							return false;
+						}
+						uint32_t current = uint32_t(v);
+						if (c == 0)
+							first = current;
+						else if (c >= 2)
+							mesh.triangles.insert(mesh.triangles.end(), {first, previous, current});
+						previous = current;
+					}
+				}
+				p += bytes;
+			}
+		}
+	}
+	return true;
+}
+
+// ASCII bodies hold one element instance per line. A first pass counts the lines of each chunk,
+// so that the second knows which element and instance every line is.
+bool parsePlyAscii(const char *data, size_t size, size_t chunkBytes, const PlyHeader &header,
+                   TriangleMesh &mesh, std::string &error) {
+	TaskScheduler &scheduler = TaskScheduler::get();
+	const char *body = data + header.bodyOffset, *end = data + size;
+	const size_t bodySize = size - header.bodyOffset;
+	const size_t chunks = TaskScheduler::chunkCount(0, bodySize, chunkBytes);
+
+	// Line ranges of the elements
+	std::vector<size_t> firstLines(header.elements.size() + 1, 0);
+	int vertexElement = -1;
+	for (size_t e = 0; e < header.elements.size(); e++) {
+		firstLines[e + 1] = firstLines[e] + header.elements[e].count;
+		if (header.elements[e].name == "vertex")
+			vertexElement = int(e);
+	}
+	if (vertexElement < 0) {
+		error = "PLY file without vertices";
+		return false;
+	}
+	const PlyElement &vertices = header.elements[vertexElement];
+	const int x = vertices.find("x"), y = vertices.find("y"), z = vertices.find("z");
+	if (x < 0 || y < 0 || z < 0) {
+		error = "PLY vertices without x, y and z";
+		return false;
+	}
+	const size_t vertexCount = vertices.count;
+	mesh.positions.resize(vertexCount);
+
+	// 1) Lines per chunk
+	std::vector<size_t> lineOffsets(chunks + 1, 0);
+	scheduler.parallelForChunks(0, bodySize, chunkBytes, [&](size_t chunk, size_t begin,
+	                                                         size_t stop) {
+		size_t count = 0;
+		for (const char *line = firstLineFrom(body, end, begin); line < body + stop;
+		     line = nextLine(line, end)) {
+			count++;
+		}
+		lineOffsets[chunk + 1] = count;
+	});
+	for (size_t c = 0; c < chunks; c++) {
+		lineOffsets[c + 1] += lineOffsets[c];
+	}
+	if (lineOffsets.back() < firstLines.back()) {
+		error = "PLY file ends early";
+		return false;
+	}
+
+	// 2) Vertices and faces
+	std::vector<std::vector<uint32_t>> chunkTriangles(chunks);
+	std::vector<std::string> errors(chunks);
+	scheduler.parallelForChunks(0, bodySize, chunkBytes, [&](size_t chunk, size_t begin,
+	                                                         size_t stop) {
+		std::vector<uint32_t> &triangles = chunkTriangles[chunk];
+		size_t lineNumber = lineOffsets[chunk];
+		size_t e = std::upper_bound(firstLines.begin(), firstLines.end(), lineNumber) -
+		           firstLines.begin() - 1;
+		for (const char *line = firstLineFrom(body, end, begin); line < body + stop;
+		     line = nextLine(line, end), lineNumber++) {
+			while (e < header.elements.size() && lineNumber >= firstLines[e + 1])
+				e++;
+			if (e >= header.elements.size())
+				return; // trailing lines
+			const PlyElement &element = header.elements[e];
+			const bool isVertex = int(e) == vertexElement, isFace = element.name == "face";
+			if (!isVertex && !isFace)
+				continue;
+
+			const int indices = isFace ? faceIndexProperty(element) : -1;
+			const char *p = line, *lineEnd = nextLine(line, end);
+			double position[3] = {0.0, 0.0, 0.0};
+			for (size_t k = 0; k < element.properties.size(); k++) {
+				const PlyProperty &property = element.properties[k];
+				double value;
+				if (!parseNumber(p, lineEnd, value)) {
+					errors[chunk] = "malformed " + element.name + " at byte " +
+					                std::to_string(line - data);
+					return;
+				}
+				if (property.countType == PlyType::NONE) {
+					if (isVertex && (int(k) == x || int(k) == y || int(k) == z))
+						position[int(k) == x ? 0 : int(k) == y ? 1 : 2] = value;
+					continue;
+				}
+				// A list: its length, then its items
+				const int64_t n = int64_t(value);
+				uint32_t first = 0, previous = 0;
+				for (int64_t c = 0; c < n; c++) {
+					double item;
+					if (!parseNumber(p, lineEnd, item)) {
+						errors[chunk] = "malformed " + element.name + " at byte " +
+						                std::to_string(line - data);
+						return;
+					}
+					if (int(k) != indices)
+						continue;
+					if (!(item >= 0.0 && item < double(vertexCount))) {
+						errors[chunk] = "face index out of range at byte " +
+						                std::to_string(line - data);
+						return;
+					}
+					uint32_t current = uint32_t(item);
+					if (c == 0)
+						first = current;
+					else if (c >= 2)
+						triangles.insert(triangles.end(), {first, previous, current});
+					previous = current;
+				}
+			}
+			if (isVertex)
+				mesh.positions[lineNumber - firstLines[e]] =
+				    glm::vec3(float(position[0]), float(position[1]), float(position[2]));
+		}
+	});
+	if (const std::string *chunkError = firstError(errors)) {
+		error = *chunkError;
+		return false;
+	}
+
+	gatherTriangles(chunkTriangles, mesh.triangles);
+	return true;
+}
+
+bool parsePly(const char *data, size_t size, size_t chunkBytes, TriangleMesh &mesh,
+              std::string &error) {
+	PlyHeader header;
+	if (!parsePlyHeader(data, size, header, error))
+		return false;
+	if (header.format == PlyHeader::Format::ASCII)
+		return parsePlyAscii(data, size, chunkBytes, header, mesh, error);
+	return parsePlyBinary(data, size, header, mesh, error);
+}
+
+//------------------------------------
+// Welding
+
+struct WeldCell {
+	int64_t x, y, z;
+	bool operator==(const WeldCell &o) const { return x == o.x && y == o.y && z == o.z; }
+};
+
+uint64_t hashCell(const WeldCell &c) {
+	uint64_t h = uint64_t(c.x) * 0x9E3779B97F4A7C15ull;
+	h ^= uint64_t(c.y) * 0xC2B2AE3D27D4EB4Full + (h << 6) + (h >> 2);
+	h ^= uint64_t(c.z) * 0x165667B19E3779F9ull + (h << 6) + (h >> 2);
+	return h ^ (h >> 29);
+}
+
+} // namespace
+
+size_t weldVertices(TriangleMesh &mesh, float distance) {
+	const size_t n = mesh.positions.size();
+	const std::vector<glm::vec3> &X = mesh.positions;
+	const bool exact = !(distance > 0.0f);
+	const float distance2 = distance * distance;
+
+	// Exact welding hashes the coordinates' bits (with -0 folded into +0). Welding within a
+	// distance hashes cells twice that size: a vertex can then only be within reach of the
+	// neighbouring cell on the nearer side along each axis, so it searches 8 cells rather than 27.
+	const double cellSize = 2.0 * double(distance);
+	auto cellOf = [&](const glm::vec3 &p, int *sides) {
+		if (exact) {
+			auto bits = [](float v) {
+				uint32_t b;
+				v += 0.0f;
+				std::memcpy(&b, &v, 4);
+				return int64_t(b);
+			};
+			return WeldCell{bits(p.x), bits(p.y), bits(p.z)};
+		}
+		int64_t cell[3];
+		for (int axis = 0; axis < 3; axis++) {
+			double scaled = double(p[axis]) / cellSize, c = std::floor(scaled);
+			cell[axis] = int64_t(std::clamp(c, -4e18, 4e18));
+			sides[axis] = scaled - c < 0.5 ? -1 : 1;
+		}
+		return WeldCell{cell[0], cell[1], cell[2]};
+	};
+
+	// Open-addressed table of the occupied cells; each holds a chain of the vertices kept there
+	struct Slot {
+		WeldCell cell;
+		uint32_t head;
+	};
+	size_t tableSize = 16;
+	while (tableSize < 2 * n)
+		tableSize *= 2;
+	const uint32_t none = UINT32_MAX;
+	std::vector<Slot> table(tableSize, Slot{{0, 0, 0}, none});
+	std::vector<uint32_t> next(n, none), keptIndex(n, none), remap(n);
+	auto findSlot = [&](const WeldCell &cell) {
+		size_t slot = hashCell(cell) & (tableSize - 1);
+		while (table[slot].head != none && !(table[slot].cell == cell))
+			slot = (slot + 1) & (tableSize - 1);
+		return slot;
+	};
+
+	uint32_t kept = 0;
+	for (uint32_t i = 0; i < n; i++) {
+		int sides[3] = {0, 0, 0};
+		const WeldCell home = cellOf(X[i], sides);
+		uint32_t match = none;
+		for (int neighbour = 0; neighbour < (exact ? 1 : 8) && match == none; neighbour++) {
+			WeldCell cell{home.x + (neighbour & 1 ? sides[0] : 0),
+			              home.y + (neighbour & 2 ? sides[1] : 0),
+			              home.z + (neighbour & 4 ? sides[2] : 0)};
+			for (uint32_t k = table[findSlot(cell)].head; k != none; k = next[k]) {
+				glm::vec3 d = X[k] - X[i];
+				if (exact || glm::dot(d, d) <= distance2) {
+					match = k;
+					break;
+				}
+			}
+		}
+		if (match != none) {
+			remap[i] = keptIndex[match];
+			continue;
+		}
+		Slot &slot = table[findSlot(home)];
+		slot.cell = home;
+		next[i] = slot.head;
+		slot.head = i;
+		keptIndex[i] = remap[i] = kept++;
+	}
+
+	// Drop the triangles that lost a corner, then the vertices no triangle uses
+	std::vector<uint32_t> &T = mesh.triangles;
+	size_t triangleCount = 0;
+	for (size_t t = 0; t + 2 < T.size(); t += 3) {
+		uint32_t a = remap[T[t]], b = remap[T[t + 1]], c = remap[T[t + 2]];
+		if (a == b || b == c || a == c)
+			continue;
+		T[triangleCount++] = a;
+		T[triangleCount++] = b;
+		T[triangleCount++] = c;
+	}
+	T.resize(triangleCount);
+
+	std::vector<uint32_t> used(kept, none);
+	for (uint32_t v : T) {
+		used[v] = 0;
+	}
+	std::vector<glm::vec3> positions;
+	positions.reserve(kept);
+	for (uint32_t i = 0; i < n; i++) {
+		if (keptIndex[i] != none && used[keptIndex[i]] != none) {
+			used[keptIndex[i]] = uint32_t(positions.size());
+			positions.push_back(X[i]);
+		}
+	}
+	for (uint32_t &v : T) {
+		v = used[v];
+	}
+	size_t removed = n - positions.size();
+	mesh.positions.swap(positions);
+	return removed;
+}
+
+bool loadTriangleMesh(const std::string &path,
+                      TriangleMesh &mesh,
+                      const MeshLoadOptions &options) {
+	mesh.positions.clear();
+	mesh.triangles.clear();
+
+	MappedFile file;
+	if (!file.open(path)) {
+		std::cerr << "Cannot load mesh: " << file.getError() << std::endl;
+		return false;
+	}
+
+	const std::string extension = lowercaseExtension(path);
+	const size_t chunkBytes = std::max<size_t>(options.chunkBytes, 1);
+	std::string error;
+	bool parsed = false;
+	if (extension == "obj")
+		parsed = parseObj(file.data(), file.size(), chunkBytes, mesh, error);
+	else if (extension == "ply")
+		parsed = parsePly(file.data(), file.size(), chunkBytes, mesh, error);
+	else
+		error = "unsupported extension (expected .obj or .ply)";
+	if (!parsed) {
+		std::cerr << "Cannot load mesh " << path << ": " << error << std::endl;
+		mesh.positions.clear();
+		mesh.triangles.clear();
+		return false;
+	}
+
+	weldVertices(mesh, options.weldDistance);
+	if (mesh.triangles.empty()) {
+		std::cerr << "Cannot load mesh " << path << ": no triangles" << std::endl;
+		mesh.positions.clear();
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,45 @@
+//
+// Created by Leonard Chan on 10/15/26.
+//
+
+#ifndef MESHLOADER_H
+#define MESHLOADER_H
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// An indexed triangle mesh: three position indices per triangle
+struct TriangleMesh {
+	std::vector<glm::vec3> positions;
+	std::vector<uint32_t> triangles;
+};
+
+struct MeshLoadOptions {
+	// Vertices closer than this are welded into one. At 0 only vertices at exactly the same
+	// position are, which is what exporters leave along UV and normal seams.
+	float weldDistance = 0.0f;
+
+	// Bytes of the file each parsing task handles
+	size_t chunkBytes = size_t(4) << 20;
+};
+
+// Loads a Wavefront OBJ or a PLY file (ASCII or binary), chosen by the extension. The file is
+// memory-mapped and parsed in chunks on all scheduler threads: each chunk starts at the first
+// line (or record) that begins inside it, and per-chunk results are concatenated in file order,
+// so the mesh does not depend on the thread count. Polygons are split into triangle fans;
+// normals, texture coordinates, lines and other attributes are skipped. The vertices are then
+// welded (see weldVertices()). On failure returns false and writes the reason to std::cerr.
+bool loadTriangleMesh(const std::string &path,
+                      TriangleMesh &mesh,
+                      const MeshLoadOptions &options = {});
+
+// Merges every vertex into an earlier vertex within distance of it (at exactly the same position
+// if distance is 0), found through a hash grid of cells twice that size. Triangles that lose a
+// corner to the merge and vertices no triangle uses are then dropped, and the remaining vertices
+// keep their order. Returns the number of vertices removed.
+size_t weldVertices(TriangleMesh &mesh, float distance);
+
+#endif // MESHLOADER_H
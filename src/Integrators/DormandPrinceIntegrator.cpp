@@ -0,0 +1,237 @@
+//
+// Created by Leonard Chan on 10/15/26.
+//
+
+#include "DormandPrinceIntegrator.h"
+
+#include "../Cloth.h"
+#include "../IO/Checkpoint.h"
+#include "../Math/PortableMath.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+// Butcher tableau. Row s holds the weights of stages 0..s-1 in the evaluation point of stage s;
+// the last row is also the fifth order solution.
+static constexpr float A[7][6] = {
+    {},
+    {1.0f / 5.0f},
+    {3.0f / 40.0f, 9.0f / 40.0f},
+    {44.0f / 45.0f, -56.0f / 15.0f, 32.0f / 9.0f},
+    {19372.0f / 6561.0f, -25360.0f / 2187.0f, 64448.0f / 6561.0f, -212.0f / 729.0f},
+    {9017.0f / 3168.0f, -355.0f / 33.0f, 46732.0f / 5247.0f, 49.0f / 176.0f, -5103.0f / 18656.0f},
+    {35.0f / 384.0f, 0.0f, 500.0f / 1113.0f, 125.0f / 192.0f, -2187.0f / 6784.0f, 11.0f / 84.0f},
+};
+
+// Fifth minus fourth order weights, giving the local error estimate
+static constexpr float E[7] = {
+    71.0f / 57600.0f, 0.0f,           -71.0f / 16695.0f, 71.0f / 1920.0f, -17253.0f / 339200.0f,
+    22.0f / 525.0f,   -1.0f / 40.0f};
+
+// Step size controller: new step = old step * safety * error^(-1/5), limited to [minScale,
+// maxScale] per substep
+static constexpr float safety = 0.9f;
+static constexpr float minScale = 0.2f, maxScale = 5.0f;
+
+// Substeps at or below this fraction of dt are accepted whatever their error, which bounds the
+// work of one call when the tolerance cannot be met
+static constexpr float minStepFraction = 1e-4f;
+
+static constexpr size_t errorChunkSize = 4096;
+
+DormandPrinceIntegrator::DormandPrinceIntegrator(const Cloth &cloth) : cloth(cloth) {}
+
+void DormandPrinceIntegrator::integrate(ParticleState &state,
+                                        float dt,
+                                        const std::vector<bool> &pinned,
+                                        ForceEvaluator computeForces) {
+	size_t N = state.size();
+	const float *invMass = state.inverseMass.data();
+	TaskScheduler &scheduler = TaskScheduler::get();
+
+	for (int s = 0; s < stageCount; s++) {
+		kX[s].resize(N);
+		kV[s].resize(N);
+	}
+	Xs.resize(N);
+
+	const float tolerance = cloth.getErrorTolerance();
+	const float minStep = dt * minStepFraction;
+	stepSize = stepSize > 0.0f ? std::min(stepSize, dt) : dt;
+	substeps = 0;
+	rejectedSteps = 0;
+
+	// ---- k1 at the start of the call. Later substeps reuse the last stage of the previous one.
+	kX[0] = state.velocities;
+	computeForces(state.positions, state.velocities, kV[0]);
+	scheduler.parallelFor(0, N, particleGrainSize, [&](size_t begin, size_t end) {
+		for (int axis = 0; axis < 3; axis++) {
+			float *a = kV[0].component(axis);
+			for (size_t i = begin; i < end; i++) {
+				a[i] *= invMass[i];
+			}
+		}
+	});
+
+	float remaining = dt;
+	bool lastRejected = false;
+	while (remaining > 0.0f) {
+		float h = std::min(stepSize, remaining);
+		if (remaining - h < minStep)
+			h = remaining; // no sliver of a substep at the end
+		bool truncated = h < stepSize;
+
+		// ---- k2 .. k7
+		// Each pass finishes the accelerations of the previous stage and builds the evaluation
+		// point of stage s: (X + h * sum a_sj kX_j, V + h * sum a_sj kV_j)
+		for (int s = 1; s < stageCount; s++) {
+			float ha[stageCount - 1];
+			for (int j = 0; j < s; j++) {
+				ha[j] = h * A[s][j];
+			}
+
+			scheduler.parallelFor(0, N, particleGrainSize, [&](size_t begin, size_t end) {
+				for (int axis = 0; axis < 3; axis++) {
+					const float *x = state.positions.component(axis);
+					const float *v = state.velocities.component(axis);
+					float *xs = Xs.component(axis), *vs = kX[s].component(axis);
+
+					const float *px[stageCount - 1], *pv[stageCount - 1];
+					for (int j = 0; j < s; j++) {
+						px[j] = kX[j].component(axis);
+						pv[j] = kV[j].component(axis);
+					}
+
+					if (s > 1) {
+						float *a = kV[s - 1].component(axis);
+						for (size_t i = begin; i < end; i++) {
+							a[i] *= invMass[i];
+						}
+					}
+
+					for (size_t i = begin; i < end; i++) {
+						float sx = x[i], sv = v[i];
+						for (int j = 0; j < s; j++) {
+							sx += ha[j] * px[j][i];
+							sv += ha[j] * pv[j][i];
+						}
+						xs[i] = sx;
+						vs[i] = sv;
+					}
+				}
+			});
+
+			computeForces(Xs, kX[s], kV[s]);
+		}
+
+		// ---- Error control
+		float error = estimateError(state, h, tolerance);
+		float scale = error > 0.0f ? safety * portableInverseFifthRoot(error) : maxScale;
+		scale = std::clamp(scale, minScale, maxScale);
+
+		if (error <= 1.0f || h <= minStep) {
+			// Never grow right after a rejection, the error estimate just proved too optimistic
+			if (lastRejected)
+				scale = std::min(scale, 1.0f);
+
+			// Take the fifth order solution
+			scheduler.parallelFor(0, N, particleGrainSize, [&](size_t begin, size_t end) {
+				for (int axis = 0; axis < 3; axis++) {
+					float *x = state.positions.component(axis);
+					float *v = state.velocities.component(axis);
+					const float *xs = Xs.component(axis), *vs = kX[stageCount - 1].component(axis);
+					for (size_t i = begin; i < end; i++) {
+						if (pinned[i])
+							continue;
+						x[i] = xs[i];
+						v[i] = vs[i];
+					}
+				}
+			});
+			std::swap(kX[0], kX[stageCount - 1]);
+			std::swap(kV[0], kV[stageCount - 1]);
+
+			remaining -= h;
+			substeps++;
+			lastRejected = false;
+
+			// A substep cut short by the end of the call says nothing about the step size
+			stepSize = truncated ? std::max(stepSize, h * scale) : h * scale;
+		} else {
+			rejectedSteps++;
+			lastRejected = true;
+			stepSize = h * scale;
+		}
+		stepSize = std::clamp(stepSize, minStep, dt);
+	}
+}
+
+void DormandPrinceIntegrator::saveState(CheckpointWriter &writer) const {
+	writer.addValue(CheckpointSection::INTEGRATOR_STEP_SIZE, stepSize);
+}
+
+bool DormandPrinceIntegrator::restoreState(const CheckpointReader &reader, size_t particleCount) {
+	(void)particleCount;
+	const float *saved = reader.getValue<float>(CheckpointSection::INTEGRATOR_STEP_SIZE);
+	stepSize = saved && std::isfinite(*saved) && *saved > 0.0f ? *saved : 0.0f;
+	return true;
+}
+
+float DormandPrinceIntegrator::estimateError(const ParticleState &state, float h, float tolerance) {
+	size_t N = state.size();
+	const float *invMass = state.inverseMass.data();
+
+	float he[stageCount];
+	for (int j = 0; j < stageCount; j++) {
+		he[j] = h * E[j];
+	}
+
+	// Each component is measured against tolerance * (1 + |y|), i.e. equal absolute and relative
+	// tolerances, and the step error is the largest of them. A NaN counts as infinitely large.
+	chunkError.assign(TaskScheduler::chunkCount(0, N, errorChunkSize), 0.0f);
+	TaskScheduler::get().parallelForChunks(
+	    0, N, errorChunkSize, [&](size_t chunk, size_t begin, size_t end) {
+		    float error = 0.0f;
+		    auto accumulate = [&error](float e) {
+			    if (!(e <= error))
+				    error = std::isnan(e) ? INFINITY : e;
+		    };
+		    for (int axis = 0; axis < 3; axis++) {
+			    const float *x = state.positions.component(axis);
+			    const float *v = state.velocities.component(axis);
+			    const float *xs = Xs.component(axis), *vs = kX[stageCount - 1].component(axis);
+
+			    // Accelerations of the last stage
+			    float *a = kV[stageCount - 1].component(axis);
+			    for (size_t i = begin; i < end; i++) {
+				    a[i] *= invMass[i];
+			    }
+
+			    const float *px[stageCount], *pv[stageCount];
+			    for (int j = 0; j < stageCount; j++) {
+				    px[j] = kX[j].component(axis);
+				    pv[j] = kV[j].component(axis);
+			    }
+
+			    for (size_t i = begin; i < end; i++) {
+				    float ex = 0.0f, ev = 0.0f;
+				    for (int j = 0; j < stageCount; j++) {
+					    ex += he[j] * px[j][i];
+					    ev += he[j] * pv[j][i];
+				    }
+				    float sx = tolerance * (1.0f + std::max(std::abs(x[i]), std::abs(xs[i])));
+				    float sv = tolerance * (1.0f + std::max(std::abs(v[i]), std::abs(vs[i])));
+				    accumulate(std::abs(ex) / sx);
+				    accumulate(std::abs(ev) / sv);
+			    }
+		    }
+		    chunkError[chunk] = error;
+	    });
+
+	float error = 0.0f;
+	for (float e : chunkError) {
+		error = std::max(error, e);
+	}
+	return error;
+}
@@ -0,0 +1,58 @@
+//
+// Created by Leonard Chan on 10/15/26.
+//
+
+#ifndef DORMANDPRINCEINTEGRATOR_H
+#define DORMANDPRINCEINTEGRATOR_H
+
+#include "Integrator.h"
+
+class Cloth;
+
+// Adaptive explicit Runge-Kutta (Dormand-Prince 5(4), as in MATLAB's ode45). Each call covers dt
+// with as many substeps as the error controller needs: the difference between the embedded
+// fourth and fifth order solutions estimates the local error, and the substep grows or shrinks
+// to keep it within cloth.getErrorTolerance(). Calm phases take a single substep per call while
+// impacts and fast stretching pay for small ones. The last stage is the first stage of the next
+// substep, so an accepted substep costs six force evaluations.
+class DormandPrinceIntegrator : public Integrator {
+  public:
+	explicit DormandPrinceIntegrator(const Cloth &cloth);
+
+	void integrate(ParticleState &state,
+	               float dt,
+	               const std::vector<bool> &pinned,
+	               ForceEvaluator computeForces) override;
+
+	// Controller statistics of the last call
+	int getSubsteps() const { return substeps; }
+	int getRejectedSteps() const { return rejectedSteps; }
+
+	// Substep size the controller will try next
+	float getStepSize() const { return stepSize; }
+
+	// The substep size, so a restored run does not have to find it again
+	void saveState(CheckpointWriter &writer) const override;
+	bool restoreState(const CheckpointReader &reader, size_t particleCount) override;
+
+  private:
+	// Largest scaled error component of the step just taken; 1 is exactly the tolerance
+	float estimateError(const ParticleState &state, float h, float tolerance);
+
+  private:
+	static constexpr int stageCount = 7;
+
+	const Cloth &cloth;
+
+	// Stage derivatives: kX[s] is the velocity and kV[s] the acceleration at stage s. kV[s]
+	// receives the forces first and is scaled by the inverse mass in the following pass.
+	Vec3Array kX[stageCount], kV[stageCount];
+	Vec3Array Xs; // stage position; holds the fifth order solution after the last stage
+	AlignedVector<float> chunkError;
+
+	float stepSize = 0.0f;
+	int substeps = 0;
+	int rejectedSteps = 0;
+};
+
+#endif // DORMANDPRINCEINTEGRATOR_H
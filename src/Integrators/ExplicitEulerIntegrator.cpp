@@ -4,32 +4,33 @@
 
 #include "ExplicitEulerIntegrator.h"
 
-std::pair<std::vector<glm::vec3>, std::vector<glm::vec3>> ExplicitEulerIntegrator::integrate(
-    const std::vector<glm::vec3> &X,
-    const std::vector<glm::vec3> &V,
-    float dt,
-    float mass,
-    const std::vector<bool> &pinned,
-    std::function<std::vector<glm::vec3>(const std::vector<glm::vec3> &,
-                                         const std::vector<glm::vec3> &)> computeForces) {
-	size_t N = X.size();
-	std::vector<glm::vec3> Xout = X, Vout = V;
+void ExplicitEulerIntegrator::integrate(ParticleState &state,
+                                        float dt,
+                                        const std::vector<bool> &pinned,
+                                        ForceEvaluator computeForces) {
+	size_t N = state.size();
 
 	// 1) compute forces
-	auto F = computeForces(X, V);
+	F.resize(N);
+	computeForces(state.positions, state.velocities, F);
 
-	// 2) do Euler
-	for (size_t i = 0; i < N; i++) {
-		if (pinned[i])
-			continue;
+	// 2) do Euler, one axis at a time within each chunk of particles
+	const float *invMass = state.inverseMass.data();
+	TaskScheduler::get().parallelFor(0, N, particleGrainSize, [&](size_t begin, size_t end) {
+		for (int axis = 0; axis < 3; axis++) {
+			float *x = state.positions.component(axis);
+			float *v = state.velocities.component(axis);
+			const float *f = F.component(axis);
 
-		glm::vec3 a = F[i] / mass;
-		// v += a dt
-		Vout[i] += a * dt;
-		// x += v dt
-		Xout[i] += Vout[i] * dt;
-	}
+			for (size_t i = begin; i < end; i++) {
+				if (pinned[i])
+					continue;
 
-	// return updated X, V
-	return {Xout, Vout};
-}
\ No newline at end of file
+				// v += a dt
+				v[i] += f[i] * invMass[i] * dt;
+				// x += v dt
+				x[i] += v[i] * dt;
+			}
+		}
+	});
+}
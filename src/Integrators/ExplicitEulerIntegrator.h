@@ -9,15 +9,14 @@
 
 class ExplicitEulerIntegrator : public Integrator {
   public:
-	std::pair<std::vector<glm::vec3>, std::vector<glm::vec3>>
-	integrate(const std::vector<glm::vec3> &X,
-	          const std::vector<glm::vec3> &V,
-	          float dt,
-	          float mass,
-	          const std::vector<bool> &pinned,
-	          std::function<std::vector<glm::vec3>(const std::vector<glm::vec3> &,
-	                                               const std::vector<glm::vec3> &)> computeForces)
-	    override;
+	void integrate(ParticleState &state,
+	               float dt,
+	               const std::vector<bool> &pinned,
+	               ForceEvaluator computeForces) override;
+
+  private:
+	// Force buffer reused across steps
+	Vec3Array F;
 };
 
 #endif // EXPLICITEULERINTEGRATOR_H
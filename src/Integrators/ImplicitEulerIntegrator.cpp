@@ -0,0 +1,252 @@
+//
+// Created by Leonard Chan on 10/15/26.
+//
+
+#include "ImplicitEulerIntegrator.h"
+
+#include "../Cloth.h"
+
+#include <algorithm>
+
+static constexpr size_t springGrainSize = 2048;
+
+ImplicitEulerIntegrator::ImplicitEulerIntegrator(const Cloth &cloth) : cloth(cloth) {}
+
+void ImplicitEulerIntegrator::integrate(ParticleState &state,
+                                        float dt,
+                                        const std::vector<bool> &pinned,
+                                        ForceEvaluator computeForces) {
+	size_t N = state.size();
+	TaskScheduler &scheduler = TaskScheduler::get();
+	const float *invMass = state.inverseMass.data();
+
+	F.resize(N);
+	rhs.resize(N);
+	deltaV.resize(N);
+	residual.resize(N);
+	search.resize(N);
+	product.resize(N);
+	preconditioned.resize(N);
+	fixed.resize(N);
+
+	// Pinned particles, and particles without mass, are filtered out of the solve
+	for (size_t i = 0; i < N; i++) {
+		fixed[i] = pinned[i] || invMass[i] == 0.0f;
+	}
+
+	// 1) Forces at the start of the step; the right-hand side starts as dt * f0
+	computeForces(state.positions, state.velocities, F);
+	scheduler.parallelFor(0, N, particleGrainSize, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			rhs.set(i, dt * F.get(i));
+		}
+	});
+
+	// 2) System matrix, the remaining right-hand side term, and the block Jacobi preconditioner
+	assembledProduct = cloth.usesAssembledSystemProduct();
+	assemble(state, dt);
+	systemMatrix.extractBlockJacobi(inverseBlocks);
+	scheduler.parallelFor(0, N, particleGrainSize, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			if (fixed[i]) {
+				rhs.set(i, glm::vec3(0.0f));
+				inverseBlocks[i] = glm::mat3(0.0f);
+			}
+		}
+	});
+
+	// 3) Preconditioned conjugate gradient, starting from dv = 0
+	deltaV.fill(glm::vec3(0.0f));
+	scheduler.parallelFor(0, N, particleGrainSize, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			glm::vec3 r = rhs.get(i);
+			residual.set(i, r);
+			preconditioned.set(i, inverseBlocks[i] * r);
+			search.set(i, inverseBlocks[i] * r);
+		}
+	});
+
+	double rz = dot(residual, preconditioned);
+	const double threshold = double(tolerance) * double(tolerance) * rz;
+
+	lastIterations = 0;
+	while (rz > threshold && rz > 0.0 && lastIterations < maxIterations) {
+		multiply(search, product, state, dt);
+		double pq = dot(search, product);
+		if (pq <= 0.0)
+			break; // the filtered system is SPD; this only happens on breakdown
+		float alpha = float(rz / pq);
+
+		// dv += alpha p, r -= alpha q, z = P^-1 r, accumulating r . z per chunk
+		partialSums.assign(TaskScheduler::chunkCount(0, N, particleGrainSize), 0.0);
+		scheduler.parallelForChunks(0, N, particleGrainSize, [&](size_t chunk, size_t begin,
+		                                                        size_t end) {
+			double sum = 0.0;
+			for (size_t i = begin; i < end; i++) {
+				deltaV.add(i, alpha * search.get(i));
+				glm::vec3 r = residual.get(i) - alpha * product.get(i);
+				glm::vec3 z = inverseBlocks[i] * r;
+				residual.set(i, r);
+				preconditioned.set(i, z);
+				sum += double(r.x) * z.x + double(r.y) * z.y + double(r.z) * z.z;
+			}
+			partialSums[chunk] = sum;
+		});
+		double rzNext = 0.0;
+		for (double sum : partialSums) {
+			rzNext += sum;
+		}
+
+		float beta = float(rzNext / rz);
+		rz = rzNext;
+		scheduler.parallelFor(0, N, particleGrainSize, [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++) {
+				search.set(i, preconditioned.get(i) + beta * search.get(i));
+			}
+		});
+		lastIterations++;
+	}
+
+	// 4) v1 = v0 + dv, x1 = x0 + dt * v1
+	scheduler.parallelFor(0, N, particleGrainSize, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			if (pinned[i])
+				continue;
+
+			glm::vec3 v = state.velocities.get(i) + deltaV.get(i);
+			state.velocities.set(i, v);
+			state.positions.add(i, dt * v);
+		}
+	});
+}
+
+void ImplicitEulerIntegrator::assemble(const ParticleState &state, float dt) {
+	TaskScheduler &scheduler = TaskScheduler::get();
+	const SpringArrays &springs = cloth.getSpringArrays();
+	const std::vector<uint32_t> &colors = cloth.getSpringColorOffsets();
+	size_t N = state.size();
+	size_t S = springs.size();
+
+	direction.resize(S);
+	kAlong.resize(S);
+	kAcross.resize(S);
+	systemMatrix.setPattern(cloth.getSpringPattern());
+	if (assembledProduct)
+		systemMatrix.setZero(); // otherwise the off-diagonal blocks are neither written nor read
+	scheduler.parallelFor(0, N, particleGrainSize, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			float m = fixed[i] ? 1.0f : 1.0f / state.inverseMass[i];
+			systemMatrix.diagonalBlock(i) = glm::mat3(m);
+		}
+	});
+
+	// Springs of one color touch disjoint particles, so their rows can be written concurrently
+	for (size_t c = 0; c + 1 < colors.size(); c++) {
+		scheduler.parallelFor(colors[c], colors[c + 1], springGrainSize, [&](size_t begin,
+		                                                                      size_t end) {
+			for (size_t k = begin; k < end; k++) {
+				int a = springs.p1[k], b = springs.p2[k];
+				glm::vec3 deltaP = state.positions.get(a) - state.positions.get(b);
+				float dist = glm::length(deltaP);
+				if (dist < 1e-7f || (fixed[a] && fixed[b])) {
+					direction.set(k, glm::vec3(0.0f));
+					kAlong[k] = kAcross[k] = 0.0f;
+					continue;
+				}
+
+				// Hooke spring Jacobian: -ks * (d d^T + (1 - L/l) (I - d d^T)). The transverse
+				// term is clamped at zero for compressed springs to keep the system positive
+				// definite.
+				glm::vec3 d = deltaP / dist;
+				float transverse = std::max(0.0f, 1.0f - springs.restLength[k] / dist);
+				glm::mat3 dd = glm::outerProduct(d, d);
+				direction.set(k, d);
+				kAlong[k] = springs.springConstant[k] * (1.0f - transverse);
+				kAcross[k] = springs.springConstant[k] * transverse;
+
+				glm::vec3 u = state.velocities.get(a) - state.velocities.get(b);
+				glm::vec3 Ku = kAlong[k] * glm::dot(d, u) * d + kAcross[k] * u;
+				rhs.add(a, -dt * dt * Ku);
+				rhs.add(b, dt * dt * Ku);
+
+				float along = dt * springs.damperConstant[k] + dt * dt * kAlong[k];
+				glm::mat3 K = along * dd + glm::mat3(dt * dt * kAcross[k]);
+				if (assembledProduct)
+					systemMatrix.addEdgeCoupling(k, a, b, K);
+				else
+					systemMatrix.addEdgeDiagonal(a, b, K);
+			}
+		});
+	}
+}
+
+void ImplicitEulerIntegrator::multiply(const Vec3Array &p,
+                                       Vec3Array &q,
+                                       const ParticleState &state,
+                                       float dt) {
+	TaskScheduler &scheduler = TaskScheduler::get();
+	const SpringArrays &springs = cloth.getSpringArrays();
+	const std::vector<uint32_t> &colors = cloth.getSpringColorOffsets();
+	const float *invMass = state.inverseMass.data();
+	size_t N = p.size();
+
+	// Search directions are already zero on fixed particles, which filters the columns
+	if (assembledProduct) {
+		systemMatrix.multiply(p, q);
+	} else {
+		// Mass term
+		scheduler.parallelFor(0, N, particleGrainSize, [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++) {
+				float m = fixed[i] ? 0.0f : 1.0f / invMass[i];
+				q.set(i, m * p.get(i));
+			}
+		});
+
+		// Spring terms: (dt * kd + dt^2 * kAlong) d d^T + dt^2 * kAcross * I per spring, one color
+		// at a time so no two springs write the same particle concurrently
+		for (size_t c = 0; c + 1 < colors.size(); c++) {
+			scheduler.parallelFor(colors[c], colors[c + 1], springGrainSize, [&](size_t begin,
+			                                                                      size_t end) {
+				for (size_t k = begin; k < end; k++) {
+					int a = springs.p1[k], b = springs.p2[k];
+					glm::vec3 d = direction.get(k);
+					glm::vec3 u = p.get(a) - p.get(b);
+					float along = dt * springs.damperConstant[k] + dt * dt * kAlong[k];
+					glm::vec3 Cu = along * glm::dot(d, u) * d + dt * dt * kAcross[k] * u;
+					q.add(a, Cu);
+					q.add(b, -Cu);
+				}
+			});
+		}
+	}
+
+	// Filter the rows of fixed particles
+	scheduler.parallelFor(0, N, particleGrainSize, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			if (fixed[i])
+				q.set(i, glm::vec3(0.0f));
+		}
+	});
+}
+
+double ImplicitEulerIntegrator::dot(const Vec3Array &a, const Vec3Array &b) {
+	size_t N = a.size();
+	partialSums.assign(TaskScheduler::chunkCount(0, N, particleGrainSize), 0.0);
+	TaskScheduler::get().parallelForChunks(0, N, particleGrainSize, [&](size_t chunk,
+	                                                                    size_t begin, size_t end) {
+		double sum = 0.0;
+		for (int axis = 0; axis < 3; axis++) {
+			const float *x = a.component(axis), *y = b.component(axis);
+			for (size_t i = begin; i < end; i++) {
+				sum += double(x[i]) * y[i];
+			}
+		}
+		partialSums[chunk] = sum;
+	});
+
+	double total = 0.0;
+	for (double sum : partialSums) {
+		total += sum;
+	}
+	return total;
+}
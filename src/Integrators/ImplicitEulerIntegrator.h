@@ -0,0 +1,73 @@
+//
+// Created by Leonard Chan on 10/15/26.
+//
+
+#ifndef IMPLICITEULERINTEGRATOR_H
+#define IMPLICITEULERINTEGRATOR_H
+
+#include "../Math/BlockSparseMatrix.h"
+#include "Integrator.h"
+
+class Cloth;
+
+// Linearized backward Euler (Baraff & Witkin, "Large Steps in Cloth Simulation").
+// Each step solves
+//     (M - dt * df/dv - dt^2 * df/dx) dv = dt * (f0 + dt * df/dx * v0)
+// with a block Jacobi preconditioned conjugate gradient, then sets v1 = v0 + dv and
+// x1 = x0 + dt * v1. The system matrix lives in a 3x3 block sparse matrix over the cloth's fixed
+// pattern. By default the CG products are taken matrix-free, spring by spring, which streams far
+// less memory than a product with the assembled matrix, and only the diagonal blocks the
+// preconditioner needs are filled. Cloth::setAssembledSystemProduct() switches to assembling the
+// whole matrix and multiplying with it. Pinned particles are removed from the solve by filtering
+// (their rows and columns are projected out), so they keep dv = 0.
+class ImplicitEulerIntegrator : public Integrator {
+  public:
+	explicit ImplicitEulerIntegrator(const Cloth &cloth);
+
+	void integrate(ParticleState &state,
+	               float dt,
+	               const std::vector<bool> &pinned,
+	               ForceEvaluator computeForces) override;
+
+	void setTolerance(float relativeResidual) { tolerance = relativeResidual; }
+	void setMaxIterations(int iterations) { maxIterations = iterations; }
+	int getLastIterationCount() const { return lastIterations; }
+
+  private:
+	// Linearizes the springs at x0, fills the system matrix (only its diagonal blocks for
+	// matrix-free products) and adds the dt^2 * df/dx * v0 term to the right-hand side
+	void assemble(const ParticleState &state, float dt);
+
+	// q = S * A * p, where S zeroes fixed particles, from the assembled matrix or the spring
+	// linearization
+	void multiply(const Vec3Array &p, Vec3Array &q, const ParticleState &state, float dt);
+
+	// Sum of a(i) . b(i) over all particles, reduced in a fixed chunk order
+	double dot(const Vec3Array &a, const Vec3Array &b);
+
+  private:
+	const Cloth &cloth;
+
+	float tolerance = 1e-4f;
+	int maxIterations = 200;
+	int lastIterations = 0;
+
+	// M - dt * df/dv - dt^2 * df/dx; values are refilled every step
+	BlockSparseMatrix systemMatrix;
+	bool assembledProduct = false;
+
+	// Spring linearization: unit direction and the stiffness along / across it, so that
+	// df_a/dx_a = -(kAlong * d d^T + kAcross * I)
+	Vec3Array direction;
+	AlignedVector<float> kAlong, kAcross;
+
+	// 1 for particles that are pinned or have no mass
+	std::vector<uint8_t> fixed;
+
+	// CG state, reused across steps
+	Vec3Array F, rhs, deltaV, residual, search, product, preconditioned;
+	AlignedVector<glm::mat3> inverseBlocks;
+	std::vector<double> partialSums;
+};
+
+#endif // IMPLICITEULERINTEGRATOR_H
@@ -5,23 +5,56 @@
 #ifndef INTEGRATOR_H
 #define INTEGRATOR_H
 
-#include <functional>
+#include "../Kernels/SpringForceKernel.h"
+#include "../ParticleState.h"
+#include "../Tasks/TaskScheduler.h"
+#include "../Utilities/FunctionRef.h"
+
 #include <glm/glm.hpp>
-#include <utility>
 #include <vector>
 
+class CheckpointReader;
+class CheckpointWriter;
+
+// Evaluates the net force on every particle for the given positions and velocities, writing into
+// the caller-provided force array F (already sized to the particle count).
+using ForceEvaluator = FunctionRef<void(const Vec3Array &X, const Vec3Array &V, Vec3Array &F)>;
+
+// Integrators advance a ParticleState in place. Any scratch arrays they need live in the
+// integrator itself and are only reallocated when the particle count changes, so a steady-state
+// step performs no heap allocations.
 class Integrator {
   public:
 	virtual ~Integrator() = default;
 
-	virtual std::pair<std::vector<glm::vec3>, std::vector<glm::vec3>> integrate(
-	    const std::vector<glm::vec3> &X,
-	    const std::vector<glm::vec3> &V,
-	    float dt,
-	    float mass,
-	    const std::vector<bool> &pinned,
-	    std::function<std::vector<glm::vec3>(const std::vector<glm::vec3> &,
-	                                         const std::vector<glm::vec3> &)> computeForces) = 0;
+	// Advances positions and velocities in place by dt
+	virtual void integrate(ParticleState &state,
+	                       float dt,
+	                       const std::vector<bool> &pinned,
+	                       ForceEvaluator computeForces) = 0;
+
+	// Largest spring strain seen by the last integrate(), for integrators that enforce the springs
+	// themselves instead of through computeForces. Others report nothing.
+	virtual SpringStrain getSpringStrain() const { return {}; }
+
+	// Particles were appended to the state between steps, particle i copying sources[i - N] where
+	// N is the old count (e.g. by tearing). Integrators that carry per-particle state from one step
+	// to the next extend it here; the rest resize their scratch on the next integrate().
+	virtual void appendParticles(const std::vector<uint32_t> &sources) { (void)sources; }
+
+	// State carried from one step to the next, for checkpoints. Integrators that rebuild all
+	// their state at the start of each step have none. restoreState() returns false if the
+	// checkpoint holds state that does not fit a cloth of particleCount particles.
+	virtual void saveState(CheckpointWriter &writer) const { (void)writer; }
+	virtual bool restoreState(const CheckpointReader &reader, size_t particleCount) {
+		(void)reader;
+		(void)particleCount;
+		return true;
+	}
+
+  protected:
+	// Particles per task for the per-particle update loops
+	static constexpr size_t particleGrainSize = 4096;
 };
 
 #endif // INTEGRATOR_H
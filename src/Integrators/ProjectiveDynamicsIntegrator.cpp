@@ -0,0 +1,215 @@
+//
+// Created by Leonard Chan on 10/15/26.
+//
+
+#include "ProjectiveDynamicsIntegrator.h"
+
+#include "../Cloth.h"
+#include "../Utilities/Timer.h"
+
+#include <algorithm>
+
+static constexpr size_t springChunkSize = 2048;
+
+ProjectiveDynamicsIntegrator::ProjectiveDynamicsIntegrator(const Cloth &cloth) : cloth(cloth) {}
+
+void ProjectiveDynamicsIntegrator::integrate(ParticleState &state,
+                                             float dt,
+                                             const std::vector<bool> &pinned,
+                                             ForceEvaluator computeForces) {
+	size_t N = state.size();
+	TaskScheduler &scheduler = TaskScheduler::get();
+	const SpringArrays &springs = cloth.getSpringArrays();
+	const std::vector<uint32_t> &colors = cloth.getSpringColorOffsets();
+	const float *invMass = state.inverseMass.data();
+	const glm::vec3 gravity = cloth.getGravity();
+
+	// Spring forces come from the local projections, so the force evaluator is not used
+	(void)computeForces;
+
+	strain.reset();
+
+	// 1) Bring the factorization up to date
+	if (!analyzed || topologyVersion != cloth.getTopologyVersion() || freeIndex.size() != N) {
+		Timer timer;
+		analyze(state, pinned);
+		factorize(state, dt);
+		factorizationMillis = timer.elapsedMillis();
+	} else if (parameterVersion != cloth.getParameterVersion() || factorizedDt != dt) {
+		Timer timer;
+		factorize(state, dt);
+		factorizationMillis = timer.elapsedMillis();
+	}
+	if (!solver.isFactorized())
+		return;
+
+	size_t n = freeParticles.size();
+	prevPositions.resize(N);
+	inertial.resize(N);
+
+	// 2) Inertial target s = x + dt * v + dt^2 * g, which is also the initial guess
+	scheduler.parallelFor(0, N, particleGrainSize, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			glm::vec3 x = state.positions.get(i);
+			prevPositions.set(i, x);
+			if (freeIndex[i] >= 0)
+				x += dt * state.velocities.get(i) + dt * dt * gravity;
+			inertial.set(i, x);
+			state.positions.set(i, x);
+		}
+	});
+
+	// 3) Local/global iterations
+	Timer timer;
+	int iterations = std::max(1, cloth.getSolverIterations());
+	const double inverseDt2 = 1.0 / (double(dt) * dt);
+	for (int iteration = 0; iteration < iterations; iteration++) {
+		const bool lastIteration = iteration + 1 == iterations;
+		scheduler.parallelFor(0, n, particleGrainSize, [&](size_t begin, size_t end) {
+			for (size_t r = begin; r < end; r++) {
+				uint32_t i = freeParticles[r];
+				double weight = inverseDt2 / invMass[i];
+				glm::vec3 s = inertial.get(i);
+				rhs[3 * r] = weight * s.x;
+				rhs[3 * r + 1] = weight * s.y;
+				rhs[3 * r + 2] = weight * s.z;
+			}
+		});
+
+		// Local step: project each spring to its rest length and add ks * d to the right-hand
+		// side of its free ends. A fixed end moves its position to the right-hand side. The last
+		// iteration also records the largest strain it projects.
+		for (size_t c = 0; c + 1 < colors.size(); c++) {
+			scheduler.parallelForChunks(colors[c], colors[c + 1], springChunkSize, [&](size_t,
+			                                                                           size_t begin,
+			                                                                           size_t end) {
+				SpringStrain local;
+				for (size_t k = begin; k < end; k++) {
+					int a = springs.p1[k], b = springs.p2[k];
+					int32_t ra = freeIndex[a], rb = freeIndex[b];
+					if (ra < 0 && rb < 0)
+						continue;
+
+					glm::vec3 xa = state.positions.get(a), xb = state.positions.get(b);
+					glm::vec3 deltaP = xa - xb;
+					float dist = glm::length(deltaP);
+					if (lastIteration) {
+						float ratio = dist / springs.restLength[k];
+						if (!(ratio <= local.maxRatio)) {
+							local.maxRatio = ratio;
+							local.spring = int32_t(k);
+						}
+					}
+					glm::vec3 d = dist > 1e-7f ? springs.restLength[k] / dist * deltaP : deltaP;
+					float ks = springs.springConstant[k];
+
+					if (ra >= 0) {
+						glm::vec3 t = ks * (rb < 0 ? d + xb : d);
+						rhs[3 * ra] += t.x;
+						rhs[3 * ra + 1] += t.y;
+						rhs[3 * ra + 2] += t.z;
+					}
+					if (rb >= 0) {
+						glm::vec3 t = ks * (ra < 0 ? xa - d : -d);
+						rhs[3 * rb] += t.x;
+						rhs[3 * rb + 1] += t.y;
+						rhs[3 * rb + 2] += t.z;
+					}
+				}
+				strain.update(local.maxRatio, local.spring);
+			});
+		}
+
+		// Global step: one prefactorized solve for all three axes
+		solver.solve(rhs.data(), work.data(), 3);
+
+		scheduler.parallelFor(0, n, particleGrainSize, [&](size_t begin, size_t end) {
+			for (size_t r = begin; r < end; r++) {
+				const double *x = rhs.data() + 3 * r;
+				state.positions.set(freeParticles[r], glm::vec3(x[0], x[1], x[2]));
+			}
+		});
+	}
+	iterationMillis = timer.elapsedMillis() / float(iterations);
+
+	// 4) Velocities from the position change
+	const float inverseDt = 1.0f / dt;
+	scheduler.parallelFor(0, n, particleGrainSize, [&](size_t begin, size_t end) {
+		for (size_t r = begin; r < end; r++) {
+			uint32_t i = freeParticles[r];
+			state.velocities.set(i, (state.positions.get(i) - prevPositions.get(i)) * inverseDt);
+		}
+	});
+}
+
+void ProjectiveDynamicsIntegrator::analyze(const ParticleState &state,
+                                           const std::vector<bool> &pinned) {
+	const BlockSparsePattern &pattern = cloth.getSpringPattern();
+	size_t N = state.size();
+
+	// Pinned particles, and particles without mass, are eliminated
+	freeIndex.assign(N, -1);
+	freeParticles.clear();
+	for (size_t i = 0; i < N; i++) {
+		if (!pinned[i] && state.inverseMass[i] > 0.0f) {
+			freeIndex[i] = int32_t(freeParticles.size());
+			freeParticles.push_back(uint32_t(i));
+		}
+	}
+
+	// The reduced pattern is the spring pattern restricted to free rows and columns
+	size_t n = freeParticles.size();
+	rowOffsets.assign(n + 1, 0);
+	columns.clear();
+	reducedEntry.assign(pattern.blockCount(), -1);
+	for (size_t r = 0; r < n; r++) {
+		uint32_t i = freeParticles[r];
+		rowOffsets[r] = uint32_t(columns.size());
+		for (uint32_t b = pattern.rowOffsets[i]; b < pattern.rowOffsets[i + 1]; b++) {
+			int32_t column = freeIndex[pattern.columns[b]];
+			if (column >= 0) {
+				reducedEntry[b] = int32_t(columns.size());
+				columns.push_back(uint32_t(column));
+			}
+		}
+	}
+	rowOffsets[n] = uint32_t(columns.size());
+
+	solver.analyze(n, rowOffsets.data(), columns.data());
+	values.resize(columns.size());
+	rhs.resize(3 * n);
+	work.resize(3 * n);
+
+	analyzed = true;
+	topologyVersion = cloth.getTopologyVersion();
+}
+
+void ProjectiveDynamicsIntegrator::factorize(const ParticleState &state, float dt) {
+	const BlockSparsePattern &pattern = cloth.getSpringPattern();
+	const SpringArrays &springs = cloth.getSpringArrays();
+	const double inverseDt2 = 1.0 / (double(dt) * dt);
+
+	// M / dt^2 + sum over springs of ks * (e_a - e_b)(e_a - e_b)^T, restricted to free particles
+	std::fill(values.begin(), values.end(), 0.0);
+	for (uint32_t i : freeParticles) {
+		values[reducedEntry[pattern.diagonal[i]]] = inverseDt2 / state.inverseMass[i];
+	}
+	for (size_t k = 0; k < springs.size(); k++) {
+		int a = springs.p1[k], b = springs.p2[k];
+		double ks = springs.springConstant[k];
+		if (freeIndex[a] >= 0)
+			values[reducedEntry[pattern.diagonal[a]]] += ks;
+		if (freeIndex[b] >= 0)
+			values[reducedEntry[pattern.diagonal[b]]] += ks;
+		if (freeIndex[a] >= 0 && freeIndex[b] >= 0) {
+			values[reducedEntry[pattern.edgeBlocks[2 * k]]] -= ks;
+			values[reducedEntry[pattern.edgeBlocks[2 * k + 1]]] -= ks;
+		}
+	}
+
+	if (!solver.factorize(values.data()))
+		std::cerr << "Projective dynamics: system matrix is singular, step skipped" << std::endl;
+
+	parameterVersion = cloth.getParameterVersion();
+	factorizedDt = dt;
+}
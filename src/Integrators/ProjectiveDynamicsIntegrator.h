@@ -0,0 +1,81 @@
+//
+// Created by Leonard Chan on 10/15/26.
+//
+
+#ifndef PROJECTIVEDYNAMICSINTEGRATOR_H
+#define PROJECTIVEDYNAMICSINTEGRATOR_H
+
+#include "../Math/SparseLDLT.h"
+#include "../Utilities/IndexedMax.h"
+#include "Integrator.h"
+
+class Cloth;
+
+// Projective Dynamics for mass-spring systems (Liu et al., "Fast Simulation of Mass-Spring
+// Systems"; Bouaziz et al., "Projective Dynamics"). Each step minimizes the implicit Euler
+// energy by alternating
+//   - a local step, projecting every spring onto its rest length (in parallel per spring color)
+//   - a global step, solving (M / dt^2 + L) x = M / dt^2 * s + J d, where L is the spring
+//     Laplacian weighted by the spring constants
+// The global matrix is constant, so it is factorized once with a sparse LDL^T and every
+// iteration is a pair of triangular solves. Pinned particles are eliminated from the system.
+// The factorization is recomputed when the topology or the pins change, and refilled when the
+// spring constants, the mass or dt change. Spring damping is not modelled; implicit Euler's
+// numerical damping takes its place.
+class ProjectiveDynamicsIntegrator : public Integrator {
+  public:
+	explicit ProjectiveDynamicsIntegrator(const Cloth &cloth);
+
+	void integrate(ParticleState &state,
+	               float dt,
+	               const std::vector<bool> &pinned,
+	               ForceEvaluator computeForces) override;
+
+	// Time of the last (re)factorization, including the symbolic analysis when it ran
+	float getFactorizationMillis() const { return factorizationMillis; }
+
+	// Average time of one local/global iteration in the last step
+	float getIterationMillis() const { return iterationMillis; }
+
+	size_t getFactorNonZeros() const { return solver.factorNonZeros(); }
+
+	// Measured by the local step of the last iteration
+	SpringStrain getSpringStrain() const override { return {strain.value(), strain.index()}; }
+
+  private:
+	// Builds the reduced system over the free particles and its symbolic factorization
+	void analyze(const ParticleState &state, const std::vector<bool> &pinned);
+
+	// Fills M / dt^2 + L and factorizes it
+	void factorize(const ParticleState &state, float dt);
+
+  private:
+	const Cloth &cloth;
+
+	SparseLDLT solver;
+	bool analyzed = false;
+	uint64_t topologyVersion = 0, parameterVersion = 0;
+	float factorizedDt = 0.0f;
+
+	// Row of particle i in the reduced system, or -1 for fixed particles
+	std::vector<int32_t> freeIndex;
+	std::vector<uint32_t> freeParticles;
+
+	// Reduced system in CSR form; reducedEntry maps a block of the cloth's spring pattern to its
+	// entry here (or -1 when it touches a fixed particle)
+	std::vector<uint32_t> rowOffsets, columns;
+	std::vector<int32_t> reducedEntry;
+	std::vector<double> values;
+
+	// Right-hand side with the three axes interleaved per row, solved in place, and its scratch
+	std::vector<double> rhs, work;
+
+	Vec3Array inertial, prevPositions;
+
+	float factorizationMillis = 0.0f;
+	float iterationMillis = 0.0f;
+
+	IndexedMax strain;
+};
+
+#endif // PROJECTIVEDYNAMICSINTEGRATOR_H
@@ -8,15 +8,15 @@
 
 class RK4Integrator : public Integrator {
   public:
-	std::pair<std::vector<glm::vec3>, std::vector<glm::vec3>>
-	integrate(const std::vector<glm::vec3> &X,
-	          const std::vector<glm::vec3> &V,
-	          float dt,
-	          float mass,
-	          const std::vector<bool> &pinned,
-	          std::function<std::vector<glm::vec3>(const std::vector<glm::vec3> &,
-	                                               const std::vector<glm::vec3> &)> computeForces)
-	    override;
+	void integrate(ParticleState &state,
+	               float dt,
+	               const std::vector<bool> &pinned,
+	               ForceEvaluator computeForces) override;
+
+  private:
+	// Stage evaluation point, force buffer and the weighted sums of the stage derivatives.
+	// Reused across steps.
+	Vec3Array Xs, Vs, F, sumX, sumV;
 };
 
 #endif // RK4INTEGRATOR_H
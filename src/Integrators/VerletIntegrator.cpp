@@ -4,49 +4,83 @@
 
 #include "VerletIntegrator.h"
 
+#include "../IO/Checkpoint.h"
+
 VerletIntegrator::~VerletIntegrator() {
 	reset(); // Clear internal state when object is destroyed
 }
 
-std::pair<std::vector<glm::vec3>, std::vector<glm::vec3>> VerletIntegrator::integrate(
-    const std::vector<glm::vec3> &X,
-    const std::vector<glm::vec3> &V,
-    float dt,
-    float mass,
-    const std::vector<bool> &pinned,
-    std::function<std::vector<glm::vec3>(const std::vector<glm::vec3> &,
-                                         const std::vector<glm::vec3> &)> computeForces) {
+void VerletIntegrator::integrate(ParticleState &state,
+                                 float dt,
+                                 const std::vector<bool> &pinned,
+                                 ForceEvaluator computeForces) {
+	size_t N = state.size();
 
-	size_t N = X.size();
-	std::vector<glm::vec3> Xout = X;
-	std::vector<glm::vec3> Vout = V;
+	TaskScheduler &scheduler = TaskScheduler::get();
 
-	if (!initialized) {
+	if (!initialized || prevPositions.size() != N) {
 		// Estimate previous positions using backward Euler for initialization
 		prevPositions.resize(N);
-		for (size_t i = 0; i < N; ++i) {
-			prevPositions[i] = X[i] - V[i] * dt;
-		}
+		scheduler.parallelFor(0, N, particleGrainSize, [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; ++i) {
+				prevPositions.set(i, state.positions.get(i) - state.velocities.get(i) * dt);
+			}
+		});
 		initialized = true;
 	}
 
-	auto F = computeForces(X, V);
+	F.resize(N);
+	computeForces(state.positions, state.velocities, F);
+
+	const float *invMass = state.inverseMass.data();
+	scheduler.parallelFor(0, N, particleGrainSize, [&](size_t begin, size_t end) {
+		for (int axis = 0; axis < 3; axis++) {
+			float *x = state.positions.component(axis);
+			float *v = state.velocities.component(axis);
+			float *prev = prevPositions.component(axis);
+			const float *f = F.component(axis);
 
-	for (size_t i = 0; i < N; ++i) {
-		if (pinned[i])
-			continue;
+			for (size_t i = begin; i < end; ++i) {
+				float xi = x[i];
+				if (!pinned[i]) {
+					float a = f[i] * invMass[i];
+					float newX = 2.0f * xi - prev[i] + a * dt * dt;
+					v[i] = (newX - prev[i]) / (2.0f * dt);
+					x[i] = newX;
+				}
+				prev[i] = xi;
+			}
+		}
+	});
+}
 
-		glm::vec3 a = F[i] / mass;
-		glm::vec3 newX = 2.0f * X[i] - prevPositions[i] + a * dt * dt;
-		Vout[i] = (newX - prevPositions[i]) / (2.0f * dt);
-		Xout[i] = newX;
+void VerletIntegrator::appendParticles(const std::vector<uint32_t> &sources) {
+	if (!initialized)
+		return;
+	size_t N = prevPositions.size();
+	prevPositions.resize(N + sources.size());
+	for (size_t i = 0; i < sources.size(); i++) {
+		prevPositions.set(N + i, prevPositions.get(sources[i]));
 	}
+}
+
+void VerletIntegrator::saveState(CheckpointWriter &writer) const {
+	if (initialized)
+		writer.add(CheckpointSection::INTEGRATOR_POSITIONS, prevPositions);
+}
 
-	prevPositions = X;
-	return {Xout, Vout};
+bool VerletIntegrator::restoreState(const CheckpointReader &reader, size_t particleCount) {
+	// Without saved positions they are estimated from the velocities again on the next step
+	size_t count = 0;
+	reset();
+	if (!reader.get<float>(CheckpointSection::INTEGRATOR_POSITIONS, count))
+		return true;
+	initialized =
+	    reader.copy(CheckpointSection::INTEGRATOR_POSITIONS, particleCount, prevPositions);
+	return initialized;
 }
 
 void VerletIntegrator::reset() {
 	initialized = false;
 	prevPositions.clear();
-}
\ No newline at end of file
+}
@@ -11,21 +11,26 @@ class VerletIntegrator : public Integrator {
   public:
 	~VerletIntegrator() override;
 
-	std::pair<std::vector<glm::vec3>, std::vector<glm::vec3>>
-	integrate(const std::vector<glm::vec3> &X,
-	          const std::vector<glm::vec3> &V,
-	          float dt,
-	          float mass,
-	          const std::vector<bool> &pinned,
-	          std::function<std::vector<glm::vec3>(const std::vector<glm::vec3> &,
-	                                               const std::vector<glm::vec3> &)> computeForces)
-	    override;
+	void integrate(ParticleState &state,
+	               float dt,
+	               const std::vector<bool> &pinned,
+	               ForceEvaluator computeForces) override;
+
+	// Copies carry on from their source's previous position, so they keep its velocity
+	void appendParticles(const std::vector<uint32_t> &sources) override;
+
+	// The previous positions, so a restored run continues with the same velocities
+	void saveState(CheckpointWriter &writer) const override;
+	bool restoreState(const CheckpointReader &reader, size_t particleCount) override;
 
   private:
 	// Internal storage for previous positions
-	std::vector<glm::vec3> prevPositions;
+	Vec3Array prevPositions;
 	bool initialized = false;
 
+	// Force buffer reused across steps
+	Vec3Array F;
+
   private:
 	void reset();
 };
@@ -0,0 +1,107 @@
+//
+// Created by Leonard Chan on 10/15/26.
+//
+
+#include "XPBDIntegrator.h"
+
+#include "../Cloth.h"
+
+static constexpr size_t springChunkSize = 2048;
+
+XPBDIntegrator::XPBDIntegrator(const Cloth &cloth) : cloth(cloth) {}
+
+void XPBDIntegrator::integrate(ParticleState &state,
+                               float dt,
+                               const std::vector<bool> &pinned,
+                               ForceEvaluator computeForces) {
+	size_t N = state.size();
+	TaskScheduler &scheduler = TaskScheduler::get();
+	const SpringArrays &springs = cloth.getSpringArrays();
+	const std::vector<uint32_t> &colors = cloth.getSpringColorOffsets();
+	const float *invMass = state.inverseMass.data();
+	const glm::vec3 gravity = cloth.getGravity();
+
+	// Spring forces are replaced by the constraints below, so the force evaluator is not used
+	(void)computeForces;
+
+	prevPositions.resize(N);
+	lambda.assign(springs.size(), 0.0f);
+
+	// 1) Predict positions from the external acceleration
+	scheduler.parallelFor(0, N, particleGrainSize, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			glm::vec3 x = state.positions.get(i);
+			prevPositions.set(i, x);
+			if (pinned[i] || invMass[i] == 0.0f)
+				continue;
+
+			glm::vec3 v = state.velocities.get(i) + dt * gravity;
+			state.positions.set(i, x + dt * v);
+		}
+	});
+
+	// 2) Project the distance constraints. Springs of one color share no particle, so a color is
+	// projected in parallel; running the colors in order makes each sweep Gauss-Seidel.
+	// The last sweep also records the largest strain it finds, one chunk at a time; the chunks are
+	// fixed, so ties go to the same spring whatever the thread count.
+	const float inverseDt2 = 1.0f / (dt * dt);
+	const int iterations = cloth.getSolverIterations();
+	strain.reset();
+	for (int iteration = 0; iteration < iterations; iteration++) {
+		const bool lastSweep = iteration + 1 == iterations;
+		for (size_t c = 0; c + 1 < colors.size(); c++) {
+			scheduler.parallelForChunks(colors[c], colors[c + 1], springChunkSize, [&](size_t,
+			                                                                           size_t begin,
+			                                                                           size_t end) {
+				SpringStrain local;
+				for (size_t k = begin; k < end; k++) {
+					int a = springs.p1[k], b = springs.p2[k];
+					float ks = springs.springConstant[k];
+					float weightSum = invMass[a] + invMass[b];
+					if (ks <= 0.0f || weightSum == 0.0f)
+						continue;
+
+					glm::vec3 deltaP = state.positions.get(a) - state.positions.get(b);
+					float dist = glm::length(deltaP);
+					if (lastSweep) {
+						float ratio = dist / springs.restLength[k];
+						if (!(ratio <= local.maxRatio)) {
+							local.maxRatio = ratio;
+							local.spring = int32_t(k);
+						}
+					}
+					if (dist < 1e-7f)
+						continue;
+
+					glm::vec3 n = deltaP / dist;
+					float C = dist - springs.restLength[k];
+
+					// alphaTilde = compliance / dt^2, gamma = compliance * kd / dt (XPBD eq. 26)
+					float alphaTilde = inverseDt2 / ks;
+					float gamma = springs.damperConstant[k] / (ks * dt);
+					glm::vec3 moved = (state.positions.get(a) - prevPositions.get(a)) -
+					                  (state.positions.get(b) - prevPositions.get(b));
+
+					float deltaLambda = (-C - alphaTilde * lambda[k] - gamma * glm::dot(n, moved)) /
+					                    ((1.0f + gamma) * weightSum + alphaTilde);
+					lambda[k] += deltaLambda;
+
+					state.positions.add(a, invMass[a] * deltaLambda * n);
+					state.positions.add(b, -invMass[b] * deltaLambda * n);
+				}
+				strain.update(local.maxRatio, local.spring);
+			});
+		}
+	}
+
+	// 3) Velocities from the position change
+	const float inverseDt = 1.0f / dt;
+	scheduler.parallelFor(0, N, particleGrainSize, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			if (pinned[i])
+				continue;
+
+			state.velocities.set(i, (state.positions.get(i) - prevPositions.get(i)) * inverseDt);
+		}
+	});
+}
@@ -0,0 +1,41 @@
+//
+// Created by Leonard Chan on 10/15/26.
+//
+
+#ifndef XPBDINTEGRATOR_H
+#define XPBDINTEGRATOR_H
+
+#include "../Utilities/IndexedMax.h"
+#include "Integrator.h"
+
+class Cloth;
+
+// Extended Position Based Dynamics (Macklin et al., "XPBD: Position-Based Simulation of Compliant
+// Constrained Dynamics"). Every spring becomes a distance constraint |xa - xb| = restLength with
+// compliance 1 / springConstant and damping from damperConstant. Only gravity is integrated as a
+// force; the constraints are then projected with Gauss-Seidel over the spring colors, each color
+// in parallel, for cloth.getSolverIterations() sweeps. The step is stable at any dt and its cost
+// is fixed by the iteration count.
+class XPBDIntegrator : public Integrator {
+  public:
+	explicit XPBDIntegrator(const Cloth &cloth);
+
+	void integrate(ParticleState &state,
+	               float dt,
+	               const std::vector<bool> &pinned,
+	               ForceEvaluator computeForces) override;
+
+	// Measured by the last sweep, before its corrections
+	SpringStrain getSpringStrain() const override { return {strain.value(), strain.index()}; }
+
+  private:
+	const Cloth &cloth;
+
+	// Positions at the start of the step and the accumulated Lagrange multipliers
+	Vec3Array prevPositions;
+	AlignedVector<float> lambda;
+
+	IndexedMax strain;
+};
+
+#endif // XPBDINTEGRATOR_H
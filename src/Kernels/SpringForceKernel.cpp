@@ -0,0 +1,353 @@
+//
+// Created by Leonard Chan on 10/15/26.
+//
+
+#include "SpringForceKernel.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define LOOMIX_X86_SIMD 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define LOOMIX_TARGET_AVX2
+#else
+#define LOOMIX_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#endif
+#elif defined(__ARM_NEON) || defined(__aarch64__)
+#define LOOMIX_NEON_SIMD 1
+#include <arm_neon.h>
+#endif
+
+#include <cmath>
+#include <glm/glm.hpp>
+
+void accumulateSpringForcesScalar(const SpringArrays &springs,
+                                  size_t begin,
+                                  size_t end,
+                                  const Vec3Array &positions,
+                                  const Vec3Array &velocities,
+                                  const float *inverseMass,
+                                  Vec3Array &forces,
+                                  SpringStrain &strain) {
+	for (size_t k = begin; k < end; k++) {
+		int iA = springs.p1[k];
+		int iB = springs.p2[k];
+		bool freeA = inverseMass[iA] > 0.0f;
+		bool freeB = inverseMass[iB] > 0.0f;
+
+		// If both endpoints pinned, skip
+		if (!freeA && !freeB) {
+			continue;
+		}
+
+		// Current positions & velocities
+		glm::vec3 deltaP = positions.get(iA) - positions.get(iB);
+		float dist = glm::length(deltaP);
+
+		float ratio = dist / springs.restLength[k];
+		if (!(ratio <= strain.maxRatio)) {
+			strain.maxRatio = std::isnan(ratio) ? INFINITY : ratio;
+			strain.spring = int32_t(k);
+		}
+
+		if (dist < 1e-7f)
+			continue;                  // avoid division by zero
+		glm::vec3 dir = deltaP / dist; // unit direction
+
+		// Hooke’s law: F_spring = -k * (dist - restLen)
+		float stretch = dist - springs.restLength[k];
+
+		// BIPHASIC LOGIC (disabled):
+		// if dist > 1.1 * restLength => scale up springConstant by 2
+
+		float springForceMag = -springs.springConstant[k] * stretch;
+
+		// Per-spring damping force along the line, opposing the relative motion
+		// F_damp = -c * (relative velocity dot dir)
+		glm::vec3 relVel = velocities.get(iA) - velocities.get(iB);
+		float dampingMag = -springs.damperConstant[k] * glm::dot(relVel, dir);
+
+		// Net spring force
+		glm::vec3 force = (springForceMag + dampingMag) * dir;
+
+		// Accumulate force on each particle (skip if pinned)
+		if (freeA)
+			forces.add(iA, force);
+		if (freeB)
+			forces.add(iB, -force);
+	}
+}
+
+#if LOOMIX_X86_SIMD
+// Same math as the scalar kernel, 8 springs per iteration. Endpoint data is gathered, 1/dist comes
+// from rsqrt plus one Newton step (~23 bits, close to a true divide), and springs that are
+// degenerate (dist < 1e-7) or fully pinned are masked out instead of branched around.
+LOOMIX_TARGET_AVX2 static void accumulateSpringForcesAVX2(const SpringArrays &springs,
+                                                          size_t begin,
+                                                          size_t end,
+                                                          const Vec3Array &positions,
+                                                          const Vec3Array &velocities,
+                                                          const float *inverseMass,
+                                                          Vec3Array &forces,
+                                                          SpringStrain &strain) {
+	const float *px = positions.x.data(), *py = positions.y.data(), *pz = positions.z.data();
+	const float *vx = velocities.x.data(), *vy = velocities.y.data(), *vz = velocities.z.data();
+	float *fx = forces.x.data(), *fy = forces.y.data(), *fz = forces.z.data();
+
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const __m256 half = _mm256_set1_ps(0.5f);
+	const __m256 threeHalves = _mm256_set1_ps(1.5f);
+	const __m256 minDist2 = _mm256_set1_ps(1e-7f * 1e-7f);
+	const __m256 infinity = _mm256_set1_ps(INFINITY);
+	const __m256i laneIndex = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+	alignas(32) float outX[8], outY[8], outZ[8];
+	alignas(32) int32_t outA[8], outB[8];
+
+	// Per-lane strain maximum, reduced once at the end
+	__m256 bestRatio = zero;
+	__m256i bestSpring = _mm256_set1_epi32(-1);
+
+	size_t k = begin;
+	for (; k + 8 <= end; k += 8) {
+		__m256i ia = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(&springs.p1[k]));
+		__m256i ib = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(&springs.p2[k]));
+
+		__m256 freeA = _mm256_cmp_ps(_mm256_i32gather_ps(inverseMass, ia, 4), zero, _CMP_GT_OQ);
+		__m256 freeB = _mm256_cmp_ps(_mm256_i32gather_ps(inverseMass, ib, 4), zero, _CMP_GT_OQ);
+
+		__m256 dx = _mm256_sub_ps(_mm256_i32gather_ps(px, ia, 4), _mm256_i32gather_ps(px, ib, 4));
+		__m256 dy = _mm256_sub_ps(_mm256_i32gather_ps(py, ia, 4), _mm256_i32gather_ps(py, ib, 4));
+		__m256 dz = _mm256_sub_ps(_mm256_i32gather_ps(pz, ia, 4), _mm256_i32gather_ps(pz, ib, 4));
+		__m256 dist2 = _mm256_fmadd_ps(dx, dx, _mm256_fmadd_ps(dy, dy, _mm256_mul_ps(dz, dz)));
+
+		__m256 active = _mm256_or_ps(freeA, freeB);
+		__m256 valid = _mm256_and_ps(_mm256_cmp_ps(dist2, minDist2, _CMP_GE_OQ), active);
+		__m256 notFinite = _mm256_and_ps(_mm256_cmp_ps(dist2, infinity, _CMP_NLT_UQ), active);
+		int validBits = _mm256_movemask_ps(valid);
+		if (validBits == 0 && _mm256_movemask_ps(notFinite) == 0)
+			continue;
+
+		// Keep masked lanes finite: rsqrt(0) would turn into NaN forces
+		dist2 = _mm256_blendv_ps(one, dist2, valid);
+		__m256 invDist = _mm256_rsqrt_ps(dist2);
+		// Newton step: r = r * (1.5 - 0.5 * d^2 * r^2)
+		invDist = _mm256_mul_ps(
+		    invDist, _mm256_fnmadd_ps(_mm256_mul_ps(half, dist2),
+		                              _mm256_mul_ps(invDist, invDist), threeHalves));
+		__m256 dist = _mm256_mul_ps(dist2, invDist);
+
+		__m256 dirX = _mm256_mul_ps(dx, invDist);
+		__m256 dirY = _mm256_mul_ps(dy, invDist);
+		__m256 dirZ = _mm256_mul_ps(dz, invDist);
+
+		// Strain: 0 for skipped springs, infinite for non-finite lengths
+		__m256 restLength = _mm256_loadu_ps(&springs.restLength[k]);
+		__m256 ratio = _mm256_and_ps(_mm256_div_ps(dist, restLength), valid);
+		ratio = _mm256_blendv_ps(ratio, infinity, notFinite);
+		__m256 better = _mm256_cmp_ps(ratio, bestRatio, _CMP_GT_OQ);
+		__m256i spring = _mm256_add_epi32(_mm256_set1_epi32(int32_t(k)), laneIndex);
+		bestRatio = _mm256_blendv_ps(bestRatio, ratio, better);
+		bestSpring = _mm256_castps_si256(_mm256_blendv_ps(
+		    _mm256_castsi256_ps(bestSpring), _mm256_castsi256_ps(spring), better));
+
+		// Hooke's law plus damping along the spring, as in the scalar kernel
+		__m256 stretch = _mm256_sub_ps(dist, restLength);
+		__m256 springForceMag = _mm256_fnmadd_ps(_mm256_loadu_ps(&springs.springConstant[k]),
+		                                         stretch, zero);
+
+		__m256 dvx = _mm256_sub_ps(_mm256_i32gather_ps(vx, ia, 4), _mm256_i32gather_ps(vx, ib, 4));
+		__m256 dvy = _mm256_sub_ps(_mm256_i32gather_ps(vy, ia, 4), _mm256_i32gather_ps(vy, ib, 4));
+		__m256 dvz = _mm256_sub_ps(_mm256_i32gather_ps(vz, ia, 4), _mm256_i32gather_ps(vz, ib, 4));
+		__m256 relVelAlong = _mm256_fmadd_ps(
+		    dvx, dirX, _mm256_fmadd_ps(dvy, dirY, _mm256_mul_ps(dvz, dirZ)));
+		__m256 dampingMag =
+		    _mm256_fnmadd_ps(_mm256_loadu_ps(&springs.damperConstant[k]), relVelAlong, zero);
+
+		__m256 magnitude = _mm256_and_ps(_mm256_add_ps(springForceMag, dampingMag), valid);
+		_mm256_store_ps(outX, _mm256_mul_ps(magnitude, dirX));
+		_mm256_store_ps(outY, _mm256_mul_ps(magnitude, dirY));
+		_mm256_store_ps(outZ, _mm256_mul_ps(magnitude, dirZ));
+		_mm256_store_si256(reinterpret_cast<__m256i *>(outA), ia);
+		_mm256_store_si256(reinterpret_cast<__m256i *>(outB), ib);
+
+		// AVX2 has no scatter; the springs of a batch touch distinct particles, so lane order
+		// does not matter
+		int applyA = _mm256_movemask_ps(_mm256_and_ps(valid, freeA));
+		int applyB = _mm256_movemask_ps(_mm256_and_ps(valid, freeB));
+		for (int lane = 0; lane < 8; lane++) {
+			if (applyA & (1 << lane)) {
+				fx[outA[lane]] += outX[lane];
+				fy[outA[lane]] += outY[lane];
+				fz[outA[lane]] += outZ[lane];
+			}
+			if (applyB & (1 << lane)) {
+				fx[outB[lane]] -= outX[lane];
+				fy[outB[lane]] -= outY[lane];
+				fz[outB[lane]] -= outZ[lane];
+			}
+		}
+	}
+
+	_mm256_store_ps(outX, bestRatio);
+	_mm256_store_si256(reinterpret_cast<__m256i *>(outA), bestSpring);
+	for (int lane = 0; lane < 8; lane++) {
+		if (outA[lane] >= 0 && outX[lane] > strain.maxRatio) {
+			strain.maxRatio = outX[lane];
+			strain.spring = outA[lane];
+		}
+	}
+
+	// Remainder
+	accumulateSpringForcesScalar(springs, k, end, positions, velocities, inverseMass, forces,
+	                             strain);
+}
+
+static bool cpuSupportsAVX2() {
+#if defined(_MSC_VER) && !defined(__clang__)
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7)
+		return false;
+
+	__cpuid(info, 1);
+	bool fma = (info[2] & (1 << 12)) != 0;
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	bool avx = (info[2] & (1 << 28)) != 0;
+	// The OS must also save the YMM registers on context switches
+	if (!fma || !osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6)
+		return false;
+
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+}
+#endif // LOOMIX_X86_SIMD
+
+#if LOOMIX_NEON_SIMD
+// 4 springs per iteration. NEON has no gather, so endpoint data is loaded lane by lane. The
+// reciprocal square root estimate is only ~8 bits here, so it takes two Newton steps.
+static void accumulateSpringForcesNEON(const SpringArrays &springs,
+                                       size_t begin,
+                                       size_t end,
+                                       const Vec3Array &positions,
+                                       const Vec3Array &velocities,
+                                       const float *inverseMass,
+                                       Vec3Array &forces,
+                                       SpringStrain &strain) {
+	const float32x4_t zero = vdupq_n_f32(0.0f);
+	const float32x4_t one = vdupq_n_f32(1.0f);
+	const float32x4_t minDist2 = vdupq_n_f32(1e-7f * 1e-7f);
+
+	float dX[4], dY[4], dZ[4], dvX[4], dvY[4], dvZ[4], imA[4], imB[4];
+	float outX[4], outY[4], outZ[4], length[4];
+
+	size_t k = begin;
+	for (; k + 4 <= end; k += 4) {
+		for (int lane = 0; lane < 4; lane++) {
+			int a = springs.p1[k + lane], b = springs.p2[k + lane];
+			dX[lane] = positions.x[a] - positions.x[b];
+			dY[lane] = positions.y[a] - positions.y[b];
+			dZ[lane] = positions.z[a] - positions.z[b];
+			dvX[lane] = velocities.x[a] - velocities.x[b];
+			dvY[lane] = velocities.y[a] - velocities.y[b];
+			dvZ[lane] = velocities.z[a] - velocities.z[b];
+			imA[lane] = inverseMass[a];
+			imB[lane] = inverseMass[b];
+		}
+
+		float32x4_t dx = vld1q_f32(dX), dy = vld1q_f32(dY), dz = vld1q_f32(dZ);
+		float32x4_t dist2 = vmlaq_f32(vmlaq_f32(vmulq_f32(dz, dz), dy, dy), dx, dx);
+
+		uint32x4_t valid = vandq_u32(vcgeq_f32(dist2, minDist2),
+		                             vorrq_u32(vcgtq_f32(vld1q_f32(imA), zero),
+		                                       vcgtq_f32(vld1q_f32(imB), zero)));
+
+		// Keep masked lanes finite
+		dist2 = vbslq_f32(valid, dist2, one);
+		float32x4_t invDist = vrsqrteq_f32(dist2);
+		invDist = vmulq_f32(invDist, vrsqrtsq_f32(vmulq_f32(dist2, invDist), invDist));
+		invDist = vmulq_f32(invDist, vrsqrtsq_f32(vmulq_f32(dist2, invDist), invDist));
+		float32x4_t dist = vmulq_f32(dist2, invDist);
+		vst1q_f32(length, vbslq_f32(valid, dist, zero));
+
+		float32x4_t dirX = vmulq_f32(dx, invDist);
+		float32x4_t dirY = vmulq_f32(dy, invDist);
+		float32x4_t dirZ = vmulq_f32(dz, invDist);
+
+		float32x4_t stretch = vsubq_f32(dist, vld1q_f32(&springs.restLength[k]));
+		float32x4_t springForceMag =
+		    vnegq_f32(vmulq_f32(vld1q_f32(&springs.springConstant[k]), stretch));
+
+		float32x4_t relVelAlong = vmlaq_f32(
+		    vmlaq_f32(vmulq_f32(vld1q_f32(dvZ), dirZ), vld1q_f32(dvY), dirY), vld1q_f32(dvX), dirX);
+		float32x4_t dampingMag =
+		    vnegq_f32(vmulq_f32(vld1q_f32(&springs.damperConstant[k]), relVelAlong));
+
+		float32x4_t magnitude = vbslq_f32(valid, vaddq_f32(springForceMag, dampingMag), zero);
+		vst1q_f32(outX, vmulq_f32(magnitude, dirX));
+		vst1q_f32(outY, vmulq_f32(magnitude, dirY));
+		vst1q_f32(outZ, vmulq_f32(magnitude, dirZ));
+
+		for (int lane = 0; lane < 4; lane++) {
+			int a = springs.p1[k + lane], b = springs.p2[k + lane];
+
+			// Strain, with non-finite lengths as infinite. Masked lanes have length 0.
+			if (imA[lane] > 0.0f || imB[lane] > 0.0f) {
+				float lengthSquared =
+				    dX[lane] * dX[lane] + dY[lane] * dY[lane] + dZ[lane] * dZ[lane];
+				float ratio = std::isfinite(lengthSquared)
+				                  ? length[lane] / springs.restLength[k + lane]
+				                  : INFINITY;
+				if (ratio > strain.maxRatio) {
+					strain.maxRatio = ratio;
+					strain.spring = int32_t(k + lane);
+				}
+			}
+
+			if (imA[lane] > 0.0f) {
+				forces.x[a] += outX[lane];
+				forces.y[a] += outY[lane];
+				forces.z[a] += outZ[lane];
+			}
+			if (imB[lane] > 0.0f) {
+				forces.x[b] -= outX[lane];
+				forces.y[b] -= outY[lane];
+				forces.z[b] -= outZ[lane];
+			}
+		}
+	}
+
+	// Remainder
+	accumulateSpringForcesScalar(springs, k, end, positions, velocities, inverseMass, forces,
+	                             strain);
+}
+#endif // LOOMIX_NEON_SIMD
+
+SpringForceKernel getSpringForceKernel() {
+	static const SpringForceKernel kernel = []() -> SpringForceKernel {
+#if LOOMIX_X86_SIMD
+		if (cpuSupportsAVX2())
+			return accumulateSpringForcesAVX2;
+#elif LOOMIX_NEON_SIMD
+		return accumulateSpringForcesNEON;
+#endif
+		return accumulateSpringForcesScalar;
+	}();
+	return kernel;
+}
+
+const char *getSpringForceKernelName(SpringForceKernel kernel) {
+#if LOOMIX_X86_SIMD
+	if (kernel == accumulateSpringForcesAVX2)
+		return "AVX2";
+#elif LOOMIX_NEON_SIMD
+	if (kernel == accumulateSpringForcesNEON)
+		return "NEON";
+#endif
+	return "Scalar";
+}
@@ -0,0 +1,66 @@
+//
+// Created by Leonard Chan on 10/15/26.
+//
+
+#ifndef SPRINGFORCEKERNEL_H
+#define SPRINGFORCEKERNEL_H
+
+#include "../ParticleState.h"
+#include "../Utilities/AlignedAllocator.h"
+
+#include <cstdint>
+
+// Structure-of-arrays copy of the spring parameters, laid out for the vectorized force kernels
+struct SpringArrays {
+	AlignedVector<int32_t> p1, p2;
+	AlignedVector<float> restLength;
+	AlignedVector<float> springConstant;
+	AlignedVector<float> damperConstant;
+
+	size_t size() const { return p1.size(); }
+
+	void resize(size_t n) {
+		p1.resize(n);
+		p2.resize(n);
+		restLength.resize(n);
+		springConstant.resize(n);
+		damperConstant.resize(n);
+	}
+};
+
+// Largest length / rest length among the springs a kernel call evaluated, and which spring that
+// was. Kernels only ever raise it, so one instance can collect several calls. A non-finite
+// length counts as infinitely stretched.
+struct SpringStrain {
+	float maxRatio = 0.0f;
+	int32_t spring = -1;
+};
+
+// Accumulates the spring and damper forces of springs [begin, end) into forces, and folds their
+// strain into strain. A particle with an inverse mass of 0 is pinned and receives no force;
+// springs with both ends pinned are skipped entirely. Within the range no two springs may share
+// a particle (one color batch), because the SIMD kernels scatter several springs at once.
+using SpringForceKernel = void (*)(const SpringArrays &springs,
+                                   size_t begin,
+                                   size_t end,
+                                   const Vec3Array &positions,
+                                   const Vec3Array &velocities,
+                                   const float *inverseMass,
+                                   Vec3Array &forces,
+                                   SpringStrain &strain);
+
+// Reference implementation, one spring at a time
+void accumulateSpringForcesScalar(const SpringArrays &springs,
+                                  size_t begin,
+                                  size_t end,
+                                  const Vec3Array &positions,
+                                  const Vec3Array &velocities,
+                                  const float *inverseMass,
+                                  Vec3Array &forces,
+                                  SpringStrain &strain);
+
+// Fastest kernel the running CPU supports (AVX2 + FMA, NEON, or the scalar reference)
+SpringForceKernel getSpringForceKernel();
+const char *getSpringForceKernelName(SpringForceKernel kernel);
+
+#endif // SPRINGFORCEKERNEL_H
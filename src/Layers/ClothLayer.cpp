@@ -9,6 +9,8 @@
 #include "../Utilities/Timer.h"
 #include "imgui.h"
 
+#include <algorithm>
+
 ClothLayer::ClothLayer() {
 	// Camera
 	camera = new Camera();
@@ -19,20 +21,26 @@ ClothLayer::ClothLayer() {
 	camera->movementSpeed = 5.0f;
 	camera->sensitivity = 0.1f;
 
-	// Create cloth
+	// Create cloth on its own thread
+	simulation = new SimulationThread();
+	simulation->setTimeStep(userDt);
+	simulation->setSteppingSettings(steppingSettings);
 	setupCloth(); // initialize cloth system
 
 	shader = new Shader("simple.vert", "simple.frag");
 }
 
 ClothLayer::~ClothLayer() {
-	// Cleanup cloth
-	delete cloth;
-	cloth = nullptr;
+	// Stop the simulation thread, which owns the cloth
+	delete simulation;
+	simulation = nullptr;
 
 	// Cleanup FBO
 	cleanupFramebuffer();
 
+	// Cleanup cloth mesh buffers
+	destroyClothMesh();
+
 	// Cleanup shader
 	shader->deleteShader();
 	delete shader;
@@ -47,19 +55,84 @@ void ClothLayer::onUIRender() {
 	ImGui::Begin("Settings");
 	ImGui::Text("FPS: %.2f", ImGui::GetIO().Framerate);
 	ImGui::Text("Last render: %.3fms", lastRenderTime);
-	ImGui::Text("Sim Time: %.2f s", simTime);
+	const ClothSnapshot &snapshot = simulation->getSnapshot();
+	ImGui::Text("Sim Time: %.2f s", snapshot.simTime);
+	ImGui::Text("Last step: %.3fms", snapshot.lastStepMillis);
 
+	bool paused = simulation->isPaused();
 	if (ImGui::Button(paused ? "Resume Simulation" : "Pause Simulation")) {
-		paused = !paused;
+		simulation->setPaused(!paused);
 	}
 
 	if (ImGui::Button("Reset Cloth")) {
-		simTime = 0.0f;
-		delete cloth;
 		setupCloth();
 	}
 
-	ImGui::Checkbox("Pause on Instability Detect", &pauseOnInstability);
+	// Cloth shape: the grid, or a triangle mesh from an OBJ or PLY file
+	ImGui::InputText("Mesh File", meshPath, sizeof(meshPath));
+	if (ImGui::Button("Load Mesh") && loadClothMesh()) {
+		setupCloth();
+	}
+	ImGui::SameLine();
+	if (ImGui::Button("Use Grid") && clothMesh) {
+		clothMesh.reset();
+		setupCloth();
+	}
+	if (clothMesh)
+		ImGui::Text("Mesh: %zu vertices, %zu triangles", clothMesh->positions.size(),
+		            clothMesh->triangles.size() / 3);
+	else
+		ImGui::Text("Grid: %d x %d cells", clothW, clothH);
+
+	// Checkpoints are written and read on the simulation thread, between frames
+	ImGui::InputText("Checkpoint", checkpointPath, sizeof(checkpointPath));
+	if (ImGui::Button("Save Checkpoint")) {
+		simulation->enqueue(
+		    [path = std::string(checkpointPath)](Cloth &cloth) { cloth.saveCheckpoint(path); });
+	}
+	ImGui::SameLine();
+	if (ImGui::Button("Load Checkpoint")) {
+		simulation->enqueue(
+		    [path = std::string(checkpointPath)](Cloth &cloth) { cloth.loadCheckpoint(path); });
+	}
+
+	// Recording streams every frame to a frame cache from a writer thread
+	ImGui::InputText("Frame Cache", recordingPath, sizeof(recordingPath));
+	if (ImGui::Button(snapshot.recording ? "Stop Recording" : "Start Recording")) {
+		if (snapshot.recording)
+			simulation->stopRecording();
+		else
+			simulation->startRecording(recordingPath);
+	}
+	if (snapshot.recording) {
+		double megabytes = double(snapshot.recordedBytes) / (1024.0 * 1024.0);
+		double ratio = double(snapshot.recordedRawBytes) /
+		               double(std::max<uint64_t>(snapshot.recordedBytes, 1));
+		ImGui::Text("Recorded: %llu frames, %.1f MB (%.1fx smaller than floats)",
+		            (unsigned long long)snapshot.recordedFrames, megabytes, ratio);
+		if (snapshot.recordingStallMillis > 0.0f)
+			ImGui::Text("Writer stalls: %.1fms", snapshot.recordingStallMillis);
+	}
+
+	if (ImGui::Checkbox("Pause on Instability Detect", &pauseOnInstability)) {
+		simulation->setPauseOnInstability(pauseOnInstability);
+	}
+
+	if (ImGui::Checkbox("Vectorized Forces", &vectorizedForces)) {
+		simulation->set(&Cloth::setVectorizedForces, vectorizedForces);
+	}
+	ImGui::SameLine();
+	ImGui::TextDisabled("(%s)", snapshot.forceKernelName);
+
+	// Deterministic runs reproduce bit for bit; the hash after each frame tells runs apart
+	if (ImGui::Checkbox("Deterministic", &deterministic)) {
+		simulation->set(&Cloth::setDeterministic, deterministic);
+	}
+	if (snapshot.deterministic) {
+		ImGui::SameLine();
+		ImGui::TextDisabled("(step %llu: %016llx)", (unsigned long long)snapshot.steps,
+		                    (unsigned long long)snapshot.stateHash);
+	}
 
 	// Add toggle button for input mode
 	ImGui::Checkbox("Use Sliders", &useSliders);
@@ -72,84 +145,171 @@ void ClothLayer::onUIRender() {
 	}
 	userDt = glm::max(userDt, 0.0f);
 
+	// Frame budget: bounds the simulation work per frame when steps cost more than their dt
+	bool steppingChanged = false;
+	steppingChanged |= ImGui::SliderFloat("Frame Budget (ms)", &steppingSettings.budgetMillis,
+	                                      1.0f, 100.0f, "%.1f");
+	steppingChanged |= ImGui::SliderInt("Max Substeps", &steppingSettings.maxSubsteps, 1, 64);
+	const char *overrunPolicies[] = {"Drop Time", "Slow Motion", "Degrade Integrator"};
+	if (ImGui::Combo("Overrun Policy", &selectedOverrunPolicy, overrunPolicies,
+	                 IM_ARRAYSIZE(overrunPolicies))) {
+		steppingSettings.policy = static_cast<OverrunPolicy>(selectedOverrunPolicy);
+		steppingChanged = true;
+	}
+	if (steppingChanged)
+		simulation->setSteppingSettings(steppingSettings);
+
+	const SteppingStats &stepping = snapshot.stepping;
+	ImGui::Text("Frame: %d substeps in %.2f ms (overrun %.2f ms)", stepping.substeps,
+	            stepping.stepMillis, stepping.overrunMillis);
+	ImGui::Text("Overrun frames: %llu, dropped %.2f s", (unsigned long long)stepping.overrunFrames,
+	            stepping.droppedSeconds);
+	if (stepping.timeScale < 1.0f)
+		ImGui::Text("Slow motion: %.2fx", stepping.timeScale);
+
+	// Follow the integrator the simulation degraded to
+	if (stepping.degradations != seenDegradations) {
+		seenDegradations = stepping.degradations;
+		integrator = snapshot.integrator;
+		selectedIntegrator = static_cast<int>(integrator);
+	}
+
 	// Particle Mass
 	if (useSliders) {
 		if (ImGui::SliderFloat("Particle Mass", &clothMass, 0.0f, 10.0f, "%.4f")) {
-			cloth->setMass(clothMass);
+			simulation->set(&Cloth::setMass, clothMass);
 		}
 	} else {
 		if (ImGui::InputFloat("Particle Mass", &clothMass, 0.1f, 1.0f, "%.4f")) {
 			clothMass = glm::max(clothMass, 0.001f);
-			cloth->setMass(clothMass);
+			simulation->set(&Cloth::setMass, clothMass);
 		}
 	}
 
 	// Structure Springs
 	if (useSliders) {
 		if (ImGui::SliderFloat("Structure Stiffness", &clothStiffness, 0.0f, 5.0f, "%.4f")) {
-			cloth->setStructureSpringConstant(clothStiffness);
+			simulation->set(&Cloth::setStructureSpringConstant, clothStiffness);
 		}
 		if (ImGui::SliderFloat("Structure Damping", &clothDamping, 0.0f, 2.0f, "%.4f")) {
-			cloth->setStructureDamperConstant(clothDamping);
+			simulation->set(&Cloth::setStructureDamperConstant, clothDamping);
 		}
 	} else {
 		if (ImGui::InputFloat("Structure Stiffness", &clothStiffness, 0.1f, 1.0f, "%.4f")) {
 			clothStiffness = glm::max(clothStiffness, 0.0f);
-			cloth->setStructureSpringConstant(clothStiffness);
+			simulation->set(&Cloth::setStructureSpringConstant, clothStiffness);
 		}
 		if (ImGui::InputFloat("Structure Damping", &clothDamping, 0.01f, 0.1f, "%.4f")) {
 			clothDamping = glm::max(clothDamping, 0.0f);
-			cloth->setStructureDamperConstant(clothDamping);
+			simulation->set(&Cloth::setStructureDamperConstant, clothDamping);
 		}
 	}
 
 	// Shear Springs
 	if (useSliders) {
 		if (ImGui::SliderFloat("Shear Stiffness", &shearStiffness, 0.0f, 5.0f, "%.4f")) {
-			cloth->setShearSpringConstant(shearStiffness);
+			simulation->set(&Cloth::setShearSpringConstant, shearStiffness);
 		}
 		if (ImGui::SliderFloat("Shear Damping", &shearDamping, 0.0f, 2.0f, "%.4f")) {
-			cloth->setShearDamperConstant(shearDamping);
+			simulation->set(&Cloth::setShearDamperConstant, shearDamping);
 		}
 	} else {
 		if (ImGui::InputFloat("Shear Stiffness", &shearStiffness, 0.1f, 1.0f, "%.4f")) {
 			shearStiffness = glm::max(shearStiffness, 0.0f);
-			cloth->setShearSpringConstant(shearStiffness);
+			simulation->set(&Cloth::setShearSpringConstant, shearStiffness);
 		}
 		if (ImGui::InputFloat("Shear Damping", &shearDamping, 0.01f, 0.1f, "%.4f")) {
 			shearDamping = glm::max(shearDamping, 0.0f);
-			cloth->setShearDamperConstant(shearDamping);
+			simulation->set(&Cloth::setShearDamperConstant, shearDamping);
 		}
 	}
 
 	// Bending Springs
 	if (useSliders) {
 		if (ImGui::SliderFloat("Bending Stiffness", &bendingStiffness, 0.0f, 5.0f, "%.4f")) {
-			cloth->setBendingSpringConstant(bendingStiffness);
+			simulation->set(&Cloth::setBendingSpringConstant, bendingStiffness);
 		}
 		if (ImGui::SliderFloat("Bending Damping", &bendingDamping, 0.0f, 2.0f, "%.4f")) {
-			cloth->setBendingDamperConstant(bendingDamping);
+			simulation->set(&Cloth::setBendingDamperConstant, bendingDamping);
 		}
 	} else {
 		if (ImGui::InputFloat("Bending Stiffness", &bendingStiffness, 0.1f, 1.0f, "%.4f")) {
 			bendingStiffness = glm::max(bendingStiffness, 0.0f);
-			cloth->setBendingSpringConstant(bendingStiffness);
+			simulation->set(&Cloth::setBendingSpringConstant, bendingStiffness);
 		}
 		if (ImGui::InputFloat("Bending Damping", &bendingDamping, 0.01f, 0.1f, "%.4f")) {
 			bendingDamping = glm::max(bendingDamping, 0.0f);
-			cloth->setBendingDamperConstant(bendingDamping);
+			simulation->set(&Cloth::setBendingDamperConstant, bendingDamping);
 		}
 	}
 
 	// Max Speed
 	if (useSliders) {
 		if (ImGui::SliderFloat("Max Speed", &maxSpeed, 0.0f, 25.0f, "%.4f")) {
-			cloth->setMaxSpeed(maxSpeed);
+			simulation->set(&Cloth::setMaxSpeed, maxSpeed);
 		}
 	} else {
 		if (ImGui::InputFloat("Max Speed", &maxSpeed, 0.1f, 1.0f, "%.4f")) {
 			maxSpeed = glm::max(maxSpeed, 0.0f);
-			cloth->setMaxSpeed(maxSpeed);
+			simulation->set(&Cloth::setMaxSpeed, maxSpeed);
+		}
+	}
+
+	// Self-collision
+	if (ImGui::Checkbox("Self Collision", &selfCollision)) {
+		simulation->set(&Cloth::setSelfCollision, selfCollision);
+	}
+	if (selfCollision) {
+		ImGui::Text("Self contacts: %zu", snapshot.selfContacts);
+	}
+	if (ImGui::Checkbox("Continuous Collision", &continuousCollision)) {
+		simulation->set(&Cloth::setContinuousCollision, continuousCollision);
+	}
+	if (continuousCollision) {
+		ImGui::Text("Impacts: %zu", snapshot.continuousImpacts);
+	}
+
+	// Tearing
+	if (ImGui::Checkbox("Tearing", &tearing)) {
+		simulation->set(&Cloth::setTearing, tearing);
+	}
+	if (tearing) {
+		static const char *tearLabels[3] = {"Structure Tear Ratio", "Shear Tear Ratio",
+		                                    "Bend Tear Ratio"};
+		for (int type = 0; type < 3; type++) {
+			if (ImGui::SliderFloat(tearLabels[type], &tearRatios[type], 1.01f, 3.0f, "%.2f")) {
+				simulation->enqueue([type, ratio = tearRatios[type]](Cloth &cloth) {
+					cloth.setTearRatio(Spring::SpringType(type), ratio);
+				});
+			}
+		}
+		ImGui::Text("Torn: %zu springs, %zu new particles (%zu particles)", snapshot.tornSprings,
+		            snapshot.splitParticles, snapshot.positions.size());
+	}
+
+	// Colliders
+	bool collidersChanged = ImGui::Checkbox("Ground Plane", &groundCollider);
+	if (groundCollider) {
+		collidersChanged |= ImGui::SliderFloat("Ground Height", &groundHeight, -5.0f, 0.0f, "%.2f");
+	}
+	collidersChanged |= ImGui::Checkbox("Sphere", &sphereCollider);
+	if (sphereCollider) {
+		collidersChanged |= ImGui::SliderFloat("Sphere Radius", &sphereRadius, 0.05f, 2.0f, "%.2f");
+	}
+	if (groundCollider || sphereCollider) {
+		collidersChanged |= ImGui::SliderFloat("Friction", &colliderFriction, 0.0f, 2.0f, "%.2f");
+		collidersChanged |=
+		    ImGui::SliderFloat("Restitution", &colliderRestitution, 0.0f, 1.0f, "%.2f");
+		ImGui::Text("Collider contacts: %zu", snapshot.colliderContacts);
+	}
+	if (collidersChanged) {
+		applyColliders();
+	}
+
+	if (selfCollision || continuousCollision || groundCollider || sphereCollider) {
+		if (ImGui::SliderFloat("Collision Thickness", &collisionThickness, 0.001f, 0.05f,
+		                       "%.4f")) {
+			simulation->set(&Cloth::setCollisionThickness, collisionThickness);
 		}
 	}
 
@@ -158,12 +318,42 @@ void ClothLayer::onUIRender() {
 	const char *pinModes[] = {"None", "Four Corners", "Top Corners"};
 	if (ImGui::Combo("Pin Mode", &selectedPinMode, pinModes, IM_ARRAYSIZE(pinModes))) {
 		pinMode = static_cast<Cloth::PinMode>(selectedPinMode);
-		cloth->pinCorners(pinMode);
+		simulation->set(&Cloth::pinCorners, pinMode);
 	}
 
-	const char *integrationMethods[] = {"Explict Euler", "Runge Kutta", "Verlet"};
+	const char *integrationMethods[] = {"Explict Euler", "Runge Kutta", "Verlet",
+	                                    "Implicit Euler", "XPBD", "Projective Dynamics",
+	                                    "Dormand-Prince (adaptive)"};
 	if (ImGui::Combo("Integration Methodd", &selectedIntegrator, integrationMethods, IM_ARRAYSIZE(integrationMethods))) {
 		integrator = static_cast<Cloth::IntegrationMethod>(selectedIntegrator);
+		simulation->set(&Cloth::setIntegrator, integrator);
+		simulation->set(&Cloth::setSolverIterations, solverIterations);
+		simulation->set(&Cloth::setErrorTolerance, errorTolerance);
+	}
+
+	if (integrator == Cloth::IntegrationMethod::XPBD ||
+	    integrator == Cloth::IntegrationMethod::PROJECTIVE_DYNAMICS) {
+		if (ImGui::SliderInt("Solver Iterations", &solverIterations, 1, 100)) {
+			simulation->set(&Cloth::setSolverIterations, solverIterations);
+		}
+	}
+
+	if (integrator == Cloth::IntegrationMethod::DORMAND_PRINCE) {
+		if (ImGui::SliderFloat("Error Tolerance", &errorTolerance, 1e-6f, 1e-1f, "%.1e",
+		                       ImGuiSliderFlags_Logarithmic)) {
+			simulation->set(&Cloth::setErrorTolerance, errorTolerance);
+		}
+	}
+
+	if (snapshot.hasAdaptiveStats) {
+		ImGui::Text("Substeps: %d (%d rejected), next %.5f s", snapshot.substeps,
+		            snapshot.rejectedSteps, snapshot.adaptiveStepSize);
+	}
+
+	if (snapshot.hasSolverStats) {
+		ImGui::Text("Factorization: %.2f ms (%zu nonzeros)", snapshot.factorizationMillis,
+		            snapshot.factorNonZeros);
+		ImGui::Text("Iteration: %.3f ms", snapshot.iterationMillis);
 	}
 
 	ImGui::End();
@@ -197,26 +387,9 @@ void ClothLayer::onUpdate(float ts) {
 	// 1) Handle camera input always
 	handleCameraInput(ts);
 
-	// 2) If not paused, integrate cloth & accumulate time
-	if (!paused) {
-		timeAccumulator += ts; // add this frame's real time
-
-		// As long as we have enough accumulated time, do sub-steps
-		while (timeAccumulator >= userDt && userDt > 0.0f) {
-			cloth->update(userDt);
-			simTime += userDt;       // track total sim time
-			timeAccumulator -= userDt;
-
-			// Check for instability after each update
-			if (this->pauseOnInstability && cloth->isSpringLengthUnstable() && cloth->isVelocityUnstable()) {
-
-				// Log when instability occurred
-				std::cout << "Instability detected at simulation time: " << simTime << "s" << std::endl;
-				paused = true;
-				break;
-			}
-		}
-	}
+	// 2) The cloth steps on the simulation thread; pick up its latest state
+	simulation->setTimeStep(userDt);
+	simulation->acquireSnapshot();
 
 	// 3) Render
 	renderToFramebuffer(ts);
@@ -354,75 +527,208 @@ void ClothLayer::handleCameraInput(float ts) {
 }
 
 void ClothLayer::drawClothWireframeVBO() {
-	int clothW = cloth->getClothWidth();
-	int clothH = cloth->getClothHeight();
-
-	const auto &parts = cloth->getParticles(); // Each Particle has pos, velocity, etc.
-
-	// Collect line vertices from positions
-	std::vector<glm::vec3> vertices;
-
-	for (int y = 0; y < clothH - 1; y++) {
-		for (int x = 0; x < clothW - 1; x++) {
-			int p00 = y * clothW + x;
-			int p10 = y * clothW + (x + 1);
-			int p01 = (y + 1) * clothW + x;
-			int p11 = (y + 1) * clothW + (x + 1);
-
-			// First triangle
-			vertices.push_back(parts[p00].pos);
-			vertices.push_back(parts[p10].pos);
-			vertices.push_back(parts[p11].pos);
-
-			// Second triangle
-			vertices.push_back(parts[p00].pos);
-			vertices.push_back(parts[p11].pos);
-			vertices.push_back(parts[p01].pos);
+	const ClothSnapshot &snapshot = simulation->getSnapshot();
+	const auto &positions = snapshot.positions; // SoA x/y/z arrays
+	size_t count = positions.size();
+	if (count == 0)
+		return; // nothing published yet
+
+	if (meshIndexBuffer == 0 || snapshot.meshVersion != meshVersion) {
+		if (!createClothMesh(snapshot.meshVersion, count))
+			return; // replaced again since this snapshot; the next one has the new mesh
+	}
+	if (snapshot.trianglePatchCount > meshPatchCount)
+		applyTrianglePatches(snapshot.trianglePatchCount);
+	if (count > meshParticleCapacity)
+		allocatePositionBuffers(count);
+
+	// Next buffer of the ring; invalidating it lets the driver hand out fresh storage instead of
+	// waiting for draws that still read the old contents
+	meshBufferIndex = (meshBufferIndex + 1) % meshBufferCount;
+	glBindBuffer(GL_ARRAY_BUFFER, meshPositionBuffers[meshBufferIndex]);
+	auto *mapped = static_cast<float *>(
+	    glMapBufferRange(GL_ARRAY_BUFFER, 0, count * 3 * sizeof(float),
+	                     GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+	if (mapped) {
+		// One interleaved position per particle
+		for (size_t i = 0; i < count; i++) {
+			mapped[3 * i] = positions.x[i];
+			mapped[3 * i + 1] = positions.y[i];
+			mapped[3 * i + 2] = positions.z[i];
 		}
+		glUnmapBuffer(GL_ARRAY_BUFFER);
 	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-	// Create and bind VAO and VBO
-	unsigned int VAO, VBO;
-	glGenVertexArrays(1, &VAO);
-	glGenBuffers(1, &VBO);
+	glBindVertexArray(meshVAOs[meshBufferIndex]);
+	glDrawElements(GL_TRIANGLES, meshIndexCount, GL_UNSIGNED_INT, (void *)0);
+	glBindVertexArray(0);
+}
 
-	glBindVertexArray(VAO);
+bool ClothLayer::createClothMesh(uint64_t version, size_t particleCount) {
+	// The cloth's own triangles, indexing the particles directly
+	if (!simulation->copyTriangles(version, meshIndices))
+		return false;
+	destroyClothMesh();
+	meshIndexCount = GLsizei(meshIndices.size());
 
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
-	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(glm::vec3), vertices.data(),
-	             GL_DYNAMIC_DRAW);
+	glGenBuffers(1, &meshIndexBuffer);
+	glGenBuffers(meshBufferCount, meshPositionBuffers);
+	glGenVertexArrays(meshBufferCount, meshVAOs);
 
-	// Assume the vertex shader uses location 0 for position attribute
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void *)0);
-	glEnableVertexAttribArray(0);
+	for (int i = 0; i < meshBufferCount; i++) {
+		glBindVertexArray(meshVAOs[i]);
 
-	// Draw lines
-	glDrawArrays(GL_TRIANGLES, 0, vertices.size());
+		// The element buffer binding is VAO state, so every VAO binds the shared index buffer.
+		// Tearing patches it in place.
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, meshIndexBuffer);
+		if (i == 0)
+			glBufferData(GL_ELEMENT_ARRAY_BUFFER, meshIndices.size() * sizeof(uint32_t),
+			             meshIndices.data(), GL_DYNAMIC_DRAW);
 
-	// Cleanup: unbind and delete buffers (or keep them for reuse)
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glBindBuffer(GL_ARRAY_BUFFER, meshPositionBuffers[i]);
+
+		// Assume the vertex shader uses location 0 for position attribute
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *)0);
+		glEnableVertexAttribArray(0);
+	}
 	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
-	glDeleteBuffers(1, &VBO);
-	glDeleteVertexArrays(1, &VAO);
+	meshVersion = version;
+	meshPatchCount = 0;
+	allocatePositionBuffers(particleCount);
+	return true;
+}
+
+void ClothLayer::allocatePositionBuffers(size_t particleCount) {
+	// Tearing keeps adding particles, so grow geometrically
+	meshParticleCapacity = std::max(particleCount, meshParticleCapacity + meshParticleCapacity / 2);
+	for (int i = 0; i < meshBufferCount; i++) {
+		glBindBuffer(GL_ARRAY_BUFFER, meshPositionBuffers[i]);
+		glBufferData(GL_ARRAY_BUFFER, meshParticleCapacity * 3 * sizeof(float), nullptr,
+		             GL_STREAM_DRAW);
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void ClothLayer::applyTrianglePatches(size_t patchCount) {
+	if (!simulation->copyTrianglePatches(meshVersion, meshPatchCount, patchCount, meshPatches))
+		return;
+	size_t first = meshIndices.size(), last = 0;
+	for (const Cloth::TrianglePatch &patch : meshPatches) {
+		meshIndices[patch.corner] = patch.particle;
+		first = std::min(first, size_t(patch.corner));
+		last = std::max(last, size_t(patch.corner) + 1);
+	}
+	meshPatchCount = patchCount;
+
+	// Upload the span the patches touched; the copy-write target leaves the VAOs' element
+	// buffer bindings alone
+	if (first < last) {
+		glBindBuffer(GL_COPY_WRITE_BUFFER, meshIndexBuffer);
+		glBufferSubData(GL_COPY_WRITE_BUFFER, first * sizeof(uint32_t),
+		                (last - first) * sizeof(uint32_t), meshIndices.data() + first);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	}
+}
+
+void ClothLayer::destroyClothMesh() {
+	if (meshIndexBuffer == 0)
+		return;
+
+	glDeleteVertexArrays(meshBufferCount, meshVAOs);
+	glDeleteBuffers(meshBufferCount, meshPositionBuffers);
+	glDeleteBuffers(1, &meshIndexBuffer);
+	meshIndexBuffer = 0;
+	meshIndexCount = 0;
+	meshParticleCapacity = 0;
 }
 
 void ClothLayer::setupCloth() {
-	cloth = new Cloth(clothW, clothH, 0.1f);
-	cloth->setMass(clothMass);
-	cloth->setStructureSpringConstant(clothStiffness);
-	cloth->setStructureDamperConstant(clothDamping);
-	cloth->setShearSpringConstant(shearStiffness);
-	cloth->setShearDamperConstant(shearDamping);
-	cloth->setBendingSpringConstant(bendingStiffness);
-	cloth->setBendingDamperConstant(bendingDamping);
-	cloth->pinCorners(pinMode);
-	cloth->setIntegrator(integrator);
-
-	// Calculate cloth center for camera target
-	float centerX = (clothW - 1) * 0.1f / 2.0f;
-	float centerZ = -(clothH - 1) * 0.1f / 2.0f;
-	camera->target = glm::vec3(centerX, 0.0f, centerZ);
+	// Rebuilt in place on the simulation thread; the values are captured now, so later UI edits
+	// cannot race with it
+	simulation->enqueue([w = uint32_t(clothW), h = uint32_t(clothH), mesh = clothMesh,
+	                     mass = clothMass, ks = clothStiffness, kd = clothDamping,
+	                     shearKs = shearStiffness, shearKd = shearDamping,
+	                     bendKs = bendingStiffness, bendKd = bendingDamping, speed = maxSpeed,
+	                     pin = pinMode,
+	                     method = integrator, iterations = solverIterations,
+	                     tolerance = errorTolerance, vectorized = vectorizedForces](Cloth &cloth) {
+		if (mesh)
+			cloth.init(*mesh);
+		else
+			cloth.init(w, h, 0.1f);
+		cloth.setMass(mass);
+		cloth.setStructureSpringConstant(ks);
+		cloth.setStructureDamperConstant(kd);
+		cloth.setShearSpringConstant(shearKs);
+		cloth.setShearDamperConstant(shearKd);
+		cloth.setBendingSpringConstant(bendKs);
+		cloth.setBendingDamperConstant(bendKd);
+		cloth.setMaxSpeed(speed);
+		cloth.pinCorners(pin);
+		cloth.setIntegrator(method);
+		cloth.setSolverIterations(iterations);
+		cloth.setErrorTolerance(tolerance);
+		cloth.setVectorizedForces(vectorized);
+	});
+	applyColliders();
+	simulation->resetTime();
+
+	// Aim the camera at the middle of the cloth, and back it off far enough to see a whole mesh
+	glm::vec3 lower, upper;
+	getClothBounds(lower, upper);
+	camera->target = 0.5f * (lower + upper);
+	if (clothMesh)
+		camera->distance = glm::max(5.0f, 1.5f * glm::length(upper - lower));
+}
+
+bool ClothLayer::loadClothMesh() {
+	// Loaded here rather than on the simulation thread, so a bad file leaves the cloth alone
+	auto mesh = std::make_shared<TriangleMesh>();
+	if (!loadTriangleMesh(meshPath, *mesh))
+		return false;
+
+	meshLower = meshUpper = mesh->positions[0];
+	for (const glm::vec3 &p : mesh->positions) {
+		meshLower = glm::min(meshLower, p);
+		meshUpper = glm::max(meshUpper, p);
+	}
+	clothMesh = std::move(mesh);
+	return true;
+}
+
+void ClothLayer::getClothBounds(glm::vec3 &lower, glm::vec3 &upper) const {
+	if (clothMesh) {
+		lower = meshLower;
+		upper = meshUpper;
+		return;
+	}
+	// The grid spans x in [0, clothW] and z in [-clothH, 0] cells at y = 0
+	lower = glm::vec3(0.0f, 0.0f, -clothH * 0.1f);
+	upper = glm::vec3(clothW * 0.1f, 0.0f, 0.0f);
+}
+
+void ClothLayer::applyColliders() {
+	// The sphere sits just below the middle of the cloth
+	glm::vec3 lower, upper;
+	getClothBounds(lower, upper);
+	glm::vec3 sphereCenter(0.5f * (lower.x + upper.x), lower.y - sphereRadius - 0.1f,
+	                       0.5f * (lower.z + upper.z));
+	simulation->enqueue([ground = groundCollider, height = groundHeight, sphere = sphereCollider,
+	                     center = sphereCenter, radius = sphereRadius, friction = colliderFriction,
+	                     restitution = colliderRestitution](Cloth &cloth) {
+		ColliderSet &colliders = cloth.getColliders();
+		colliders.clear();
+		if (ground)
+			colliders.addPlane(glm::vec3(0.0f, 1.0f, 0.0f), height);
+		if (sphere)
+			colliders.addSphere(center, radius);
+		colliders.setFriction(friction);
+		colliders.setRestitution(restitution);
+	});
 }
 
 void ClothLayer::cleanupFramebuffer() {
@@ -7,10 +7,14 @@
 
 #include "../Camera.h"
 #include "../Cloth.h"
+#include "../IO/MeshLoader.h"
+#include "../Simulation/SimulationThread.h"
 #include "../Utilities/Shader.h"
 #include "Layer.h"
 #include "glad/glad.h"
 
+#include <memory>
+
 class ClothLayer : public Layer {
   public:
 	ClothLayer();
@@ -27,9 +31,24 @@ class ClothLayer : public Layer {
 
 	GLuint framebuffer = 0, framebufferTexture = 0, rbo = 0;
 
-	// Camera & cloth
+	// Cloth mesh: a ring of position buffers, one VAO each, sharing an index buffer that is
+	// rebuilt only when the cloth is, and patched in place as it tears. meshIndices is its CPU
+	// copy, up to date with meshPatchCount patches of mesh meshVersion.
+	static constexpr int meshBufferCount = 3;
+	GLuint meshVAOs[meshBufferCount] = {}, meshPositionBuffers[meshBufferCount] = {};
+	GLuint meshIndexBuffer = 0;
+	GLsizei meshIndexCount = 0;
+	int meshBufferIndex = 0;
+	uint64_t meshVersion = 0;
+	size_t meshPatchCount = 0;
+	size_t meshParticleCapacity = 0;
+	std::vector<uint32_t> meshIndices;
+	std::vector<Cloth::TrianglePatch> meshPatches;
+
+	// Camera & simulation. The cloth lives on the simulation thread; the layer only sends it
+	// commands and draws the snapshots it publishes.
 	Camera *camera = nullptr;
-	Cloth *cloth = nullptr;
+	SimulationThread *simulation = nullptr;
 
 	// Cloth parameters
 	float clothStiffness = 3.0f;
@@ -38,6 +57,15 @@ class ClothLayer : public Layer {
 	int clothW = 20; // cloth grid width
 	int clothH = 20; // cloth grid height
 
+	// Mesh the cloth is built from instead of the grid, if one is loaded. It is shared with the
+	// simulation thread's rebuild commands, and never modified once loaded.
+	char meshPath[512] = "";
+	std::shared_ptr<const TriangleMesh> clothMesh;
+	glm::vec3 meshLower{0.0f}, meshUpper{0.0f};
+
+	char checkpointPath[512] = "cloth.ckpt";
+	char recordingPath[512] = "cloth.cache";
+
 	float shearStiffness = 1.0f;
 	float shearDamping = 0.01f;
 	float bendingStiffness = 0.5f;
@@ -45,11 +73,27 @@ class ClothLayer : public Layer {
 
 	float maxSpeed = 10.0f;
 
+	bool selfCollision = false;
+	bool continuousCollision = false;
+	bool tearing = false;
+	float tearRatios[3] = {1.5f, 1.75f, 2.0f}; // structure, shear, bend
+	float collisionThickness = 0.02f;
+
+	// Colliders: a ground plane, and a sphere just below the middle of the cloth
+	bool groundCollider = false;
+	float groundHeight = -2.0f;
+	bool sphereCollider = false;
+	float sphereRadius = 0.5f;
+	float colliderFriction = 0.5f;
+	float colliderRestitution = 0.0f;
+
 	int selectedPinMode = static_cast<int>(Cloth::PinMode::TOP_CORNERS);
 	Cloth::PinMode pinMode = Cloth::PinMode::TOP_CORNERS;
 
 	int selectedIntegrator = static_cast<int>(Cloth::IntegrationMethod::EXPLICIT_EULER);
 	Cloth::IntegrationMethod integrator = Cloth::IntegrationMethod::EXPLICIT_EULER;
+	int solverIterations = 10;
+	float errorTolerance = 1e-3f;
 
 	Shader *shader = nullptr;
 
@@ -57,14 +101,16 @@ class ClothLayer : public Layer {
 
 	bool useSliders = true;
 
-	bool paused = false;
 	bool pauseOnInstability = false;
+	bool vectorizedForces = true;
+	bool deterministic = false;
 
-	float timeAccumulator = 0.0f;  // accumulates real time
 	float userDt = 0.016f; // default to ~60 FPS step
 
-	float simTime = 0.0f;
-
+	// Frame budget of the simulation thread
+	SteppingSettings steppingSettings;
+	int selectedOverrunPolicy = static_cast<int>(OverrunPolicy::DROP_TIME);
+	int seenDegradations = 0;
 
   private:
 	void createOrResizeFBO(int width, int height);
@@ -73,9 +119,16 @@ class ClothLayer : public Layer {
 
 	// Cloth rendering
 	void drawClothWireframeVBO();
+	bool createClothMesh(uint64_t version, size_t particleCount);
+	void allocatePositionBuffers(size_t particleCount);
+	void applyTrianglePatches(size_t patchCount);
+	void destroyClothMesh();
 
 	// Helpers
 	void setupCloth();
+	bool loadClothMesh();
+	void getClothBounds(glm::vec3 &lower, glm::vec3 &upper) const;
+	void applyColliders();
 	void cleanupFramebuffer();
 };
 
@@ -0,0 +1,401 @@
+//
+// Created by Leonard Chan on 10/15/26.
+//
+
+#include "Cloth.h"
+#include "Math/BlockSparseMatrix.h"
+#include "Tasks/TaskScheduler.h"
+#include "Utilities/Timer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// Microbenchmarks for the simulation core. Sweeps grid sizes and thread counts and writes one
+// JSON record per (benchmark, grid, threads) with ns/particle, ns/spring, an estimated memory
+// bandwidth and the heap allocations per step:
+//     loomix_bench --sizes 20,256,1024 --threads 1,8 --output bench.json
+
+//------------------------------------
+// Allocation counting: every global operator new in the process goes through here
+
+static std::atomic<size_t> allocationCount{0};
+
+void *operator new(std::size_t size) {
+	allocationCount.fetch_add(1, std::memory_order_relaxed);
+	if (void *p = std::malloc(size ? size : 1))
+		return p;
+	throw std::bad_alloc();
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment) {
+	allocationCount.fetch_add(1, std::memory_order_relaxed);
+	size_t align = static_cast<size_t>(alignment);
+	if (void *p = std::aligned_alloc(align, (size + align - 1) / align * align))
+		return p;
+	throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size) { return operator new(size); }
+void *operator new[](std::size_t size, std::align_val_t alignment) {
+	return operator new(size, alignment);
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete(void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+
+//------------------------------------
+
+struct BenchOptions {
+	std::vector<uint32_t> sizes = {20, 64, 128, 256, 512, 1024};
+	std::vector<unsigned> threads;
+	std::vector<std::string> integrators = {"euler", "rk4", "verlet"};
+	float minSeconds = 0.2f;
+	float dt = 0.016f;
+	std::string output;
+};
+
+// Minimum memory traffic of one iteration, used for the GB/s estimate. Zero means no model.
+struct TrafficModel {
+	double bytesPerParticle = 0.0;
+	double bytesPerSpring = 0.0;
+};
+
+// Spring pass: indices and parameters (20 B), both ends' positions and velocities (48 B) and a
+// read-modify-write of both ends' forces (48 B). Particle pass: force initialization and
+// inverse mass.
+static constexpr TrafficModel forceTraffic{16.0, 116.0};
+
+// Block sparse SpMV: per row x and y, a row offset and the diagonal block with its column and
+// gathered x; per spring the two off-diagonal blocks the same way
+static constexpr TrafficModel spmvTraffic{80.0, 104.0};
+
+struct Measurement {
+	double nsPerIteration = 0.0;
+	double allocationsPerIteration = 0.0;
+	size_t iterations = 0;
+};
+
+// Runs body until at least minSeconds have passed (and at least 3 times) after one warm-up call
+template <typename Body>
+static Measurement measure(float minSeconds, Body &&body) {
+	body();
+
+	Measurement result;
+	size_t allocations = allocationCount.load();
+	Timer timer;
+	float elapsed = 0.0f;
+	while (result.iterations < 3 || elapsed < minSeconds) {
+		body();
+		result.iterations++;
+		elapsed = timer.elapsed();
+	}
+	result.nsPerIteration = elapsed * 1e9 / double(result.iterations);
+	result.allocationsPerIteration =
+	    double(allocationCount.load() - allocations) / double(result.iterations);
+	return result;
+}
+
+struct IntegratorInfo {
+	const char *name;
+	Cloth::IntegrationMethod method;
+	int forceEvaluations;
+	double particleBytes; // particle update and velocity clamp, excluding the force evaluations
+	bool assembledSystemProduct = false;
+};
+
+static const IntegratorInfo integratorTable[] = {
+    {"euler", Cloth::IntegrationMethod::EXPLICIT_EULER, 1, 88.0},
+    {"rk4", Cloth::IntegrationMethod::RUNGE_KUTTA, 4, 312.0},
+    {"verlet", Cloth::IntegrationMethod::VERLET, 1, 100.0},
+    {"implicit", Cloth::IntegrationMethod::IMPLICIT_EULER, 1, 0.0},
+    {"implicit-assembled", Cloth::IntegrationMethod::IMPLICIT_EULER, 1, 0.0, true},
+    {"xpbd", Cloth::IntegrationMethod::XPBD, 0, 0.0},
+    {"pd", Cloth::IntegrationMethod::PROJECTIVE_DYNAMICS, 0, 0.0},
+    {"rk45", Cloth::IntegrationMethod::DORMAND_PRINCE, 0, 0.0},
+};
+
+static const IntegratorInfo *findIntegrator(std::string_view name) {
+	for (const IntegratorInfo &info : integratorTable) {
+		if (name == info.name)
+			return &info;
+	}
+	return nullptr;
+}
+
+class JsonReport {
+  public:
+	explicit JsonReport(std::ostream &out) : out(out) {}
+
+	void add(const std::string &benchmark,
+	         uint32_t size,
+	         unsigned threads,
+	         const Cloth &cloth,
+	         const Measurement &m,
+	         const TrafficModel &traffic) {
+		double particles = double(cloth.getParticles().size());
+		double springs = double(cloth.getSprings().size());
+		double bytes = particles * traffic.bytesPerParticle + springs * traffic.bytesPerSpring;
+
+		out << (records++ ? ",\n" : "") << "    {\"benchmark\": \"" << benchmark
+		    << "\", \"grid\": [" << size << ", " << size << "], \"threads\": " << threads
+		    << ", \"particles\": " << size_t(particles) << ", \"springs\": " << size_t(springs)
+		    << ", \"iterations\": " << m.iterations << ", \"ns_per_step\": " << m.nsPerIteration
+		    << ", \"ns_per_particle\": " << m.nsPerIteration / particles
+		    << ", \"ns_per_spring\": " << m.nsPerIteration / springs << ", \"gb_per_s\": ";
+		if (bytes > 0.0)
+			out << bytes / m.nsPerIteration;
+		else
+			out << "null";
+		out << ", \"allocations_per_step\": " << m.allocationsPerIteration << "}";
+
+		std::cerr << benchmark << " " << size << "x" << size << " threads=" << threads << ": "
+		          << m.nsPerIteration / particles << " ns/particle\n";
+	}
+
+  private:
+	std::ostream &out;
+	size_t records = 0;
+};
+
+template <typename T>
+static bool parseList(const char *text, std::vector<T> &values) {
+	values.clear();
+	std::stringstream stream(text);
+	std::string item;
+	while (std::getline(stream, item, ',')) {
+		char *end = nullptr;
+		long value = std::strtol(item.c_str(), &end, 10);
+		if (end == item.c_str() || *end != '\0' || value < 1)
+			return false;
+		values.push_back(T(value));
+	}
+	return !values.empty();
+}
+
+static bool parseOptions(int argc, char **argv, BenchOptions &options) {
+	for (int i = 1; i < argc; i++) {
+		std::string_view arg = argv[i];
+		if (i + 1 >= argc)
+			return false;
+		const char *value = argv[++i];
+
+		bool ok = true;
+		if (arg == "--sizes") {
+			ok = parseList(value, options.sizes);
+		} else if (arg == "--threads") {
+			ok = parseList(value, options.threads);
+		} else if (arg == "--min-time") {
+			options.minSeconds = std::strtof(value, nullptr);
+			ok = options.minSeconds > 0.0f;
+		} else if (arg == "--dt") {
+			options.dt = std::strtof(value, nullptr);
+			ok = options.dt > 0.0f;
+		} else if (arg == "--output") {
+			options.output = value;
+		} else if (arg == "--integrators") {
+			options.integrators.clear();
+			std::stringstream stream(value);
+			std::string item;
+			while (std::getline(stream, item, ',')) {
+				ok = ok && findIntegrator(item) != nullptr;
+				options.integrators.push_back(item);
+			}
+		} else {
+			ok = false;
+		}
+
+		if (!ok) {
+			std::cerr << "Invalid option " << arg << " " << value << "\n";
+			return false;
+		}
+	}
+	return true;
+}
+
+static void printUsage() {
+	std::cerr << "Usage: loomix_bench [options]\n"
+	             "  --sizes A,B,...        grid sizes in cells (default 20,64,128,256,512,1024)\n"
+	             "  --threads A,B,...      thread counts (default 1, 2, 4, ... hardware threads)\n"
+	             "  --integrators A,B,...  euler, rk4, verlet, implicit, implicit-assembled,\n"
+	             "                         xpbd, pd, rk45 (default euler,rk4,verlet)\n"
+	             "  --min-time S           minimum measuring time per benchmark (default 0.2)\n"
+	             "  --dt T                 integrator time step (default 0.016)\n"
+	             "  --output FILE          write the JSON report to FILE instead of stdout\n";
+}
+
+int main(int argc, char **argv) {
+	BenchOptions options;
+	if (!parseOptions(argc, argv, options)) {
+		printUsage();
+		return 1;
+	}
+
+	unsigned hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+	if (options.threads.empty()) {
+		for (unsigned t = 1; t < hardwareThreads; t *= 2) {
+			options.threads.push_back(t);
+		}
+		options.threads.push_back(hardwareThreads);
+	}
+
+	std::ofstream file;
+	if (!options.output.empty()) {
+		file.open(options.output);
+		if (!file) {
+			std::cerr << "Could not open " << options.output << " for writing" << std::endl;
+			return 1;
+		}
+	}
+	std::ostream &out = options.output.empty() ? std::cout : file;
+
+	Cloth probe;
+#ifdef NDEBUG
+	const bool debugBuild = false;
+#else
+	const bool debugBuild = true;
+#endif
+	out << "{\n  \"machine\": {\"hardware_threads\": " << hardwareThreads
+	    << ", \"force_kernel\": \"" << probe.getForceKernelName()
+	    << "\", \"debug_build\": " << (debugBuild ? "true" : "false") << "},\n  \"results\": [\n";
+
+	JsonReport report(out);
+	for (unsigned threads : options.threads) {
+		TaskScheduler::setThreadCount(threads);
+
+		for (uint32_t size : options.sizes) {
+			// 1) Cloth::init: particles, springs, coloring and the block pattern
+			Cloth cloth;
+			report.add("init", size, threads, cloth,
+			           measure(options.minSeconds, [&]() { cloth.init(size, size, 0.1f); }),
+			           TrafficModel{});
+			cloth.pinCorners(Cloth::PinMode::TOP_CORNERS);
+
+			// 2) One force evaluation on the rest state
+			const ParticleState &state = cloth.getParticles();
+			Vec3Array forces;
+			forces.resize(state.size());
+			report.add("forces", size, threads, cloth, measure(options.minSeconds, [&]() {
+				           cloth.computeForces(state.positions, state.velocities, forces);
+			           }),
+			           forceTraffic);
+
+			// 3) One full step per integrator, starting from a fresh cloth each time
+			for (const std::string &name : options.integrators) {
+				const IntegratorInfo &info = *findIntegrator(name);
+				Cloth stepped(size, size, 0.1f);
+				stepped.pinCorners(Cloth::PinMode::TOP_CORNERS);
+				stepped.setIntegrator(info.method);
+				stepped.setAssembledSystemProduct(info.assembledSystemProduct);
+
+				TrafficModel traffic;
+				if (info.particleBytes > 0.0) {
+					traffic.bytesPerParticle =
+					    info.particleBytes + info.forceEvaluations * forceTraffic.bytesPerParticle;
+					traffic.bytesPerSpring = info.forceEvaluations * forceTraffic.bytesPerSpring;
+				}
+				report.add(std::string("integrator/") + info.name, size, threads, stepped,
+				           measure(options.minSeconds, [&]() { stepped.update(options.dt); }),
+				           traffic);
+			}
+
+			// 4) An explicit Euler step with self-collision; the difference to integrator/euler
+			// is the collision pass
+			Cloth colliding(size, size, 0.1f);
+			colliding.pinCorners(Cloth::PinMode::TOP_CORNERS);
+			colliding.setIntegrator(Cloth::IntegrationMethod::EXPLICIT_EULER);
+			colliding.setSelfCollision(true);
+			report.add("self-collision", size, threads, colliding,
+			           measure(options.minSeconds, [&]() { colliding.update(options.dt); }),
+			           TrafficModel{});
+
+			// 5) An explicit Euler step draping over a sphere and a ground plane, whose cost
+			// over integrator/euler is the collider pass
+			Cloth draped(size, size, 0.1f);
+			draped.pinCorners(Cloth::PinMode::NONE);
+			draped.setIntegrator(Cloth::IntegrationMethod::EXPLICIT_EULER);
+			float extent = size * 0.1f;
+			draped.getColliders().addPlane(glm::vec3(0.0f, 1.0f, 0.0f), -0.5f * extent);
+			draped.getColliders().addSphere(
+			    glm::vec3(0.5f * extent, -0.25f * extent - 0.1f, -0.5f * extent), 0.25f * extent);
+			report.add("colliders", size, threads, draped,
+			           measure(options.minSeconds, [&]() { draped.update(options.dt); }),
+			           TrafficModel{});
+
+			// 6) An explicit Euler step with continuous collision, whose cost over
+			// integrator/euler is the swept-triangle check of the step
+			Cloth swept(size, size, 0.1f);
+			swept.pinCorners(Cloth::PinMode::TOP_CORNERS);
+			swept.setIntegrator(Cloth::IntegrationMethod::EXPLICIT_EULER);
+			swept.setContinuousCollision(true);
+			report.add("continuous-collision", size, threads, swept,
+			           measure(options.minSeconds, [&]() { swept.update(options.dt); }),
+			           TrafficModel{});
+
+			// 7) An explicit Euler step with tearing on, whose cost over integrator/euler is the
+			// tear check of a cloth that holds together (the splits themselves are rare events)
+			Cloth tearable(size, size, 0.1f);
+			tearable.pinCorners(Cloth::PinMode::TOP_CORNERS);
+			tearable.setIntegrator(Cloth::IntegrationMethod::EXPLICIT_EULER);
+			tearable.setTearing(true);
+			report.add("tearing", size, threads, tearable,
+			           measure(options.minSeconds, [&]() { tearable.update(options.dt); }),
+			           TrafficModel{});
+
+			// 8) Triangle BVH over the stepped cloth: a full build, and the per-step refit
+			TriangleBVH bvh;
+			const std::vector<uint32_t> &triangles = colliding.getTriangles();
+			const Vec3Array &positions = colliding.getParticles().positions;
+			report.add("bvh/build", size, threads, colliding,
+			           measure(options.minSeconds, [&]() { bvh.build(triangles, positions); }),
+			           TrafficModel{});
+			report.add("bvh/refit", size, threads, colliding,
+			           measure(options.minSeconds, [&]() { bvh.refit(); }), TrafficModel{});
+
+			// 9) Block sparse matrix over the spring pattern: one SpMV, as in an assembled CG
+			// iteration, and the diagonal and block Jacobi extractions. The values are arbitrary.
+			BlockSparseMatrix matrix;
+			matrix.setPattern(cloth.getSpringPattern());
+			matrix.setZero();
+			const SpringArrays &springs = cloth.getSpringArrays();
+			for (size_t i = 0; i < state.size(); i++) {
+				matrix.diagonalBlock(i) = glm::mat3(1.0f);
+			}
+			for (size_t k = 0; k < springs.size(); k++) {
+				matrix.addEdgeCoupling(k, springs.p1[k], springs.p2[k], glm::mat3(0.01f));
+			}
+			Vec3Array x, y;
+			x.resize(state.size());
+			y.resize(state.size());
+			x.fill(glm::vec3(1.0f));
+			Vec3Array diagonal;
+			AlignedVector<glm::mat3> inverseBlocks;
+			report.add("bsr/spmv", size, threads, cloth,
+			           measure(options.minSeconds, [&]() { matrix.multiply(x, y); }),
+			           spmvTraffic);
+			report.add("bsr/diagonal", size, threads, cloth,
+			           measure(options.minSeconds, [&]() { matrix.extractDiagonal(diagonal); }),
+			           TrafficModel{52.0, 0.0});
+			report.add("bsr/block-jacobi", size, threads, cloth, measure(options.minSeconds, [&]() {
+				           matrix.extractBlockJacobi(inverseBlocks);
+			           }),
+			           TrafficModel{76.0, 0.0});
+		}
+	}
+
+	out << "\n  ]\n}\n";
+	return 0;
+}
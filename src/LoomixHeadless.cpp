@@ -0,0 +1,488 @@
+//
+// Created by Leonard Chan on 10/15/26.
+//
+
+#include "Cloth.h"
+#include "IO/FrameCache.h"
+#include "IO/MeshLoader.h"
+#include "Integrators/DormandPrinceIntegrator.h"
+#include "Tasks/TaskScheduler.h"
+#include "Utilities/Timer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <string_view>
+
+// Runs the cloth simulation without a window, e.g. for batch jobs on display-less servers:
+//     loomix_headless --width 100 --height 100 --integrator xpbd --dt 0.016 --frames 600
+
+struct HeadlessOptions {
+	uint32_t width = 20, height = 20;
+	float spacing = 0.1f;
+	std::string meshPath; // empty = the grid
+	float weldDistance = 0.0f;
+	std::string loadPath, savePath; // checkpoints; empty = none
+	std::string recordPath;         // frame cache; empty = none
+	FrameCacheOptions recordOptions;
+	int frames = 1000;
+	float dt = 0.016f;
+	Cloth::IntegrationMethod integrator = Cloth::IntegrationMethod::EXPLICIT_EULER;
+	Cloth::PinMode pinMode = Cloth::PinMode::TOP_CORNERS;
+
+	// Same defaults as the GUI
+	float mass = 1.0f;
+	float structureStiffness = 3.0f, structureDamping = 0.02f;
+	float shearStiffness = 1.0f, shearDamping = 0.01f;
+	float bendingStiffness = 0.5f, bendingDamping = 0.005f;
+	float maxSpeed = 10.0f;
+	float gravity = 0.00981f;
+	int solverIterations = 10;
+	float errorTolerance = 1e-3f;
+	bool assembledSystemProduct = false;
+	bool vectorizedForces = true;
+	bool deterministic = false;
+	unsigned threads = 0;    // 0 = one per hardware thread
+	std::string hashLogPath; // per-step state hashes; empty = none
+	bool selfCollision = false;
+	bool continuousCollision = false;
+	float collisionThickness = 0.02f;
+	bool tearing = false;
+	float tearRatio = 0.0f; // 0 = the cloth's own ratio for each spring type
+	bool ground = false;
+	float groundHeight = -1.0f;
+	float sphereRadius = 0.0f; // 0 = no sphere
+	float friction = 0.5f, restitution = 0.0f;
+};
+
+static void printUsage() {
+	std::cerr << "Usage: loomix_headless [options]\n"
+	             "  --width N, --height N      cloth resolution in cells (default 20 x 20)\n"
+	             "  --spacing S                rest distance between particles (default 0.1)\n"
+	             "  --mesh FILE                build the cloth from an OBJ or PLY triangle mesh\n"
+	             "  --weld D                   weld mesh vertices closer than D (default 0)\n"
+	             "  --load FILE                resume from a checkpoint; its cloth and parameters\n"
+	             "                             replace the cloth options\n"
+	             "  --save FILE                save a checkpoint after the last step\n"
+	             "  --record FILE              stream every step's positions to a frame cache\n"
+	             "  --keyframe-interval N      frame cache steps per keyframe (default 30)\n"
+	             "  --quantum Q                frame cache position precision (default 1e-4)\n"
+	             "  --frames N                 number of steps to run (default 1000)\n"
+	             "  --dt T                     time step in seconds (default 0.016)\n"
+	             "  --integrator NAME          euler, rk4, verlet, implicit, xpbd, pd or rk45\n"
+	             "  --pin MODE                 none, four or top (default top)\n"
+	             "  --mass M                   mass of each particle (default 1)\n"
+	             "  --ks K, --kd K             structure spring / damper constants\n"
+	             "  --shear-ks K, --shear-kd K\n"
+	             "  --bend-ks K, --bend-kd K\n"
+	             "  --max-speed V              velocity clamp (default 10)\n"
+	             "  --gravity G                downward acceleration (default 0.00981)\n"
+	             "  --iterations N             XPBD / projective dynamics iterations (default 10)\n"
+	             "  --tolerance E              rk45 local error tolerance (default 1e-3)\n"
+	             "  --assembled-product        implicit: multiply with the assembled matrix\n"
+	             "  --scalar-forces            use the scalar spring force kernel\n"
+	             "  --deterministic            reproduce runs bit for bit on any thread count and\n"
+	             "                             x86-64 or AArch64 machine (scalar force kernel)\n"
+	             "  --threads N                threads to run on (default one per CPU thread)\n"
+	             "  --hash-log FILE            write the state hash after every step to FILE\n"
+	             "  --self-collision           enable cloth self-collision\n"
+	             "  --continuous-collision     keep the cloth from passing through itself\n"
+	             "  --thickness T              collision thickness (default 0.02)\n"
+	             "  --tear                     tear springs stretched past their tear ratio\n"
+	             "  --tear-ratio R             tear ratio of every spring type (implies --tear)\n"
+	             "  --ground Y                 ground plane at height Y\n"
+	             "  --sphere R                 sphere of radius R just below the cloth center\n"
+	             "  --friction F               collider friction (default 0.5)\n"
+	             "  --restitution E            collider restitution (default 0)\n";
+}
+
+static bool parseFloat(const char *text, float &value) {
+	char *end = nullptr;
+	value = std::strtof(text, &end);
+	return end != text && *end == '\0' && std::isfinite(value);
+}
+
+static bool parseInt(const char *text, long minimum, long &value) {
+	char *end = nullptr;
+	value = std::strtol(text, &end, 10);
+	return end != text && *end == '\0' && value >= minimum;
+}
+
+static std::string hashToString(uint64_t hash) {
+	char text[17];
+	std::snprintf(text, sizeof(text), "%016llx", (unsigned long long)hash);
+	return text;
+}
+
+static bool parseIntegrator(std::string_view name, Cloth::IntegrationMethod &method) {
+	using Method = Cloth::IntegrationMethod;
+	if (name == "euler")
+		method = Method::EXPLICIT_EULER;
+	else if (name == "rk4")
+		method = Method::RUNGE_KUTTA;
+	else if (name == "verlet")
+		method = Method::VERLET;
+	else if (name == "implicit")
+		method = Method::IMPLICIT_EULER;
+	else if (name == "xpbd")
+		method = Method::XPBD;
+	else if (name == "pd")
+		method = Method::PROJECTIVE_DYNAMICS;
+	else if (name == "rk45")
+		method = Method::DORMAND_PRINCE;
+	else
+		return false;
+	return true;
+}
+
+static bool parsePinMode(std::string_view name, Cloth::PinMode &mode) {
+	if (name == "none")
+		mode = Cloth::PinMode::NONE;
+	else if (name == "four")
+		mode = Cloth::PinMode::FOUR_CORNERS;
+	else if (name == "top")
+		mode = Cloth::PinMode::TOP_CORNERS;
+	else
+		return false;
+	return true;
+}
+
+static bool parseOptions(int argc, char **argv, HeadlessOptions &options) {
+	for (int i = 1; i < argc; i++) {
+		std::string_view arg = argv[i];
+		if (arg == "--help" || arg == "-h")
+			return false;
+		if (arg == "--assembled-product") {
+			options.assembledSystemProduct = true;
+			continue;
+		}
+		if (arg == "--scalar-forces") {
+			options.vectorizedForces = false;
+			continue;
+		}
+		if (arg == "--deterministic") {
+			options.deterministic = true;
+			continue;
+		}
+		if (arg == "--self-collision") {
+			options.selfCollision = true;
+			continue;
+		}
+		if (arg == "--continuous-collision") {
+			options.continuousCollision = true;
+			continue;
+		}
+		if (arg == "--tear") {
+			options.tearing = true;
+			continue;
+		}
+
+		if (i + 1 >= argc) {
+			std::cerr << "Missing value for " << arg << "\n";
+			return false;
+		}
+		const char *value = argv[++i];
+
+		bool ok = true;
+		long n = 0;
+		if (arg == "--width") {
+			ok = parseInt(value, 1, n);
+			options.width = uint32_t(n);
+		} else if (arg == "--height") {
+			ok = parseInt(value, 1, n);
+			options.height = uint32_t(n);
+		} else if (arg == "--mesh") {
+			options.meshPath = value;
+		} else if (arg == "--load") {
+			options.loadPath = value;
+		} else if (arg == "--save") {
+			options.savePath = value;
+		} else if (arg == "--threads") {
+			ok = parseInt(value, 1, n);
+			options.threads = unsigned(n);
+		} else if (arg == "--hash-log") {
+			options.hashLogPath = value;
+		} else if (arg == "--record") {
+			options.recordPath = value;
+		} else if (arg == "--keyframe-interval") {
+			ok = parseInt(value, 1, n);
+			options.recordOptions.keyframeInterval = uint32_t(n);
+		} else if (arg == "--quantum") {
+			ok = parseFloat(value, options.recordOptions.quantum) &&
+			     options.recordOptions.quantum > 0.0f;
+		} else if (arg == "--weld") {
+			ok = parseFloat(value, options.weldDistance) && options.weldDistance >= 0.0f;
+		} else if (arg == "--frames") {
+			ok = parseInt(value, 0, n);
+			options.frames = int(n);
+		} else if (arg == "--iterations") {
+			ok = parseInt(value, 1, n);
+			options.solverIterations = int(n);
+		} else if (arg == "--spacing") {
+			ok = parseFloat(value, options.spacing) && options.spacing > 0.0f;
+		} else if (arg == "--dt") {
+			ok = parseFloat(value, options.dt) && options.dt > 0.0f;
+		} else if (arg == "--mass") {
+			ok = parseFloat(value, options.mass);
+		} else if (arg == "--ks") {
+			ok = parseFloat(value, options.structureStiffness);
+		} else if (arg == "--kd") {
+			ok = parseFloat(value, options.structureDamping);
+		} else if (arg == "--shear-ks") {
+			ok = parseFloat(value, options.shearStiffness);
+		} else if (arg == "--shear-kd") {
+			ok = parseFloat(value, options.shearDamping);
+		} else if (arg == "--bend-ks") {
+			ok = parseFloat(value, options.bendingStiffness);
+		} else if (arg == "--bend-kd") {
+			ok = parseFloat(value, options.bendingDamping);
+		} else if (arg == "--max-speed") {
+			ok = parseFloat(value, options.maxSpeed);
+		} else if (arg == "--tolerance") {
+			ok = parseFloat(value, options.errorTolerance) && options.errorTolerance > 0.0f;
+		} else if (arg == "--thickness") {
+			ok = parseFloat(value, options.collisionThickness) && options.collisionThickness > 0.0f;
+		} else if (arg == "--tear-ratio") {
+			ok = parseFloat(value, options.tearRatio) && options.tearRatio > 1.0f;
+			options.tearing = true;
+		} else if (arg == "--ground") {
+			ok = parseFloat(value, options.groundHeight);
+			options.ground = true;
+		} else if (arg == "--sphere") {
+			ok = parseFloat(value, options.sphereRadius) && options.sphereRadius > 0.0f;
+		} else if (arg == "--friction") {
+			ok = parseFloat(value, options.friction) && options.friction >= 0.0f;
+		} else if (arg == "--restitution") {
+			ok = parseFloat(value, options.restitution) && options.restitution >= 0.0f;
+		} else if (arg == "--gravity") {
+			ok = parseFloat(value, options.gravity);
+		} else if (arg == "--integrator") {
+			ok = parseIntegrator(value, options.integrator);
+		} else if (arg == "--pin") {
+			ok = parsePinMode(value, options.pinMode);
+		} else {
+			std::cerr << "Unknown option " << arg << "\n";
+			return false;
+		}
+
+		if (!ok) {
+			std::cerr << "Invalid value for " << arg << ": " << value << "\n";
+			return false;
+		}
+	}
+	return true;
+}
+
+int main(int argc, char **argv) {
+	HeadlessOptions options;
+	if (!parseOptions(argc, argv, options)) {
+		printUsage();
+		return 1;
+	}
+	if (options.threads > 0)
+		TaskScheduler::setThreadCount(options.threads);
+
+	// 1) Build the cloth the same way ClothLayer::setupCloth does
+	Cloth cloth;
+	TriangleMesh mesh;
+	if (!options.meshPath.empty()) {
+		MeshLoadOptions loadOptions;
+		loadOptions.weldDistance = options.weldDistance;
+		Timer loadTimer;
+		if (!loadTriangleMesh(options.meshPath, mesh, loadOptions))
+			return 1;
+		std::cout << "Mesh: " << options.meshPath << " (" << mesh.positions.size()
+		          << " vertices, " << mesh.triangles.size() / 3 << " triangles, loaded in "
+		          << loadTimer.elapsed() * 1000.0f << " ms)\n";
+		cloth.init(mesh);
+	} else {
+		cloth.init(options.width, options.height, options.spacing);
+	}
+	cloth.setMass(options.mass);
+	cloth.setStructureSpringConstant(options.structureStiffness);
+	cloth.setStructureDamperConstant(options.structureDamping);
+	cloth.setShearSpringConstant(options.shearStiffness);
+	cloth.setShearDamperConstant(options.shearDamping);
+	cloth.setBendingSpringConstant(options.bendingStiffness);
+	cloth.setBendingDamperConstant(options.bendingDamping);
+	cloth.setMaxSpeed(options.maxSpeed);
+	cloth.setGravity(glm::vec3(0.0f, -options.gravity, 0.0f));
+	cloth.pinCorners(options.pinMode);
+	cloth.setIntegrator(options.integrator);
+	cloth.setSolverIterations(options.solverIterations);
+	cloth.setErrorTolerance(options.errorTolerance);
+	cloth.setAssembledSystemProduct(options.assembledSystemProduct);
+	cloth.setVectorizedForces(options.vectorizedForces);
+	cloth.setSelfCollision(options.selfCollision);
+	cloth.setContinuousCollision(options.continuousCollision);
+	cloth.setCollisionThickness(options.collisionThickness);
+	cloth.setTearing(options.tearing);
+	if (options.tearRatio > 0.0f) {
+		for (Spring::SpringType type :
+		     {Spring::SpringType::STRUCTURE, Spring::SpringType::SHEAR, Spring::SpringType::BEND})
+			cloth.setTearRatio(type, options.tearRatio);
+	}
+	if (!options.loadPath.empty()) {
+		if (!cloth.loadCheckpoint(options.loadPath))
+			return 1;
+		std::cout << "Resumed from " << options.loadPath << "\n";
+	}
+	if (options.deterministic)
+		cloth.setDeterministic(true);
+
+	ColliderSet &colliders = cloth.getColliders();
+	colliders.setFriction(options.friction);
+	colliders.setRestitution(options.restitution);
+	if (options.ground)
+		colliders.addPlane(glm::vec3(0.0f, 1.0f, 0.0f), options.groundHeight);
+	const ParticleState &particles = cloth.getParticles();
+	if (options.sphereRadius > 0.0f) {
+		// Just below the middle of the cloth's bounds
+		glm::vec3 lower(INFINITY), upper(-INFINITY);
+		for (size_t i = 0; i < particles.size(); i++) {
+			lower = glm::min(lower, particles.positions.get(i));
+			upper = glm::max(upper, particles.positions.get(i));
+		}
+		float r = options.sphereRadius;
+		colliders.addSphere(glm::vec3(0.5f * (lower.x + upper.x), lower.y - r - options.spacing,
+		                              0.5f * (lower.z + upper.z)),
+		                    r);
+	}
+
+	if (cloth.isGrid())
+		std::cout << "Cloth: " << cloth.getClothWidth() << " x " << cloth.getClothHeight();
+	else
+		std::cout << "Cloth: mesh";
+	std::cout << " (" << particles.size() << " particles, " << cloth.getSprings().size()
+	          << " springs, "
+	          << cloth.getSpringColorCount() << " colors)\n"
+	          << "Threads: " << TaskScheduler::get().getThreadCount()
+	          << ", force kernel: " << cloth.getForceKernelName() << "\n";
+
+	// 2) Step, recording each step if asked to
+	FrameCacheWriter recorder;
+	if (!options.recordPath.empty() && !recorder.open(options.recordPath, options.recordOptions)) {
+		std::cerr << "Frame cache: " << recorder.getError() << std::endl;
+		return 1;
+	}
+	uint64_t recordedMeshVersion = 0;
+	size_t recordedPatchCount = 0;
+	std::ofstream hashLog;
+	if (!options.hashLogPath.empty()) {
+		hashLog.open(options.hashLogPath);
+		if (!hashLog) {
+			std::cerr << "Cannot create " << options.hashLogPath << std::endl;
+			return 1;
+		}
+	}
+
+	auto *adaptive = dynamic_cast<const DormandPrinceIntegrator *>(cloth.getIntegrator());
+	long substeps = 0, rejectedSteps = 0, selfContacts = 0, colliderContacts = 0,
+	     continuousImpacts = 0, tornSprings = 0;
+	Timer timer;
+	for (int frame = 0; frame < options.frames; frame++) {
+		cloth.update(options.dt);
+		selfContacts += long(cloth.getSelfContactCount());
+		colliderContacts += long(cloth.getColliderContactCount());
+		continuousImpacts += long(cloth.getContinuousImpactCount());
+		tornSprings += long(cloth.getTornSpringCount());
+		if (adaptive) {
+			substeps += adaptive->getSubsteps();
+			rejectedSteps += adaptive->getRejectedSteps();
+		}
+		if (hashLog.is_open())
+			hashLog << frame + 1 << " " << hashToString(cloth.computeStateHash()) << "\n";
+		if (recorder.isOpen()) {
+			// The whole mesh with the first step and whenever it is replaced, its patches
+			// otherwise
+			const std::vector<Cloth::TrianglePatch> &patches = cloth.getTrianglePatches();
+			bool withMesh = frame == 0 || recordedMeshVersion != cloth.getMeshVersion();
+			if (withMesh) {
+				recordedMeshVersion = cloth.getMeshVersion();
+				recordedPatchCount = patches.size();
+			}
+			recorder.addFrame(float(frame + 1) * options.dt, particles.positions,
+			                  withMesh ? &cloth.getTriangles() : nullptr,
+			                  patches.data() + recordedPatchCount,
+			                  patches.size() - recordedPatchCount);
+			recordedPatchCount = patches.size();
+		}
+	}
+	float seconds = timer.elapsed();
+	if (recorder.isOpen() && !recorder.close()) {
+		std::cerr << "Frame cache: " << recorder.getError() << std::endl;
+		return 1;
+	}
+
+	// 3) Report the final state
+	glm::vec3 centroid(0.0f), lower(INFINITY), upper(-INFINITY);
+	double kineticEnergy = 0.0;
+	const float mass = cloth.getMass(); // a checkpoint's mass replaces --mass
+	float maxSpeed = 0.0f;
+	bool finite = true;
+	for (size_t i = 0; i < particles.size(); i++) {
+		glm::vec3 x = particles.positions.get(i), v = particles.velocities.get(i);
+		finite = finite && std::isfinite(x.x + x.y + x.z + v.x + v.y + v.z);
+		centroid += x;
+		lower = glm::min(lower, x);
+		upper = glm::max(upper, x);
+		maxSpeed = std::max(maxSpeed, glm::length(v));
+		kineticEnergy += 0.5 * mass * glm::dot(v, v);
+	}
+	centroid /= float(particles.size());
+
+	const Cloth::StabilityReport &stability = cloth.getStabilityReport();
+
+	std::cout << "Steps: " << options.frames << " x dt " << options.dt << " s\n"
+	          << "Wall time: " << seconds * 1000.0f << " ms ("
+	          << (seconds > 0.0f ? options.frames / seconds : 0.0f) << " steps/sec)\n"
+	          << "Centroid: " << centroid.x << " " << centroid.y << " " << centroid.z << "\n"
+	          << "Bounds: [" << lower.x << " " << lower.y << " " << lower.z << "] - [" << upper.x
+	          << " " << upper.y << " " << upper.z << "]\n"
+	          << "Max speed: " << maxSpeed << ", kinetic energy: " << kineticEnergy << "\n"
+	          << "Max strain: " << stability.maxStrain << " (spring " << stability.worstSpring
+	          << "), max speed ratio: " << stability.maxSpeedRatio << " (particle "
+	          << stability.worstParticle << ")\n"
+	          << "Unstable: " << (cloth.isUnstable() ? "yes" : "no") << "\n"
+	          << "State hash: " << hashToString(cloth.computeStateHash())
+	          << (cloth.isDeterministic() ? " (deterministic)" : "") << "\n";
+	if (cloth.isSelfCollisionEnabled()) {
+		std::cout << "Self-collision contacts: " << selfContacts << "\n";
+	}
+	if (!colliders.empty()) {
+		std::cout << "Collider contacts: " << colliderContacts << "\n";
+	}
+	if (cloth.isContinuousCollisionEnabled()) {
+		std::cout << "Continuous collision impacts: " << continuousImpacts << "\n";
+	}
+	if (cloth.isTearingEnabled()) {
+		std::cout << "Torn springs: " << tornSprings << " (" << cloth.getSprings().size()
+		          << " left), particles: " << particles.size() << "\n";
+	}
+	if (!options.recordPath.empty()) {
+		std::cout << "Recorded: " << options.recordPath << " (" << recorder.getFrameCount()
+		          << " frames, " << recorder.getBytesWritten() << " bytes, "
+		          << double(recorder.getRawBytes()) /
+		                 double(std::max<uint64_t>(recorder.getBytesWritten(), 1))
+		          << "x smaller than floats, writer stalls " << recorder.getStallMillis()
+		          << " ms)\n";
+	}
+	if (adaptive) {
+		std::cout << "Substeps: " << substeps << " (" << rejectedSteps << " rejected)\n";
+	}
+
+	if (!finite) {
+		std::cerr << "Simulation diverged: non-finite particle state" << std::endl;
+		return 2;
+	}
+	if (!options.savePath.empty()) {
+		if (!cloth.saveCheckpoint(options.savePath))
+			return 1;
+		std::cout << "Saved " << options.savePath << "\n";
+	}
+	return 0;
+}
@@ -0,0 +1,129 @@
+//
+// Created by Leonard Chan on 10/15/26.
+//
+
+#include "BlockSparseMatrix.h"
+
+#include "../Tasks/TaskScheduler.h"
+
+#include <algorithm>
+#include <cmath>
+
+static constexpr size_t rowGrainSize = 2048;
+
+void BlockSparsePattern::build(size_t numRows,
+                               const int32_t *p1,
+                               const int32_t *p2,
+                               size_t numEdges) {
+	// 1) Upper bound on the blocks per row: the diagonal plus one per incident edge
+	std::vector<uint32_t> offsets(numRows + 1, 0);
+	for (size_t i = 0; i < numRows; i++) {
+		offsets[i + 1] = 1;
+	}
+	for (size_t k = 0; k < numEdges; k++) {
+		offsets[p1[k] + 1]++;
+		offsets[p2[k] + 1]++;
+	}
+	for (size_t i = 0; i < numRows; i++) {
+		offsets[i + 1] += offsets[i];
+	}
+
+	std::vector<uint32_t> cols(offsets[numRows]);
+	std::vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+	for (size_t i = 0; i < numRows; i++) {
+		cols[cursor[i]++] = uint32_t(i);
+	}
+	for (size_t k = 0; k < numEdges; k++) {
+		cols[cursor[p1[k]]++] = uint32_t(p2[k]);
+		cols[cursor[p2[k]]++] = uint32_t(p1[k]);
+	}
+
+	// 2) Sort each row and merge repeated edges
+	rowOffsets.assign(numRows + 1, 0);
+	columns.clear();
+	columns.reserve(cols.size());
+	diagonal.resize(numRows);
+	for (size_t i = 0; i < numRows; i++) {
+		auto first = cols.begin() + offsets[i], last = cols.begin() + offsets[i + 1];
+		std::sort(first, last);
+		last = std::unique(first, last);
+
+		rowOffsets[i] = uint32_t(columns.size());
+		for (auto it = first; it != last; ++it) {
+			if (*it == i)
+				diagonal[i] = uint32_t(columns.size());
+			columns.push_back(*it);
+		}
+	}
+	rowOffsets[numRows] = uint32_t(columns.size());
+
+	// 3) Map each edge to its two off-diagonal blocks
+	auto find = [&](uint32_t row, uint32_t col) {
+		auto first = columns.begin() + rowOffsets[row];
+		auto last = columns.begin() + rowOffsets[row + 1];
+		return uint32_t(std::lower_bound(first, last, col) - columns.begin());
+	};
+	edgeBlocks.resize(2 * numEdges);
+	for (size_t k = 0; k < numEdges; k++) {
+		edgeBlocks[2 * k] = find(p1[k], p2[k]);
+		edgeBlocks[2 * k + 1] = find(p2[k], p1[k]);
+	}
+}
+
+void BlockSparsePattern::clear() {
+	rowOffsets.clear();
+	columns.clear();
+	diagonal.clear();
+	edgeBlocks.clear();
+}
+
+//------------------------------------
+
+void BlockSparseMatrix::setPattern(const BlockSparsePattern &pattern) {
+	this->pattern = &pattern;
+	values.resize(pattern.blockCount());
+}
+
+void BlockSparseMatrix::setZero() {
+	TaskScheduler::get().parallelFor(0, values.size(), rowGrainSize, [&](size_t begin,
+	                                                                     size_t end) {
+		std::fill(values.begin() + begin, values.begin() + end, glm::mat3(0.0f));
+	});
+}
+
+void BlockSparseMatrix::multiply(const Vec3Array &x, Vec3Array &y) const {
+	const uint32_t *offsets = pattern->rowOffsets.data();
+	const uint32_t *cols = pattern->columns.data();
+
+	// Each row is written by exactly one task, so no synchronization is needed
+	TaskScheduler::get().parallelFor(0, rows(), rowGrainSize, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			glm::vec3 sum(0.0f);
+			for (uint32_t j = offsets[i]; j < offsets[i + 1]; j++) {
+				sum += values[j] * x.get(cols[j]);
+			}
+			y.set(i, sum);
+		}
+	});
+}
+
+void BlockSparseMatrix::extractDiagonal(Vec3Array &diagonal) const {
+	diagonal.resize(rows());
+	TaskScheduler::get().parallelFor(0, rows(), rowGrainSize, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			const glm::mat3 &D = diagonalBlock(i);
+			diagonal.set(i, glm::vec3(D[0][0], D[1][1], D[2][2]));
+		}
+	});
+}
+
+void BlockSparseMatrix::extractBlockJacobi(AlignedVector<glm::mat3> &inverseBlocks) const {
+	inverseBlocks.resize(rows());
+	TaskScheduler::get().parallelFor(0, rows(), rowGrainSize, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			const glm::mat3 &D = diagonalBlock(i);
+			float det = glm::determinant(D);
+			inverseBlocks[i] = std::abs(det) > 1e-20f ? glm::inverse(D) : glm::mat3(0.0f);
+		}
+	});
+}
@@ -0,0 +1,88 @@
+//
+// Created by Leonard Chan on 10/15/26.
+//
+
+#ifndef BLOCKSPARSEMATRIX_H
+#define BLOCKSPARSEMATRIX_H
+
+#include "../ParticleState.h"
+#include "../Utilities/AlignedAllocator.h"
+
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vector>
+
+// Sparsity pattern of a symmetric matrix of 3x3 blocks in block compressed sparse row (BSR)
+// layout. Row i couples particle i to itself and to every particle it shares an edge (spring)
+// with. The pattern only depends on the topology, so it is built once and shared by all matrices
+// assembled over the same edges.
+struct BlockSparsePattern {
+	// Row i owns blocks [rowOffsets[i], rowOffsets[i + 1]), sorted by column
+	std::vector<uint32_t> rowOffsets;
+	std::vector<uint32_t> columns;
+
+	// Block index of (i, i) for each row
+	std::vector<uint32_t> diagonal;
+
+	// Block indices of (a, b) and (b, a) for edge k, at 2k and 2k + 1
+	std::vector<uint32_t> edgeBlocks;
+
+	size_t rows() const { return diagonal.size(); }
+	size_t blockCount() const { return columns.size(); }
+
+	// Edge k joins rows p1[k] and p2[k]. Repeated edges share their blocks.
+	void build(size_t numRows, const int32_t *p1, const int32_t *p2, size_t numEdges);
+
+	void clear();
+};
+
+// 3x3 block sparse matrix over a BlockSparsePattern. Values are refilled in place every step, so
+// assembling a new system matrix never allocates once the value array has grown to size.
+class BlockSparseMatrix {
+  public:
+	// Binds the matrix to a pattern, which must outlive it. Values are left unspecified.
+	void setPattern(const BlockSparsePattern &pattern);
+	const BlockSparsePattern *getPattern() const { return pattern; }
+
+	size_t rows() const { return pattern ? pattern->rows() : 0; }
+
+	void setZero();
+
+	glm::mat3 &block(uint32_t index) { return values[index]; }
+	const glm::mat3 &block(uint32_t index) const { return values[index]; }
+
+	glm::mat3 &diagonalBlock(size_t row) { return values[pattern->diagonal[row]]; }
+	const glm::mat3 &diagonalBlock(size_t row) const { return values[pattern->diagonal[row]]; }
+
+	// Adds the stencil of a symmetric coupling K along edge k between rows a and b:
+	//     A(a, a) += K, A(b, b) += K, A(a, b) -= K, A(b, a) -= K
+	// Edges that share no rows can be added concurrently (one spring color at a time).
+	void addEdgeCoupling(size_t edge, int32_t a, int32_t b, const glm::mat3 &K) {
+		values[pattern->diagonal[a]] += K;
+		values[pattern->diagonal[b]] += K;
+		values[pattern->edgeBlocks[2 * edge]] -= K;
+		values[pattern->edgeBlocks[2 * edge + 1]] -= K;
+	}
+
+	// The diagonal half of addEdgeCoupling, for users that only read the diagonal blocks
+	void addEdgeDiagonal(int32_t a, int32_t b, const glm::mat3 &K) {
+		values[pattern->diagonal[a]] += K;
+		values[pattern->diagonal[b]] += K;
+	}
+
+	// y = A * x, parallel over rows
+	void multiply(const Vec3Array &x, Vec3Array &y) const;
+
+	// Scalar diagonal, one vec3 (the diagonal of block (i, i)) per row
+	void extractDiagonal(Vec3Array &diagonal) const;
+
+	// Inverse of each diagonal block, for a block Jacobi preconditioner. Singular blocks yield
+	// a zero inverse.
+	void extractBlockJacobi(AlignedVector<glm::mat3> &inverseBlocks) const;
+
+  private:
+	const BlockSparsePattern *pattern = nullptr;
+	AlignedVector<glm::mat3> values;
+};
+
+#endif // BLOCKSPARSEMATRIX_H
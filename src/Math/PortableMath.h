@@ -0,0 +1,83 @@
+//
+// Created by Leonard Chan on 10/15/26.
+//
+
+#ifndef PORTABLEMATH_H
+#define PORTABLEMATH_H
+
+#include <cmath>
+#include <cstdint>
+
+// Replacements for the libm functions the simulation step needs. libm's transcendental functions
+// are not correctly rounded, so their last bits differ between platforms and library versions.
+// These only use +, -, *, /, frexp, ldexp and round, which IEEE 754 defines exactly, so they
+// give the same bits on every machine. That is what lets deterministic runs be compared across
+// machines (loomix_core is also compiled without floating-point contraction, see CMakeLists.txt).
+
+// sin and cos of angle. Quarter turns are taken off first, leaving |r| <= pi/4 for Taylor series
+// evaluated in double, which are accurate far beyond float precision there. The reduction
+// itself loses accuracy for huge angles, but loses it the same way everywhere.
+inline void portableSinCos(float angle, float &sine, float &cosine) {
+	constexpr double halfPi = 1.57079632679489661923;
+	double turns = std::round(double(angle) / halfPi);
+	double r = double(angle) - turns * halfPi;
+	double r2 = r * r;
+
+	double s = 1.0 / 1307674368000.0; // 1 / 15!
+	s = 1.0 / 6227020800.0 - r2 * s;
+	s = 1.0 / 39916800.0 - r2 * s;
+	s = 1.0 / 362880.0 - r2 * s;
+	s = 1.0 / 5040.0 - r2 * s;
+	s = 1.0 / 120.0 - r2 * s;
+	s = 1.0 / 6.0 - r2 * s;
+	s = r * (1.0 - r2 * s);
+
+	double c = 1.0 / 20922789888000.0; // 1 / 16!
+	c = 1.0 / 87178291200.0 - r2 * c;
+	c = 1.0 / 479001600.0 - r2 * c;
+	c = 1.0 / 3628800.0 - r2 * c;
+	c = 1.0 / 40320.0 - r2 * c;
+	c = 1.0 / 720.0 - r2 * c;
+	c = 1.0 / 24.0 - r2 * c;
+	c = 1.0 / 2.0 - r2 * c;
+	c = 1.0 - r2 * c;
+
+	switch (int64_t(turns - 4.0 * std::floor(turns / 4.0))) {
+	case 0:
+		sine = float(s), cosine = float(c);
+		break;
+	case 1:
+		sine = float(c), cosine = float(-s);
+		break;
+	case 2:
+		sine = float(-s), cosine = float(-c);
+		break;
+	default:
+		sine = float(-c), cosine = float(s);
+		break;
+	}
+}
+
+// x^(-1/5) for x > 0, and 0 for an infinite or NaN x. A start within a factor of 2^(1/5) from
+// the exponent of x, then Newton steps on y^-5 = x, which converge quadratically.
+inline float portableInverseFifthRoot(float x) {
+	if (!(x < INFINITY))
+		return 0.0f;
+
+	// x = m * 2^(5q + k) with m in [0.5, 1) and k in [0, 4], so y = 2^-q * 2^(-k/5) puts x * y^5
+	// at m
+	static constexpr double rootsOfTwo[5] = {1.0, 0.87055056329612413, 0.75785828325519912,
+	                                         0.65975395538644721, 0.57434917749851755};
+	int exponent;
+	std::frexp(double(x), &exponent);
+	int q = exponent >= 0 ? exponent / 5 : -((4 - exponent) / 5);
+	double y = std::ldexp(rootsOfTwo[exponent - 5 * q], -q);
+
+	for (int i = 0; i < 5; i++) {
+		double y5 = y * y * y * y * y;
+		y = y * (6.0 - double(x) * y5) / 5.0;
+	}
+	return float(y);
+}
+
+#endif // PORTABLEMATH_H
@@ -0,0 +1,250 @@
+//
+// Created by Leonard Chan on 10/15/26.
+//
+
+#include "SparseLDLT.h"
+
+#include <algorithm>
+
+// Sets at or below this size are not split further
+static constexpr size_t dissectionLeafSize = 32;
+
+void SparseLDLT::analyze(size_t n, const uint32_t *rowOffsets, const uint32_t *columns) {
+	factorized = false;
+	computeOrdering(n, rowOffsets, columns);
+
+	// 1) Upper triangle of P A P^T by columns. A is symmetric, so row perm[k] of A is column k.
+	Ap.assign(n + 1, 0);
+	Ai.clear();
+	source.clear();
+	for (size_t k = 0; k < n; k++) {
+		uint32_t j = perm[k];
+		for (uint32_t p = rowOffsets[j]; p < rowOffsets[j + 1]; p++) {
+			uint32_t i = inversePerm[columns[p]];
+			if (i <= k) {
+				Ai.push_back(i);
+				source.push_back(p);
+			}
+		}
+		Ap[k + 1] = uint32_t(Ai.size());
+	}
+
+	// 2) Elimination tree and column counts of L
+	parent.assign(n, -1);
+	flag.assign(n, -1);
+	Lnz.assign(n, 0);
+	for (size_t k = 0; k < n; k++) {
+		flag[k] = int32_t(k);
+		for (uint32_t p = Ap[k]; p < Ap[k + 1]; p++) {
+			// Walk from i towards the root until reaching a node already visited for row k
+			for (uint32_t i = Ai[p]; i < k && flag[i] != int32_t(k); i = uint32_t(parent[i])) {
+				if (parent[i] == -1)
+					parent[i] = int32_t(k);
+				Lnz[i]++;
+				flag[i] = int32_t(k);
+			}
+		}
+	}
+
+	Lp.assign(n + 1, 0);
+	for (size_t k = 0; k < n; k++) {
+		Lp[k + 1] = Lp[k] + Lnz[k];
+	}
+	Li.resize(Lp[n]);
+	Lx.resize(Lp[n]);
+	D.resize(n);
+	Y.assign(n, 0.0);
+	pattern.resize(n);
+}
+
+bool SparseLDLT::factorize(const double *values) {
+	size_t n = size();
+	factorized = false;
+	std::fill(flag.begin(), flag.end(), -1);
+
+	for (size_t k = 0; k < n; k++) {
+		// 1) Scatter column k of the upper triangle and find the nonzero pattern of row k of L
+		Y[k] = 0.0;
+		size_t top = n;
+		flag[k] = int32_t(k);
+		Lnz[k] = 0;
+		for (uint32_t p = Ap[k]; p < Ap[k + 1]; p++) {
+			uint32_t i = Ai[p];
+			Y[i] += values[source[p]];
+
+			size_t length = 0;
+			for (; flag[i] != int32_t(k); i = uint32_t(parent[i])) {
+				pattern[length++] = i;
+				flag[i] = int32_t(k);
+			}
+			while (length > 0) {
+				pattern[--top] = pattern[--length];
+			}
+		}
+
+		// 2) Sparse triangular solve for row k of L, then the pivot D[k]
+		D[k] = Y[k];
+		Y[k] = 0.0;
+		for (; top < n; top++) {
+			uint32_t i = pattern[top];
+			double yi = Y[i];
+			Y[i] = 0.0;
+
+			uint32_t end = Lp[i] + Lnz[i];
+			for (uint32_t p = Lp[i]; p < end; p++) {
+				Y[Li[p]] -= Lx[p] * yi;
+			}
+			double lki = yi / D[i];
+			D[k] -= lki * yi;
+			Li[end] = uint32_t(k);
+			Lx[end] = lki;
+			Lnz[i]++;
+		}
+
+		if (D[k] == 0.0)
+			return false;
+	}
+
+	factorized = true;
+	return true;
+}
+
+void SparseLDLT::solve(double *x, double *work, size_t columns) const {
+	size_t n = size();
+	const size_t m = columns;
+	for (size_t k = 0; k < n; k++) {
+		for (size_t c = 0; c < m; c++) {
+			work[k * m + c] = x[perm[k] * m + c];
+		}
+	}
+
+	// L y = b, D z = y, L^T w = z
+	for (size_t j = 0; j < n; j++) {
+		const double *wj = work + j * m;
+		for (uint32_t p = Lp[j]; p < Lp[j + 1]; p++) {
+			double *wi = work + Li[p] * m;
+			for (size_t c = 0; c < m; c++) {
+				wi[c] -= Lx[p] * wj[c];
+			}
+		}
+	}
+	for (size_t j = 0; j < n; j++) {
+		for (size_t c = 0; c < m; c++) {
+			work[j * m + c] /= D[j];
+		}
+	}
+	for (size_t j = n; j-- > 0;) {
+		double *wj = work + j * m;
+		for (uint32_t p = Lp[j]; p < Lp[j + 1]; p++) {
+			const double *wi = work + Li[p] * m;
+			for (size_t c = 0; c < m; c++) {
+				wj[c] -= Lx[p] * wi[c];
+			}
+		}
+	}
+
+	for (size_t k = 0; k < n; k++) {
+		for (size_t c = 0; c < m; c++) {
+			x[perm[k] * m + c] = work[k * m + c];
+		}
+	}
+}
+
+void SparseLDLT::computeOrdering(size_t n, const uint32_t *rowOffsets, const uint32_t *columns) {
+	// perm is partitioned in place; every pending range holds one set still to be ordered
+	perm.resize(n);
+	for (size_t i = 0; i < n; i++) {
+		perm[i] = uint32_t(i);
+	}
+
+	std::vector<uint32_t> owner(n, 0), queue(n), scratch;
+	std::vector<int32_t> level(n, -1);
+	std::vector<std::pair<size_t, size_t>> pending;
+	if (n > 0)
+		pending.push_back({0, n});
+	uint32_t setId = 0;
+
+	// Breadth-first search restricted to the current set; returns the number of nodes reached
+	// and leaves the last one visited in last
+	auto search = [&](uint32_t start, uint32_t id, size_t lo, size_t hi, uint32_t &last) {
+		for (size_t k = lo; k < hi; k++) {
+			level[perm[k]] = -1;
+		}
+		size_t head = 0, tail = 0;
+		queue[tail++] = start;
+		level[start] = 0;
+		while (head < tail) {
+			uint32_t u = queue[head++];
+			for (uint32_t p = rowOffsets[u]; p < rowOffsets[u + 1]; p++) {
+				uint32_t v = columns[p];
+				if (owner[v] == id && level[v] < 0) {
+					level[v] = level[u] + 1;
+					queue[tail++] = v;
+				}
+			}
+		}
+		last = queue[tail - 1];
+		return tail;
+	};
+
+	while (!pending.empty()) {
+		auto [lo, hi] = pending.back();
+		pending.pop_back();
+		size_t count = hi - lo;
+		if (count <= dissectionLeafSize)
+			continue;
+
+		uint32_t id = ++setId;
+		for (size_t k = lo; k < hi; k++) {
+			owner[perm[k]] = id;
+		}
+
+		// 1) A pseudo-peripheral root: the last node reached from an arbitrary start
+		uint32_t root, last;
+		search(perm[lo], id, lo, hi, root);
+		size_t reached = search(root, id, lo, hi, last);
+		int32_t depth = level[last];
+
+		// 2) Disconnected sets are split into the reached component and the rest
+		auto byLevel = [&](auto predicate) {
+			return std::stable_partition(perm.begin() + lo, perm.begin() + hi, predicate) -
+			       perm.begin();
+		};
+		if (reached < count) {
+			size_t mid = byLevel([&](uint32_t v) { return level[v] >= 0; });
+			pending.push_back({lo, mid});
+			pending.push_back({mid, hi});
+			continue;
+		}
+		if (depth < 2)
+			continue;
+
+		// 3) Every edge joins equal or adjacent levels, so any single level separates the set.
+		// Take the one that splits the nodes most evenly.
+		scratch.assign(depth + 1, 0);
+		for (size_t k = lo; k < hi; k++) {
+			scratch[level[perm[k]]]++;
+		}
+		int32_t separator = 1;
+		size_t before = 0;
+		for (int32_t l = 0; l <= depth; l++) {
+			if (before + scratch[l] > count / 2) {
+				separator = std::clamp(l, 1, depth - 1);
+				break;
+			}
+			before += scratch[l];
+		}
+
+		size_t first = byLevel([&](uint32_t v) { return level[v] < separator; });
+		size_t second = std::stable_partition(perm.begin() + first, perm.begin() + hi,
+		                                      [&](uint32_t v) { return level[v] > separator; }) -
+		                perm.begin();
+		pending.push_back({lo, first});
+		pending.push_back({first, second});
+	}
+
+	inversePerm.resize(n);
+	for (size_t k = 0; k < n; k++) {
+		inversePerm[perm[k]] = uint32_t(k);
+	}
+}
@@ -0,0 +1,61 @@
+//
+// Created by Leonard Chan on 10/15/26.
+//
+
+#ifndef SPARSELDLT_H
+#define SPARSELDLT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Sparse LDL^T factorization of a symmetric positive definite matrix, split into a symbolic
+// phase (fill-reducing ordering, elimination tree and factor pattern) that only depends on the
+// sparsity and a numeric phase that can be repeated when the values change. The numeric
+// factorization and the solves follow the up-looking algorithm of T. Davis' LDL package.
+class SparseLDLT {
+  public:
+	// Symbolic analysis of an n x n matrix given as CSR with both triangles and the diagonal.
+	// The pattern is copied, so the arrays can be released afterwards.
+	void analyze(size_t n, const uint32_t *rowOffsets, const uint32_t *columns);
+
+	// Numeric factorization. values[j] belongs to columns[j] of the analyzed pattern. Returns
+	// false on a zero pivot, in which case solve() must not be called.
+	bool factorize(const double *values);
+
+	// Solves A X = B in place for columns right-hand sides stored row by row (x[i * columns + c]).
+	// Solving several columns together streams the factor once. work must hold as many entries
+	// as x; separate work arrays allow concurrent solves.
+	void solve(double *x, double *work, size_t columns = 1) const;
+
+	size_t size() const { return D.size(); }
+	size_t factorNonZeros() const { return Li.size(); }
+	bool isFactorized() const { return factorized; }
+
+  private:
+	// Nested dissection on the matrix graph: recursively split by the middle level of a
+	// breadth-first search, ordering both halves before the separator
+	void computeOrdering(size_t n, const uint32_t *rowOffsets, const uint32_t *columns);
+
+  private:
+	// perm[k] is the original row eliminated k-th, inversePerm is its inverse
+	std::vector<uint32_t> perm, inversePerm;
+
+	// Upper triangle of P A P^T in compressed columns; source maps an entry to the value index
+	// passed to factorize()
+	std::vector<uint32_t> Ap, Ai, source;
+
+	// Elimination tree and factor: column k of L spans [Lp[k], Lp[k + 1])
+	std::vector<int32_t> parent;
+	std::vector<uint32_t> Lp, Li;
+	std::vector<double> Lx, D;
+
+	// Numeric factorization scratch
+	std::vector<double> Y;
+	std::vector<int32_t> flag;
+	std::vector<uint32_t> Lnz, pattern;
+
+	bool factorized = false;
+};
+
+#endif // SPARSELDLT_H
@@ -0,0 +1,79 @@
+//
+// Created by Leonard Chan on 10/15/26.
+//
+
+#ifndef PARTICLESTATE_H
+#define PARTICLESTATE_H
+
+#include "Utilities/AlignedAllocator.h"
+
+#include <algorithm>
+#include <glm/glm.hpp>
+
+// Structure-of-arrays storage for a list of 3D vectors: one contiguous, aligned array per axis.
+struct Vec3Array {
+	AlignedVector<float> x, y, z;
+
+	size_t size() const { return x.size(); }
+
+	void resize(size_t n) {
+		x.resize(n, 0.0f);
+		y.resize(n, 0.0f);
+		z.resize(n, 0.0f);
+	}
+
+	void clear() {
+		x.clear();
+		y.clear();
+		z.clear();
+	}
+
+	void fill(const glm::vec3 &v) {
+		std::fill(x.begin(), x.end(), v.x);
+		std::fill(y.begin(), y.end(), v.y);
+		std::fill(z.begin(), z.end(), v.z);
+	}
+
+	// Raw pointer to one axis (0 = x, 1 = y, 2 = z), for per-component loops
+	float *component(int axis) { return axis == 0 ? x.data() : axis == 1 ? y.data() : z.data(); }
+	const float *component(int axis) const {
+		return axis == 0 ? x.data() : axis == 1 ? y.data() : z.data();
+	}
+
+	glm::vec3 get(size_t i) const { return glm::vec3(x[i], y[i], z[i]); }
+
+	void set(size_t i, const glm::vec3 &v) {
+		x[i] = v.x;
+		y[i] = v.y;
+		z[i] = v.z;
+	}
+
+	void add(size_t i, const glm::vec3 &v) {
+		x[i] += v.x;
+		y[i] += v.y;
+		z[i] += v.z;
+	}
+};
+
+// The simulated state of every particle in a cloth. Pinned particles carry an inverse mass of 0.
+struct ParticleState {
+	Vec3Array positions;
+	Vec3Array velocities;
+	AlignedVector<float> inverseMass;
+
+	size_t size() const { return positions.size(); }
+
+	void resize(size_t n) {
+		positions.resize(n);
+		velocities.resize(n);
+		inverseMass.resize(n, 0.0f);
+	}
+
+	void clear() {
+		positions.clear();
+		velocities.clear();
+		inverseMass.clear();
+	}
+};
+
+#endif // PARTICLESTATE_H
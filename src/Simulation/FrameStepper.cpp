@@ -0,0 +1,93 @@
+//
+// Created by Leonard Chan on 10/15/26.
+//
+
+#include "FrameStepper.h"
+
+#include "../Utilities/Timer.h"
+
+#include <algorithm>
+#include <cmath>
+
+// SLOW_MOTION never slows down further than this, and speeds back up by recoverRate per frame
+// once a frame's steps take less than half the budget
+static constexpr float minTimeScale = 0.01f;
+static constexpr float recoverRate = 1.1f;
+
+int FrameStepper::advance(Cloth &cloth,
+                          float wallSeconds,
+                          float dt,
+                          FunctionRef<bool()> stopAfterStep) {
+	accumulator += wallSeconds * stats.timeScale;
+
+	// 1) Step until the time, the budget or the substep cap runs out, or the caller stops us
+	Timer timer;
+	int steps = 0;
+	bool stopped = false;
+	while (accumulator >= dt && steps < settings.maxSubsteps) {
+		cloth.update(dt);
+		accumulator -= dt;
+		steps++;
+		if (stopAfterStep()) {
+			stopped = true;
+			break;
+		}
+		if (timer.elapsedMillis() >= settings.budgetMillis)
+			break;
+	}
+
+	stats.substeps = steps;
+	stats.stepMillis = timer.elapsedMillis();
+	stats.overrunMillis = std::max(0.0f, stats.stepMillis - settings.budgetMillis);
+
+	if (stopped) {
+		// Not an overrun: the time left over is simply never simulated
+		accumulator = std::fmod(accumulator, dt);
+		stats.backlogSeconds = 0.0f;
+		return steps;
+	}
+	stats.backlogSeconds = accumulator >= dt ? accumulator : 0.0f;
+
+	if (accumulator < dt) {
+		consecutiveOverruns = 0;
+		if (settings.policy == OverrunPolicy::SLOW_MOTION &&
+		    stats.stepMillis < 0.5f * settings.budgetMillis)
+			stats.timeScale = std::min(1.0f, stats.timeScale * recoverRate);
+		return steps;
+	}
+
+	// 2) Overrun: the policy decides how to catch up
+	stats.overrunFrames++;
+	consecutiveOverruns++;
+	switch (settings.policy) {
+	case OverrunPolicy::DROP_TIME:
+		break;
+	case OverrunPolicy::SLOW_MOTION: {
+		// Feed only the share of this frame's time that was actually simulated
+		float simulated = float(steps) * dt;
+		float scale = stats.timeScale * simulated / (simulated + accumulator);
+		stats.timeScale = std::clamp(scale, minTimeScale, 1.0f);
+		break;
+	}
+	case OverrunPolicy::DEGRADE:
+		if (consecutiveOverruns >= settings.degradeAfterFrames &&
+		    cloth.getIntegrationMethod() != settings.fallbackIntegrator) {
+			cloth.setIntegrator(settings.fallbackIntegrator);
+			stats.degradations++;
+			consecutiveOverruns = 0;
+		}
+		break;
+	}
+
+	// Whole steps that did not fit are dropped; the fraction of a step is kept
+	float dropped = accumulator - std::fmod(accumulator, dt);
+	stats.droppedSeconds += dropped;
+	accumulator -= dropped;
+	return steps;
+}
+
+void FrameStepper::reset() {
+	accumulator = 0.0f;
+	consecutiveOverruns = 0;
+	stats = SteppingStats{};
+}
@@ -0,0 +1,76 @@
+//
+// Created by Leonard Chan on 10/15/26.
+//
+
+#ifndef FRAMESTEPPER_H
+#define FRAMESTEPPER_H
+
+#include "../Cloth.h"
+#include "../Utilities/FunctionRef.h"
+
+#include <cstdint>
+
+// What to do when the steps of a frame cannot keep up with wall time
+enum class OverrunPolicy {
+	DROP_TIME,   // discard the sim time that did not fit; motion stutters but stays live
+	SLOW_MOTION, // feed wall time into the simulation at a lower rate until the steps fit
+	DEGRADE,     // switch to a cheaper integrator after repeated overruns, dropping time meanwhile
+};
+
+struct SteppingSettings {
+	float frameMillis = 1000.0f / 60.0f; // wall time between frames
+	float budgetMillis = 12.0f;          // wall time the steps of one frame may take
+	int maxSubsteps = 8;                 // steps per frame at most
+	OverrunPolicy policy = OverrunPolicy::DROP_TIME;
+
+	// DEGRADE: the integrator to fall back to and after how many consecutive overrun frames
+	Cloth::IntegrationMethod fallbackIntegrator = Cloth::IntegrationMethod::VERLET;
+	int degradeAfterFrames = 30;
+};
+
+struct SteppingStats {
+	int substeps = 0;            // steps taken in the last frame
+	float stepMillis = 0.0f;     // wall time of those steps
+	float overrunMillis = 0.0f;  // how far they exceeded the budget
+	float backlogSeconds = 0.0f; // sim time left over when the last frame stopped stepping
+	float droppedSeconds = 0.0f; // total sim time discarded
+	uint64_t overrunFrames = 0;  // frames that stopped with at least one step of time left over
+	float timeScale = 1.0f;      // sim seconds per wall second, below 1 only under SLOW_MOTION
+	int degradations = 0;        // integrator switches made by DEGRADE
+};
+
+// Turns elapsed wall time into fixed dt steps, like a classic accumulator loop, but bounds the
+// work of every frame by a wall-clock budget and a substep cap. Without the bounds, a step that
+// costs more than its dt makes the accumulator grow faster than it is drained and the frame
+// time diverges. Whatever does not fit is handled by the overrun policy; no policy carries a
+// backlog into the next frame, so frame latency stays bounded by the budget plus one step.
+class FrameStepper {
+  public:
+	void setSettings(const SteppingSettings &settings) { this->settings = settings; }
+	const SteppingSettings &getSettings() const { return settings; }
+	const SteppingStats &getStats() const { return stats; }
+
+	// Adds wallSeconds of real time and steps the cloth by dt while time, budget and substep cap
+	// allow. At least one step is taken whenever a full dt has accumulated. Returns the number
+	// of steps.
+	int advance(Cloth &cloth, float wallSeconds, float dt) {
+		return advance(cloth, wallSeconds, dt, []() { return false; });
+	}
+
+	// Same, but asks stopAfterStep after every step and ends the frame as soon as it returns
+	// true, e.g. to halt at the step that went unstable. The whole steps still owed are
+	// dropped, since the caller is about to halt.
+	int advance(Cloth &cloth, float wallSeconds, float dt, FunctionRef<bool()> stopAfterStep);
+
+	// Forgets the accumulated time and the statistics
+	void reset();
+
+  private:
+	SteppingSettings settings;
+	SteppingStats stats;
+
+	float accumulator = 0.0f;
+	int consecutiveOverruns = 0;
+};
+
+#endif // FRAMESTEPPER_H
@@ -0,0 +1,256 @@
+//
+// Created by Leonard Chan on 10/15/26.
+//
+
+#include "SimulationThread.h"
+
+#include "../Integrators/DormandPrinceIntegrator.h"
+#include "../Integrators/ProjectiveDynamicsIntegrator.h"
+#include "../Utilities/Timer.h"
+
+#include <chrono>
+#include <iostream>
+
+// How long an idle (paused or dt = 0) thread sleeps before re-checking its state
+static constexpr std::chrono::milliseconds idleWait(50);
+
+SimulationThread::SimulationThread() { thread = std::thread([this]() { run(); }); }
+
+SimulationThread::~SimulationThread() {
+	{
+		std::lock_guard<std::mutex> lock(commandMutex);
+		stopping.store(true);
+	}
+	wakeUp.notify_one();
+	thread.join();
+}
+
+void SimulationThread::enqueue(Command command) {
+	{
+		std::lock_guard<std::mutex> lock(commandMutex);
+		pendingCommands.push_back(std::move(command));
+	}
+	wakeUp.notify_one();
+}
+
+void SimulationThread::resetTime() {
+	enqueue([this](Cloth &) {
+		simTime = 0.0f;
+		steps = 0;
+		stepper.reset();
+	});
+}
+
+void SimulationThread::setSteppingSettings(const SteppingSettings &settings) {
+	enqueue([this, settings](Cloth &) { stepper.setSettings(settings); });
+}
+
+void SimulationThread::setPaused(bool paused) {
+	{
+		std::lock_guard<std::mutex> lock(commandMutex);
+		this->paused.store(paused);
+	}
+	wakeUp.notify_one();
+}
+
+bool SimulationThread::applyCommands() {
+	{
+		std::lock_guard<std::mutex> lock(commandMutex);
+		runningCommands.swap(pendingCommands);
+	}
+	for (Command &command : runningCommands) {
+		command(cloth);
+	}
+	bool applied = !runningCommands.empty();
+	runningCommands.clear();
+	return applied;
+}
+
+void SimulationThread::run() {
+	using Clock = std::chrono::steady_clock;
+	Clock::time_point lastFrame = Clock::now(), nextFrame = lastFrame;
+
+	while (!stopping.load()) {
+		if (applyCommands())
+			publish();
+
+		// 1) Idle until something changes. Resuming only ends the wait when there is a time step
+		// to resume with; at dt = 0 the thread would otherwise spin while unpaused.
+		float dt = timeStep.load(std::memory_order_relaxed);
+		if (paused.load() || dt <= 0.0f) {
+			const bool waitForResume = dt > 0.0f;
+			std::unique_lock<std::mutex> lock(commandMutex);
+			wakeUp.wait_for(lock, idleWait, [&]() {
+				return stopping.load() || !pendingCommands.empty() ||
+				       (waitForResume && !paused.load());
+			});
+			lastFrame = nextFrame = Clock::now();
+			continue;
+		}
+
+		// 2) Wait for the next frame; new commands cut the wait short
+		Clock::time_point now = Clock::now();
+		if (now < nextFrame) {
+			std::unique_lock<std::mutex> lock(commandMutex);
+			wakeUp.wait_until(lock, nextFrame,
+			                  [&]() { return stopping.load() || !pendingCommands.empty(); });
+			continue;
+		}
+
+		// 3) Step through the wall time since the last frame, within the frame budget
+		float wallSeconds = std::chrono::duration<float>(now - lastFrame).count();
+		lastFrame = now;
+		nextFrame = now + std::chrono::duration_cast<Clock::duration>(
+		                      std::chrono::duration<float, std::milli>(
+		                          stepper.getSettings().frameMillis));
+
+		// Instability is checked after every step, since the next step overwrites its report
+		bool unstable = false;
+		int frameSteps = stepper.advance(cloth, wallSeconds, dt, [&]() {
+			unstable = pauseOnInstability.load() && cloth.isUnstable();
+			return unstable;
+		});
+		if (frameSteps == 0)
+			continue;
+
+		const SteppingStats &stats = stepper.getStats();
+		lastStepMillis = stats.stepMillis / float(frameSteps);
+		simTime += float(frameSteps) * dt;
+		steps += frameSteps;
+
+		if (unstable) {
+			// Log when and where instability occurred
+			const Cloth::StabilityReport &stability = cloth.getStabilityReport();
+			std::cout << "Instability detected at simulation time: " << simTime << "s (strain "
+			          << stability.maxStrain << " at spring " << stability.worstSpring
+			          << ", speed ratio " << stability.maxSpeedRatio << " at particle "
+			          << stability.worstParticle << ")" << std::endl;
+			paused.store(true);
+		}
+
+		publish();
+		record();
+	}
+}
+
+void SimulationThread::publish() {
+	ClothSnapshot &snapshot = snapshots.writeBuffer();
+
+	// Buffers keep their capacity, so this only allocates when the cloth grows
+	snapshot.positions = cloth.getParticles().positions;
+	snapshot.simTime = simTime;
+	snapshot.lastStepMillis = lastStepMillis;
+	snapshot.steps = steps;
+	snapshot.forceKernelName = cloth.getForceKernelName();
+	snapshot.integrator = cloth.getIntegrationMethod();
+	snapshot.selfContacts = cloth.getSelfContactCount();
+	snapshot.colliderContacts = cloth.getColliderContactCount();
+	snapshot.continuousImpacts = cloth.getContinuousImpactCount();
+	snapshot.deterministic = cloth.isDeterministic();
+	snapshot.stateHash = snapshot.deterministic ? cloth.computeStateHash() : 0;
+	snapshot.stepping = stepper.getStats();
+
+	// Mirror the mesh; the simulation thread is its only writer, so it reads it without the lock
+	const std::vector<Cloth::TrianglePatch> &patches = cloth.getTrianglePatches();
+	if (meshVersion != cloth.getMeshVersion() || meshTriangles.empty()) {
+		std::lock_guard<std::mutex> lock(meshMutex);
+		meshVersion = cloth.getMeshVersion();
+		meshPatchBase = patches.size();
+		meshTriangles = cloth.getTriangles();
+		meshPatches.clear();
+	} else if (meshPatchBase + meshPatches.size() != patches.size()) {
+		std::lock_guard<std::mutex> lock(meshMutex);
+		meshPatches.insert(meshPatches.end(), patches.begin() + meshPatchBase + meshPatches.size(),
+		                   patches.end());
+	}
+	snapshot.meshVersion = meshVersion;
+	snapshot.trianglePatchCount = meshPatches.size();
+	snapshot.tornSprings = cloth.getTornSpringCount();
+	snapshot.splitParticles = cloth.getSplitParticleCount();
+
+	snapshot.recording = recorder.isOpen();
+	snapshot.recordedFrames = recorder.getFrameCount();
+	snapshot.recordedBytes = recorder.getBytesWritten();
+	snapshot.recordedRawBytes = recorder.getRawBytes();
+	snapshot.recordingStallMillis = recorder.getStallMillis();
+
+	auto *pd = dynamic_cast<const ProjectiveDynamicsIntegrator *>(cloth.getIntegrator());
+	snapshot.hasSolverStats = pd != nullptr;
+	if (pd) {
+		snapshot.factorizationMillis = pd->getFactorizationMillis();
+		snapshot.iterationMillis = pd->getIterationMillis();
+		snapshot.factorNonZeros = pd->getFactorNonZeros();
+	}
+
+	auto *adaptive = dynamic_cast<const DormandPrinceIntegrator *>(cloth.getIntegrator());
+	snapshot.hasAdaptiveStats = adaptive != nullptr;
+	if (adaptive) {
+		snapshot.substeps = adaptive->getSubsteps();
+		snapshot.rejectedSteps = adaptive->getRejectedSteps();
+		snapshot.adaptiveStepSize = adaptive->getStepSize();
+	}
+
+	snapshots.publish();
+}
+
+void SimulationThread::startRecording(const std::string &path, const FrameCacheOptions &options) {
+	enqueue([this, path, options](Cloth &) {
+		if (recorder.isOpen() && !recorder.close())
+			std::cerr << "Frame cache: " << recorder.getError() << std::endl;
+		if (!recorder.open(path, options)) {
+			std::cerr << "Frame cache: " << recorder.getError() << std::endl;
+			return;
+		}
+		recordMesh = true;
+		std::cout << "Recording to " << path << std::endl;
+	});
+}
+
+void SimulationThread::stopRecording() {
+	enqueue([this](Cloth &) {
+		if (!recorder.isOpen())
+			return;
+		uint64_t frames = recorder.getFrameCount();
+		if (recorder.close())
+			std::cout << "Recorded " << frames << " frames" << std::endl;
+		else
+			std::cerr << "Frame cache: " << recorder.getError() << std::endl;
+	});
+}
+
+void SimulationThread::record() {
+	if (!recorder.isOpen())
+		return;
+
+	// The whole mesh on the first frame and whenever it is replaced, its patches otherwise
+	const std::vector<Cloth::TrianglePatch> &patches = cloth.getTrianglePatches();
+	const std::vector<uint32_t> *triangles = nullptr;
+	if (recordMesh || recordedMeshVersion != cloth.getMeshVersion()) {
+		triangles = &cloth.getTriangles();
+		recordedMeshVersion = cloth.getMeshVersion();
+		recordedPatchCount = patches.size();
+		recordMesh = false;
+	}
+	recorder.addFrame(simTime, cloth.getParticles().positions, triangles,
+	                  patches.data() + recordedPatchCount, patches.size() - recordedPatchCount);
+	recordedPatchCount = patches.size();
+}
+
+bool SimulationThread::copyTriangles(uint64_t meshVersion, std::vector<uint32_t> &out) {
+	std::lock_guard<std::mutex> lock(meshMutex);
+	if (meshVersion != this->meshVersion)
+		return false;
+	out = meshTriangles;
+	return true;
+}
+
+bool SimulationThread::copyTrianglePatches(uint64_t meshVersion,
+                                           size_t begin,
+                                           size_t end,
+                                           std::vector<Cloth::TrianglePatch> &out) {
+	std::lock_guard<std::mutex> lock(meshMutex);
+	if (meshVersion != this->meshVersion || end > meshPatches.size())
+		return false;
+	out.assign(meshPatches.begin() + begin, meshPatches.begin() + end);
+	return true;
+}
@@ -0,0 +1,169 @@
+//
+// Created by Leonard Chan on 10/15/26.
+//
+
+#ifndef SIMULATIONTHREAD_H
+#define SIMULATIONTHREAD_H
+
+#include "../Cloth.h"
+#include "../IO/FrameCache.h"
+#include "../Utilities/TripleBuffer.h"
+#include "FrameStepper.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// What the simulation thread publishes after every step
+struct ClothSnapshot {
+	Vec3Array positions;
+
+	float simTime = 0.0f;
+	float lastStepMillis = 0.0f;
+	uint64_t steps = 0;
+	const char *forceKernelName = "";
+	Cloth::IntegrationMethod integrator = Cloth::IntegrationMethod::EXPLICIT_EULER;
+	size_t selfContacts = 0;
+	size_t colliderContacts = 0;
+	size_t continuousImpacts = 0;
+
+	// Hash of the cloth state (see Cloth::computeStateHash()), only set in deterministic mode
+	bool deterministic = false;
+	uint64_t stateHash = 0;
+
+	// The mesh the positions belong to and how many of its triangle patches they include (see
+	// SimulationThread::copyTriangles()), and the springs torn and particles split by the last
+	// step
+	uint64_t meshVersion = 0;
+	size_t trianglePatchCount = 0;
+	size_t tornSprings = 0;
+	size_t splitParticles = 0;
+
+	// Frame cache statistics while recording (see SimulationThread::startRecording())
+	bool recording = false;
+	uint64_t recordedFrames = 0;
+	uint64_t recordedBytes = 0;
+	uint64_t recordedRawBytes = 0;
+	float recordingStallMillis = 0.0f;
+
+	// Frame budget statistics of the last frame
+	SteppingStats stepping;
+
+	// Projective dynamics statistics, only set while that integrator is active
+	bool hasSolverStats = false;
+	float factorizationMillis = 0.0f;
+	float iterationMillis = 0.0f;
+	size_t factorNonZeros = 0;
+
+	// Adaptive integrator statistics of the last step, only set while that integrator is active
+	bool hasAdaptiveStats = false;
+	int substeps = 0;
+	int rejectedSteps = 0;
+	float adaptiveStepSize = 0.0f;
+};
+
+// Owns a Cloth and steps it on a dedicated thread at a fixed rate of one step per time step of
+// wall time, independent of the display refresh. The steps are grouped into frames whose work is
+// bounded by a FrameStepper. Other threads never touch the cloth: changes go through a command
+// queue that is drained before each frame, and the state after each frame comes back as a
+// ClothSnapshot through a lock-free triple buffer.
+class SimulationThread {
+  public:
+	using Command = std::function<void(Cloth &cloth)>;
+
+	SimulationThread();
+	~SimulationThread();
+
+	SimulationThread(const SimulationThread &) = delete;
+	SimulationThread &operator=(const SimulationThread &) = delete;
+
+	// Runs command on the simulation thread before the next frame. Commands run in order.
+	void enqueue(Command command);
+
+	// Queues a call of a Cloth setter, e.g. set(&Cloth::setMass, 2.0f)
+	template <typename T, typename U>
+	void set(void (Cloth::*setter)(T), U value) {
+		enqueue([setter, v = T(value)](Cloth &cloth) { (cloth.*setter)(v); });
+	}
+
+	// Queues a reset of the simulated time, step count and frame statistics, e.g. after
+	// rebuilding the cloth
+	void resetTime();
+
+	// Queues new frame budget settings
+	void setSteppingSettings(const SteppingSettings &settings);
+
+	void setTimeStep(float dt) { timeStep.store(dt, std::memory_order_relaxed); }
+	void setPaused(bool paused);
+	bool isPaused() const { return paused.load(std::memory_order_relaxed); }
+	void setPauseOnInstability(bool enabled) { pauseOnInstability.store(enabled); }
+
+	// Takes the most recently published snapshot, if any; returns true if it changed
+	bool acquireSnapshot() { return snapshots.acquire(); }
+	const ClothSnapshot &getSnapshot() const { return snapshots.readBuffer(); }
+
+	// Queue the start and the end of a recording: from the next frame on, the positions after
+	// every frame are streamed to a frame cache at path (see FrameCacheWriter), together with the
+	// triangles and their patches. Starting a recording ends the one before. Failures are
+	// written to std::cerr.
+	void startRecording(const std::string &path, const FrameCacheOptions &options = {});
+	void stopRecording();
+
+	// Copies the triangles of the given mesh as first published, and patches [begin, end) of it
+	// since, so that the reader can keep its own copy up to date with the snapshots. Both return
+	// false if the mesh has been replaced since.
+	bool copyTriangles(uint64_t meshVersion, std::vector<uint32_t> &out);
+	bool copyTrianglePatches(uint64_t meshVersion,
+	                         size_t begin,
+	                         size_t end,
+	                         std::vector<Cloth::TrianglePatch> &out);
+
+  private:
+	void run();
+	bool applyCommands();
+	void publish();
+	void record();
+
+  private:
+	Cloth cloth;
+	std::thread thread;
+
+	std::mutex commandMutex;
+	std::condition_variable wakeUp;
+	std::vector<Command> pendingCommands; // guarded by commandMutex
+	std::vector<Command> runningCommands; // simulation thread only
+
+	std::atomic<bool> stopping{false};
+	std::atomic<bool> paused{false};
+	std::atomic<bool> pauseOnInstability{false};
+	std::atomic<float> timeStep{0.016f};
+
+	// Simulation thread only
+	FrameStepper stepper;
+	float simTime = 0.0f;
+	float lastStepMillis = 0.0f;
+	uint64_t steps = 0;
+
+	TripleBuffer<ClothSnapshot> snapshots;
+
+	// Simulation thread only: the recording, and the mesh and patches it has been sent
+	FrameCacheWriter recorder;
+	uint64_t recordedMeshVersion = 0;
+	size_t recordedPatchCount = 0;
+	bool recordMesh = false;
+
+	// The triangles of the current mesh when it was first published, and every patch of them
+	// since, mirrored by publish(). Snapshots can be dropped, so these are kept here rather than
+	// in them. Written by the simulation thread only, under meshMutex.
+	std::mutex meshMutex;
+	uint64_t meshVersion = 0;
+	size_t meshPatchBase = 0; // patches the cloth had made when the mesh was mirrored
+	std::vector<uint32_t> meshTriangles;
+	std::vector<Cloth::TrianglePatch> meshPatches;
+};
+
+#endif // SIMULATIONTHREAD_H
@@ -0,0 +1,32 @@
+//
+// Created by Leonard Chan on 10/15/26.
+//
+
+#ifndef TASK_H
+#define TASK_H
+
+#include <atomic>
+#include <cstddef>
+
+// Counts the tasks of one batch that have been spawned but not yet finished
+class TaskCounter {
+  public:
+	bool isDone() const { return pending.load(std::memory_order_acquire) == 0; }
+
+  private:
+	friend class TaskScheduler;
+	std::atomic<size_t> pending{0};
+};
+
+// A unit of work: a plain function pointer applied to a range. Tasks are trivially copyable, so
+// queues can store them by value without allocating.
+struct Task {
+	using Function = void (*)(void *context, size_t begin, size_t end);
+
+	Function function = nullptr;
+	void *context = nullptr;
+	size_t begin = 0, end = 0;
+	TaskCounter *counter = nullptr;
+};
+
+#endif // TASK_H
@@ -0,0 +1,17 @@
+//
+// Created by Leonard Chan on 10/15/26.
+//
+
+#include "TaskGraph.h"
+
+TaskGraph::NodeId TaskGraph::addTask(std::function<void()> work) {
+	Node node;
+	node.work = std::move(work);
+	nodes.push_back(std::move(node));
+	return static_cast<NodeId>(nodes.size() - 1);
+}
+
+void TaskGraph::addDependency(NodeId before, NodeId after) {
+	nodes[before].successors.push_back(after);
+	nodes[after].predecessorCount++;
+}
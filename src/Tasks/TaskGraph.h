@@ -0,0 +1,43 @@
+//
+// Created by Leonard Chan on 10/15/26.
+//
+
+#ifndef TASKGRAPH_H
+#define TASKGRAPH_H
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// A reusable DAG of tasks. Build it once, then hand it to TaskScheduler::run() as often as needed:
+// every node runs after all of its predecessors, and independent nodes run concurrently.
+class TaskGraph {
+  public:
+	using NodeId = uint32_t;
+
+	NodeId addTask(std::function<void()> work);
+
+	// 'after' will not start until 'before' has finished
+	void addDependency(NodeId before, NodeId after);
+
+	size_t size() const { return nodes.size(); }
+	bool empty() const { return nodes.empty(); }
+
+  private:
+	friend class TaskScheduler;
+
+	struct Node {
+		std::function<void()> work;
+		std::vector<NodeId> successors;
+		uint32_t predecessorCount = 0;
+	};
+
+	std::vector<Node> nodes;
+
+	// Predecessors still outstanding for each node during a run
+	std::unique_ptr<std::atomic<uint32_t>[]> pending;
+	size_t pendingCapacity = 0;
+};
+
+#endif // TASKGRAPH_H
@@ -0,0 +1,216 @@
+//
+// Created by Leonard Chan on 10/15/26.
+//
+
+#include "TaskScheduler.h"
+
+#include <algorithm>
+
+// Identifies the worker running on the current thread, if any
+static thread_local const TaskScheduler *currentScheduler = nullptr;
+static thread_local unsigned currentWorker = 0;
+
+TaskScheduler::TaskScheduler(unsigned workerCount) {
+	for (unsigned i = 0; i <= workerCount; i++) {
+		queues.push_back(std::make_unique<WorkStealingQueue>());
+	}
+
+	workers.reserve(workerCount);
+	for (unsigned i = 0; i < workerCount; i++) {
+		workers.emplace_back([this, i]() { workerLoop(i); });
+	}
+}
+
+TaskScheduler::~TaskScheduler() {
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		stopping = true;
+	}
+	sleepCondition.notify_all();
+	for (auto &worker : workers) {
+		worker.join();
+	}
+}
+
+static std::unique_ptr<TaskScheduler> &globalScheduler() {
+	static std::unique_ptr<TaskScheduler> scheduler =
+	    std::make_unique<TaskScheduler>(std::max(1u, std::thread::hardware_concurrency()) - 1);
+	return scheduler;
+}
+
+TaskScheduler &TaskScheduler::get() {
+	return *globalScheduler();
+}
+
+void TaskScheduler::setThreadCount(unsigned threadCount) {
+	std::unique_ptr<TaskScheduler> &scheduler = globalScheduler();
+	scheduler.reset();
+	scheduler = std::make_unique<TaskScheduler>(std::max(1u, threadCount) - 1);
+}
+
+void TaskScheduler::spawn(Task::Function function,
+                          void *context,
+                          size_t begin,
+                          size_t end,
+                          TaskCounter &counter) {
+	counter.pending.fetch_add(1, std::memory_order_relaxed);
+	push(Task{function, context, begin, end, &counter});
+}
+
+void TaskScheduler::wait(TaskCounter &counter) {
+	while (!counter.isDone()) {
+		if (!tryRunOne())
+			std::this_thread::yield();
+	}
+}
+
+namespace {
+struct ParallelForContext {
+	TaskScheduler *scheduler;
+	const TaskScheduler::RangeBody *body;
+	size_t grainSize;
+	TaskCounter *counter;
+};
+
+// Keeps splitting off the upper half of the range as a new task until a single grain is left
+void runParallelForRange(void *context, size_t begin, size_t end) {
+	auto &loop = *static_cast<ParallelForContext *>(context);
+	while (end - begin > loop.grainSize) {
+		size_t middle = begin + (end - begin) / 2;
+		loop.scheduler->spawn(runParallelForRange, context, middle, end, *loop.counter);
+		end = middle;
+	}
+	(*loop.body)(begin, end);
+}
+
+} // namespace
+
+struct TaskScheduler::GraphRunContext {
+	TaskScheduler *scheduler;
+	TaskGraph *graph;
+	TaskCounter *counter;
+};
+
+// Runs one graph node, then releases every successor whose last dependency it was
+void TaskScheduler::runGraphNode(void *context, size_t node, size_t) {
+	auto &run = *static_cast<GraphRunContext *>(context);
+	auto &graphNode = run.graph->nodes[node];
+	graphNode.work();
+	for (TaskGraph::NodeId successor : graphNode.successors) {
+		if (run.graph->pending[successor].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+			run.scheduler->spawn(runGraphNode, context, successor, 0, *run.counter);
+		}
+	}
+}
+
+void TaskScheduler::parallelFor(size_t begin, size_t end, size_t grainSize, RangeBody body) {
+	if (end <= begin)
+		return;
+
+	grainSize = std::max<size_t>(grainSize, 1);
+	if (end - begin <= grainSize || workers.empty()) {
+		body(begin, end);
+		return;
+	}
+
+	TaskCounter counter;
+	ParallelForContext context{this, &body, grainSize, &counter};
+	runParallelForRange(&context, begin, end);
+	wait(counter);
+}
+
+void TaskScheduler::parallelForChunks(
+    size_t begin,
+    size_t end,
+    size_t chunkSize,
+    FunctionRef<void(size_t chunk, size_t begin, size_t end)> body) {
+	chunkSize = std::max<size_t>(chunkSize, 1);
+	parallelFor(0, chunkCount(begin, end, chunkSize), 1, [&](size_t first, size_t last) {
+		for (size_t chunk = first; chunk < last; chunk++) {
+			size_t chunkBegin = begin + chunk * chunkSize;
+			body(chunk, chunkBegin, std::min(chunkBegin + chunkSize, end));
+		}
+	});
+}
+
+void TaskScheduler::run(TaskGraph &graph) {
+	size_t nodeCount = graph.nodes.size();
+	if (nodeCount == 0)
+		return;
+
+	if (graph.pendingCapacity < nodeCount) {
+		graph.pending = std::make_unique<std::atomic<uint32_t>[]>(nodeCount);
+		graph.pendingCapacity = nodeCount;
+	}
+	for (size_t i = 0; i < nodeCount; i++) {
+		graph.pending[i].store(graph.nodes[i].predecessorCount, std::memory_order_relaxed);
+	}
+
+	TaskCounter counter;
+	GraphRunContext context{this, &graph, &counter};
+
+	for (size_t i = 0; i < nodeCount; i++) {
+		if (graph.nodes[i].predecessorCount == 0)
+			spawn(runGraphNode, &context, i, 0, counter);
+	}
+	wait(counter);
+}
+
+void TaskScheduler::workerLoop(unsigned index) {
+	currentScheduler = this;
+	currentWorker = index;
+
+	while (!stopping.load(std::memory_order_acquire)) {
+		if (tryRunOne())
+			continue;
+
+		// Spin briefly before going to sleep; simulation steps submit work in quick bursts
+		bool found = false;
+		for (int spin = 0; spin < 64 && !found; spin++) {
+			std::this_thread::yield();
+			found = queuedTasks.load() > 0;
+		}
+		if (found)
+			continue;
+
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		sleepingWorkers++;
+		sleepCondition.wait(lock, [this]() { return stopping.load() || queuedTasks.load() > 0; });
+		sleepingWorkers--;
+	}
+}
+
+size_t TaskScheduler::localQueueIndex() const {
+	return currentScheduler == this ? currentWorker : workers.size();
+}
+
+void TaskScheduler::push(const Task &task) {
+	queues[localQueueIndex()]->push(task);
+	queuedTasks.fetch_add(1);
+	if (sleepingWorkers.load() > 0) {
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		sleepCondition.notify_one();
+	}
+}
+
+bool TaskScheduler::tryRunOne() {
+	Task task;
+	size_t self = localQueueIndex();
+	bool found = queues[self]->pop(task);
+
+	// Steal round-robin, starting with the neighbour, so thieves spread over the victims
+	for (size_t i = 1; !found && i < queues.size(); i++) {
+		found = queues[(self + i) % queues.size()]->steal(task);
+	}
+	if (!found)
+		return false;
+
+	queuedTasks.fetch_sub(1);
+	execute(task);
+	return true;
+}
+
+void TaskScheduler::execute(const Task &task) {
+	task.function(task.context, task.begin, task.end);
+	task.counter->pending.fetch_sub(1, std::memory_order_acq_rel);
+}
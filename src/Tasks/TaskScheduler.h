@@ -0,0 +1,100 @@
+//
+// Created by Leonard Chan on 10/15/26.
+//
+
+#ifndef TASKSCHEDULER_H
+#define TASKSCHEDULER_H
+
+#include "../Utilities/FunctionRef.h"
+#include "Task.h"
+#include "TaskGraph.h"
+#include "WorkStealingQueue.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing job system shared by the whole simulation. Each worker owns a deque of tasks;
+// threads that run out of work steal from the others. Threads outside the pool submit through a
+// shared injection queue. Any thread that waits on a task batch executes tasks while it waits, so
+// nested parallel loops never deadlock and never oversubscribe the machine.
+class TaskScheduler {
+  public:
+	// Body of a parallel loop, called with a half-open chunk [begin, end)
+	using RangeBody = FunctionRef<void(size_t begin, size_t end)>;
+
+	explicit TaskScheduler(unsigned workerCount);
+	~TaskScheduler();
+
+	TaskScheduler(const TaskScheduler &) = delete;
+	TaskScheduler &operator=(const TaskScheduler &) = delete;
+
+	// Process-wide scheduler with one worker per hardware thread (minus the caller)
+	static TaskScheduler &get();
+
+	// Replaces the process-wide scheduler with one that runs on threadCount threads, including
+	// the caller. No work may be in flight, and references from get() become invalid.
+	static void setThreadCount(unsigned threadCount);
+
+	// Number of threads that execute work, including the caller
+	unsigned getThreadCount() const { return static_cast<unsigned>(workers.size()) + 1; }
+
+	// Queues function(context, begin, end) as part of the batch tracked by counter
+	void spawn(Task::Function function,
+	           void *context,
+	           size_t begin,
+	           size_t end,
+	           TaskCounter &counter);
+
+	// Blocks until every task of the batch has finished, running queued tasks meanwhile
+	void wait(TaskCounter &counter);
+
+	// Runs body over [begin, end) in chunks of at most grainSize. The range is split recursively,
+	// so idle workers steal large halves first. Returns once every chunk has finished.
+	void parallelFor(size_t begin, size_t end, size_t grainSize, RangeBody body);
+
+	// Like parallelFor, but the chunks are fixed: chunk c covers
+	// [begin + c * chunkSize, min(begin + (c + 1) * chunkSize, end)) whatever the thread count.
+	// Reductions store one partial result per chunk and combine them in chunk order.
+	void parallelForChunks(size_t begin,
+	                       size_t end,
+	                       size_t chunkSize,
+	                       FunctionRef<void(size_t chunk, size_t begin, size_t end)> body);
+
+	static size_t chunkCount(size_t begin, size_t end, size_t chunkSize) {
+		return end > begin ? (end - begin + chunkSize - 1) / chunkSize : 0;
+	}
+
+	// Runs every node of the graph respecting its dependencies, and waits for all of them
+	void run(TaskGraph &graph);
+
+  private:
+	struct GraphRunContext;
+	static void runGraphNode(void *context, size_t node, size_t);
+
+	void workerLoop(unsigned index);
+
+	void push(const Task &task);
+	bool tryRunOne();
+	void execute(const Task &task);
+
+	// Queue the calling thread pushes to: its own deque for workers, the injection queue otherwise
+	size_t localQueueIndex() const;
+
+  private:
+	std::vector<std::thread> workers;
+
+	// One deque per worker, followed by the shared injection queue
+	std::vector<std::unique_ptr<WorkStealingQueue>> queues;
+
+	std::atomic<size_t> queuedTasks{0};
+	std::atomic<unsigned> sleepingWorkers{0};
+	std::atomic<bool> stopping{false};
+	std::mutex sleepMutex;
+	std::condition_variable sleepCondition;
+};
+
+#endif // TASKSCHEDULER_H
@@ -0,0 +1,62 @@
+//
+// Created by Leonard Chan on 10/15/26.
+//
+
+#ifndef WORKSTEALINGQUEUE_H
+#define WORKSTEALINGQUEUE_H
+
+#include "Task.h"
+
+#include <mutex>
+#include <vector>
+
+// Double-ended task queue owned by one worker. The owner pushes and pops at the bottom (LIFO, so
+// it keeps working on the freshest, cache-hot tasks); idle workers steal from the top (FIFO, so
+// they take the oldest and usually largest pieces of work). The ring buffer only grows, so once
+// warmed up it never allocates.
+class WorkStealingQueue {
+  public:
+	WorkStealingQueue() : ring(256) {}
+
+	void push(const Task &task) {
+		std::lock_guard<std::mutex> lock(mutex);
+		if (bottom - top == ring.size())
+			grow();
+		ring[bottom & (ring.size() - 1)] = task;
+		bottom++;
+	}
+
+	bool pop(Task &task) {
+		std::lock_guard<std::mutex> lock(mutex);
+		if (bottom == top)
+			return false;
+		bottom--;
+		task = ring[bottom & (ring.size() - 1)];
+		return true;
+	}
+
+	bool steal(Task &task) {
+		std::lock_guard<std::mutex> lock(mutex);
+		if (bottom == top)
+			return false;
+		task = ring[top & (ring.size() - 1)];
+		top++;
+		return true;
+	}
+
+  private:
+	void grow() {
+		std::vector<Task> larger(ring.size() * 2);
+		for (size_t i = top; i != bottom; i++) {
+			larger[i & (larger.size() - 1)] = ring[i & (ring.size() - 1)];
+		}
+		ring.swap(larger);
+	}
+
+  private:
+	std::mutex mutex;
+	std::vector<Task> ring; // capacity is always a power of two
+	size_t top = 0, bottom = 0;
+};
+
+#endif // WORKSTEALINGQUEUE_H
@@ -0,0 +1,44 @@
+//
+// Created by Leonard Chan on 10/15/26.
+//
+
+#ifndef ALIGNEDALLOCATOR_H
+#define ALIGNEDALLOCATOR_H
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+// Allocator that hands out storage aligned to a cache line, so SoA arrays start on a boundary
+// that SIMD loads and per-thread chunks can rely on.
+template <typename T, std::size_t Alignment = 64> class AlignedAllocator {
+  public:
+	using value_type = T;
+
+	template <typename U> struct rebind {
+		using other = AlignedAllocator<U, Alignment>;
+	};
+
+	AlignedAllocator() noexcept = default;
+
+	template <typename U> AlignedAllocator(const AlignedAllocator<U, Alignment> &) noexcept {}
+
+	T *allocate(std::size_t n) {
+		return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+	}
+
+	void deallocate(T *p, std::size_t) noexcept {
+		::operator delete(p, std::align_val_t(Alignment));
+	}
+
+	template <typename U> bool operator==(const AlignedAllocator<U, Alignment> &) const noexcept {
+		return true;
+	}
+	template <typename U> bool operator!=(const AlignedAllocator<U, Alignment> &) const noexcept {
+		return false;
+	}
+};
+
+template <typename T> using AlignedVector = std::vector<T, AlignedAllocator<T>>;
+
+#endif // ALIGNEDALLOCATOR_H
@@ -0,0 +1,34 @@
+//
+// Created by Leonard Chan on 10/15/26.
+//
+
+#ifndef FUNCTIONREF_H
+#define FUNCTIONREF_H
+
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+// Non-owning reference to a callable. Unlike std::function it never allocates, so it is cheap to
+// pass through hot loops. The referenced callable must outlive the FunctionRef.
+template <typename Signature> class FunctionRef;
+
+template <typename R, typename... Args> class FunctionRef<R(Args...)> {
+  public:
+	template <typename Callable,
+	          typename = std::enable_if_t<!std::is_same_v<std::decay_t<Callable>, FunctionRef>>>
+	FunctionRef(Callable &&callable) noexcept
+	    : object(const_cast<void *>(static_cast<const void *>(std::addressof(callable)))),
+	      callback([](void *obj, Args... args) -> R {
+		      return (*static_cast<std::remove_reference_t<Callable> *>(obj))(
+		          std::forward<Args>(args)...);
+	      }) {}
+
+	R operator()(Args... args) const { return callback(object, std::forward<Args>(args)...); }
+
+  private:
+	void *object;
+	R (*callback)(void *, Args...);
+};
+
+#endif // FUNCTIONREF_H
@@ -0,0 +1,87 @@
+//
+// Created by Leonard Chan on 10/15/26.
+//
+
+#ifndef INCIDENCELISTS_H
+#define INCIDENCELISTS_H
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// One short list of items per row, packed into a single array like CSR, but editable in place:
+// every row keeps the capacity it was created with, items are removed by swapping with the
+// row's last item, and new rows are appended at the end. Rows can shrink but never grow past
+// their capacity, which suits incidence that only ever splits apart (e.g. springs and triangles
+// around particles of a tearing cloth).
+class IncidenceLists {
+  public:
+	// Builds the rows from (row, item) pairs given as two parallel arrays; items keep the order of
+	// the pairs within each row
+	void build(size_t rowCount, const uint32_t *rows, const uint32_t *values, size_t pairCount) {
+		offsets.assign(rowCount + 1, 0);
+		for (size_t k = 0; k < pairCount; k++) {
+			offsets[rows[k] + 1]++;
+		}
+		for (size_t r = 0; r < rowCount; r++) {
+			offsets[r + 1] += offsets[r];
+		}
+		counts.assign(rowCount, 0);
+		items.resize(offsets[rowCount]);
+		for (size_t k = 0; k < pairCount; k++) {
+			uint32_t r = rows[k];
+			items[offsets[r] + counts[r]++] = values[k];
+		}
+	}
+
+	void clear() {
+		offsets.clear();
+		counts.clear();
+		items.clear();
+	}
+
+	size_t rowCount() const { return counts.size(); }
+
+	// Appends an empty row with room for capacity items and returns its index
+	uint32_t appendRow(uint32_t capacity) {
+		if (offsets.empty())
+			offsets.push_back(0);
+		offsets.push_back(offsets.back() + capacity);
+		counts.push_back(0);
+		items.resize(offsets.back());
+		return uint32_t(counts.size() - 1);
+	}
+
+	const uint32_t *begin(uint32_t row) const { return items.data() + offsets[row]; }
+	const uint32_t *end(uint32_t row) const { return begin(row) + counts[row]; }
+	uint32_t size(uint32_t row) const { return counts[row]; }
+
+	// The row must have room left
+	void add(uint32_t row, uint32_t item) { items[offsets[row] + counts[row]++] = item; }
+
+	// Removes one occurrence of item, if present; the row's order is not kept
+	void remove(uint32_t row, uint32_t item) {
+		uint32_t *first = items.data() + offsets[row], *last = first + counts[row];
+		uint32_t *found = std::find(first, last, item);
+		if (found == last)
+			return;
+		*found = *(last - 1);
+		counts[row]--;
+	}
+
+	// Replaces one occurrence of item with replacement, if present
+	void replace(uint32_t row, uint32_t item, uint32_t replacement) {
+		uint32_t *first = items.data() + offsets[row], *last = first + counts[row];
+		uint32_t *found = std::find(first, last, item);
+		if (found != last)
+			*found = replacement;
+	}
+
+  private:
+	// Row r owns items[offsets[r], offsets[r + 1]), of which the first counts[r] are in use
+	std::vector<uint32_t> offsets;
+	std::vector<uint32_t> counts;
+	std::vector<uint32_t> items;
+};
+
+#endif // INCIDENCELISTS_H
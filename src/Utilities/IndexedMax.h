@@ -0,0 +1,47 @@
+//
+// Created by Leonard Chan on 10/15/26.
+//
+
+#ifndef INDEXEDMAX_H
+#define INDEXEDMAX_H
+
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+
+// Lock-free running maximum of non-negative values that remembers where the maximum was found,
+// for parallel reductions that only report once per chunk. Value and index share one 64-bit
+// word: non-negative floats order like their bit patterns, so a single atomic max keeps both
+// consistent. The low word holds index + 1, so that a reported 0 at index 0 is told apart from
+// no report at all. Ties go to the larger index, which makes the result independent of the
+// order in which threads report. A NaN counts as infinitely large.
+class IndexedMax {
+  public:
+	void reset() { packed.store(0, std::memory_order_relaxed); }
+
+	void update(float value, int32_t index) {
+		if (index < 0)
+			return;
+		if (std::isnan(value))
+			value = INFINITY;
+		uint64_t candidate =
+		    uint64_t(std::bit_cast<uint32_t>(std::fmax(value, 0.0f))) << 32 | (uint32_t(index) + 1);
+		uint64_t current = packed.load(std::memory_order_relaxed);
+		while (candidate > current &&
+		       !packed.compare_exchange_weak(current, candidate, std::memory_order_relaxed)) {
+		}
+	}
+
+	float value() const { return std::bit_cast<float>(uint32_t(load() >> 32)); }
+
+	// -1 until a value was reported
+	int32_t index() const { return int32_t(uint32_t(load()) - 1); }
+
+  private:
+	uint64_t load() const { return packed.load(std::memory_order_relaxed); }
+
+	std::atomic<uint64_t> packed{0};
+};
+
+#endif // INDEXEDMAX_H
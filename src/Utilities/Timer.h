@@ -5,6 +5,10 @@
 #ifndef TIMER_H
 #define TIMER_H
 
+#include <chrono>
+#include <iostream>
+#include <string>
+
 class Timer {
   public:
 	Timer() { reset(); }
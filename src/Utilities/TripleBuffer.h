@@ -0,0 +1,49 @@
+//
+// Created by Leonard Chan on 10/15/26.
+//
+
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+
+#include <atomic>
+#include <cstdint>
+
+// Lock-free single producer / single consumer handoff of the latest value. The producer fills
+// writeBuffer() and publishes it; the consumer picks up the most recent published buffer with
+// acquire(). Neither side ever waits: the producer may overwrite values the consumer never saw,
+// and the consumer keeps reading its buffer until a newer one is published.
+template <typename T>
+class TripleBuffer {
+  public:
+	// Producer side
+	T &writeBuffer() { return buffers[writeIndex]; }
+
+	void publish() {
+		uint8_t previous = middle.exchange(writeIndex | freshBit, std::memory_order_acq_rel);
+		writeIndex = previous & indexMask;
+	}
+
+	// Consumer side. Returns true if a newer buffer than the current one was taken.
+	bool acquire() {
+		if (!(middle.load(std::memory_order_relaxed) & freshBit))
+			return false;
+		uint8_t previous = middle.exchange(readIndex, std::memory_order_acq_rel);
+		readIndex = previous & indexMask;
+		return true;
+	}
+
+	const T &readBuffer() const { return buffers[readIndex]; }
+
+  private:
+	static constexpr uint8_t indexMask = 0x3;
+	static constexpr uint8_t freshBit = 0x4;
+
+	T buffers[3];
+
+	// Index of the buffer between the two sides, plus freshBit while it holds an unread value
+	std::atomic<uint8_t> middle{1};
+	uint8_t writeIndex = 0; // owned by the producer
+	uint8_t readIndex = 2;  // owned by the consumer
+};
+
+#endif // TRIPLEBUFFER_H